@@ -33,6 +33,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #define ICON_PATH "Sound.png"                                                 /**< The path to the program's icon */
  
@@ -43,6 +44,9 @@
 
 #define PID_NUM_MAXLEN 20                                                     /**< The maximal length of the running daemon's PID */
 
+#define DAEMON_START_TIMEOUT_MS 3000                                          /**< The maximal time of waiting for the started daemon in milliseconds */
+#define DAEMON_START_CHECK_MS   20                                            /**< The interval of checking the started daemon in milliseconds */
+
 #define RED_BOLD_MARKUP  "<span weight=\"bold\" color='red'>%s</span>"        /**< The gtk+ text tag for marking up a text to red color and to bold font */
 #define BLUE_BOLD_MARKUP "<span weight=\"bold\" color='blue'>%s</span>"       /**< The gtk+ text tag for marking up a text to blue color and to bold font */
 
@@ -163,7 +167,6 @@ const bool stopPrevDaemonIfRuns()
 	    if(stopDaemon)
 		{
 		    runFileInCurDir(1, (const char* []) {STOP_DAEMON_SCRIPT_NAME});
-		    sleep(1);
 		    result = !doesDirHasFile("/proc", pid);
 		}
 	    free(pid);
@@ -186,6 +189,22 @@ const bool isDaemonRunning()
     return result;
 }
 
+/**
+ * Wait until the started daemon saves its PID or the timeout DAEMON_START_TIMEOUT_MS is over
+ * @return true The daemon is running
+ */
+const bool waitForDaemonStart()
+{
+    int waited;
+    for(waited = 0; waited < DAEMON_START_TIMEOUT_MS; waited += DAEMON_START_CHECK_MS)
+	{
+	    if(isDaemonRunning())
+		return true;
+	    usleep(DAEMON_START_CHECK_MS * 1000);
+	}
+    return isDaemonRunning();
+}
+
 /**
  * Get the text string of IP for a text label
  * @param ipStr The string of the IP
@@ -231,8 +250,7 @@ void startBtDaemon()
 {
     if(runFileInCurDir(2, (const char* []){DAEMON_PROG_NAME, "bt"}))
 	{
-	    sleep(1);                    /// TODO should be fixed!!!
-	    if(isDaemonRunning())
+	    if(waitForDaemonStart())
 		{
 		    showDialog("The volume control daemon has started", GTK_MESSAGE_INFO, "Started");
 		    setDaemonStateLbl(GTK_LABEL(daemonStateLbl));
@@ -258,8 +276,7 @@ void startWifiDaemon()
 		showDialog("The given port number is EMPTY!", GTK_MESSAGE_ERROR, "ERROR");
 	    else if(runFileInCurDir(3, (const char* []){DAEMON_PROG_NAME, "wifi", portNumStr}))
 		{
-		    sleep(1);                    /// TODO should be fixed!!!
-		    if(isDaemonRunning())
+		    if(waitForDaemonStart())
 			{
 			    showDialog("The volume control daemon has started", GTK_MESSAGE_INFO, "Started");
 			    setDaemonStateLbl(GTK_LABEL(daemonStateLbl));
@@ -25,26 +25,75 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
-
 #include "Log.h"
 
 #include <errno.h>
 #include <string.h>
 #include <time.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/eventfd.h>
 
 #include <pthread.h>
 
 #define ERR -1                               /**< the code of an error */
 
-FILE *logFile = NULL;                        /**< Pointer to the log file */
-
 #define LOG_FILE_NAME_LEN 100                /**< \def The maximal length of the log file name */
 char fileName[LOG_FILE_NAME_LEN] = {'\0'};   /**< The log file's name string array */
 
-pthread_mutex_t mutex;                       /**< The mutex for concurrent writing to the same log file by different threads */
+#define LOG_RECORD_LEN 256                   /**< \def The maximal length of a record, the longer records are truncated */
+#define LOG_RECORDS_NUM 1024                 /**< \def The number of the records the queue can hold */
+#define LOG_BATCH_LEN (16 * 1024)            /**< \def The maximal number of bytes written to the file at once */
+#define DATE_LEN 32                          /**< \def The length of the date string buffer */
+
+/**
+ * \struct LogRecord
+ * \brief The formatted record waiting for writing to the log file
+ */
+struct LogRecord
+{
+    atomic_size_t seq;                       /**< The position of the queue the record slot is ready for */
+    size_t len;                              /**< The length of the record's text */
+    char txt[LOG_RECORD_LEN];                /**< The text of the record */
+};
+
+struct LogRecord records[LOG_RECORDS_NUM];   /**< The lock free queue of the records with many writers and the single reader */
+atomic_size_t enqueuePos;                    /**< The position of the next record pushed into the queue */
+size_t dequeuePos = 0;                       /**< The position of the next record popped from the queue. Used by the writer thread only */
+atomic_size_t droppedNum;                    /**< The number of the records dropped because the queue has been full */
+
+int logDescr = ERR;                          /**< The descriptor of the log file */
+atomic_long curSize;                         /**< The current size of the log */
+
+atomic_long maxLogSize = MAX_LOG_FILE_LEN;               /**< The size the log file is rotated at */
+atomic_int generationsNum = LOG_GENERATIONS_NUM;         /**< The number of the rotated log files kept */
+
+pthread_t writerThread;                      /**< The thread writing the records to the log file */
+atomic_bool writerRunning;                   /**< Is the writer thread running */
+atomic_bool writerStopping;                  /**< Should the writer thread stop */
+atomic_bool writerSleeping;                  /**< Is the writer thread waiting for the records */
+int writerEvent = ERR;                       /**< The event waking up the writer thread */
+
+pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;          /**< The mutex for opening and closing the log file */
+
+pthread_mutex_t flushMutex = PTHREAD_MUTEX_INITIALIZER;     /**< The mutex of the position of the written records */
+pthread_cond_t flushedCond = PTHREAD_COND_INITIALIZER;      /**< Signaled when the records have been written */
+size_t writtenPos = 0;                                      /**< The position of the next record should be written */
+
+__thread char threadBuff[LOG_RECORD_LEN];    /**< The buffer for formatting a record by the current thread */
+__thread time_t threadDateTime = -1;         /**< The time of the date string cached by the current thread */
+__thread char threadDate[DATE_LEN];          /**< The date string cached by the current thread */
 
-long curSize = 0;                            /**< The current size of the log */
+bool isAtExitSet = false;                    /**< Has the closing of the log at the process exit been set */
+
+atomic_int logLevel = LOG_COMPILED_LEVEL;       /**< The current level of the log */
+
+const char* levelsNames[] = { "trace", "debug", "info", "warn", "error" };   /**< The names of the levels indexed by the levels */
+#define LEVELS_NUM (sizeof(levelsNames) / sizeof(levelsNames[0]))           /**< \def The number of the levels */
 
 /**
  * Change the name of the currently opened log file
@@ -55,14 +104,254 @@ void chgLogFileName(const char *name)
     if( (name != fileName) && (strcmp(name, fileName) != 0) )
 	{
 	    bzero(fileName, LOG_FILE_NAME_LEN);
-	    strcpy(fileName, name);
+	    strncpy(fileName, name, LOG_FILE_NAME_LEN - 1);
 	}
 }
 
+/**
+ * Wake up the writer thread if it waits for the records
+ */
+static void wakeWriter()
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load_explicit(&writerSleeping, memory_order_relaxed) && atomic_exchange(&writerSleeping, false))
+	{
+	    const uint64_t one = 1;
+	    if(write(writerEvent, &one, sizeof(one)) != sizeof(one))
+		return;
+	}
+}
+
+/**
+ * Push the given text into the queue of the records
+ * @param txt The text of the record
+ * @param len The length of the text
+ * @return false The queue is full, the record has been dropped
+ */
+static bool pushLogRecord(const char *txt, const size_t len)
+{
+    struct LogRecord *record;
+    size_t pos = atomic_load_explicit(&enqueuePos, memory_order_relaxed);
+    for(;;)
+	{
+	    record = &records[pos % LOG_RECORDS_NUM];
+	    const intptr_t diff = (intptr_t)atomic_load_explicit(&record->seq, memory_order_acquire) - (intptr_t)pos;
+	    if(diff == 0)
+		{
+		    if(atomic_compare_exchange_weak_explicit(&enqueuePos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+			break;
+		}
+	    else if(diff < 0)
+		{
+		    atomic_fetch_add_explicit(&droppedNum, 1, memory_order_relaxed);
+		    return false;
+		}
+	    else
+		pos = atomic_load_explicit(&enqueuePos, memory_order_relaxed);
+	}
+
+    memcpy(record->txt, txt, len);
+    record->len = len;
+    atomic_store_explicit(&record->seq, pos + 1, memory_order_release);
+
+    wakeWriter();
+    return true;
+}
+
+/**
+ * Get the next record of the queue if it's ready. Should be called by the writer thread only
+ * @return The record or NULL
+ */
+static struct LogRecord* frontLogRecord()
+{
+    struct LogRecord *record = &records[dequeuePos % LOG_RECORDS_NUM];
+    if(atomic_load_explicit(&record->seq, memory_order_acquire) != dequeuePos + 1)
+	return NULL;
+    return record;
+}
+
+/**
+ * Release the slot of the record got by frontLogRecord()
+ * @param record The record
+ */
+static void popLogRecord(struct LogRecord *record)
+{
+    atomic_store_explicit(&record->seq, dequeuePos + LOG_RECORDS_NUM, memory_order_release);
+    ++dequeuePos;
+}
+
+/**
+ * Get the name of the given generation of the rotated log file
+ * @param name The buffer for the name
+ * @param len The length of the buffer
+ * @param generation The number of the generation
+ */
+static void getGenerationName(char *name, const size_t len, const int generation)
+{
+    snprintf(name, len, "%s.%d", fileName, generation);
+}
+
+/**
+ * Rotate the log file: the log file becomes the generation 1, the generation N becomes N + 1,
+ * the oldest one is removed. Should be called by the writer thread only
+ */
+static void rotateLogFile()
+{
+    const int generations = atomic_load(&generationsNum);
+    if(generations <= 0)
+	{
+	    clearLogFile();
+	    return;
+	}
+
+    char oldName[LOG_FILE_NAME_LEN + 16];
+    char newName[LOG_FILE_NAME_LEN + 16];
+    int generation;
+    for(generation = generations - 1; generation > 0; --generation)
+	{
+	    getGenerationName(oldName, sizeof(oldName), generation);
+	    getGenerationName(newName, sizeof(newName), generation + 1);
+	    rename(oldName, newName);
+	}
+
+    getGenerationName(newName, sizeof(newName), 1);
+    if(rename(fileName, newName) != 0)
+	{
+	    printf("ERROR: can't rotate the log file %s", fileName);
+	    perror("");
+	    clearLogFile();
+	    return;
+	}
+
+    const int newDescr = open(fileName, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if(newDescr == ERR)
+	{
+	    printf("ERROR: can't open the log file '%s' after rotating\n", fileName);
+	    perror("");
+	    return;
+	}
+    close(logDescr);
+    logDescr = newDescr;
+    atomic_store(&curSize, 0);
+}
+
+/**
+ * Write the given buffer to the log file. The file is rotated when it has the maximal size
+ * @param buff The buffer
+ * @param len The length of the buffer
+ */
+static void writeBatch(const char *buff, const size_t len)
+{
+    if(len == 0)
+	return;
+
+    if(atomic_load(&curSize) >= atomic_load(&maxLogSize))
+	rotateLogFile();
+
+    if(write(logDescr, buff, len) != (ssize_t)len)
+	{
+	    printf("ERROR: all the given text hasn't written to the log file '%s'\n", fileName);
+	    perror("");
+	}
+    atomic_fetch_add(&curSize, len);
+}
+
+/**
+ * Write all the records waiting in the queue by batches
+ */
+static void writeRecords()
+{
+    static char batch[LOG_BATCH_LEN];
+    size_t batchLen = 0;
+
+    const size_t dropped = atomic_exchange(&droppedNum, 0);
+    if(dropped != 0)
+	batchLen = snprintf(batch, LOG_BATCH_LEN, "%.24s:Log: %zu records have been dropped\n", getCurDate(), dropped);
+
+    struct LogRecord *record;
+    while((record = frontLogRecord()) != NULL)
+	{
+	    if(batchLen + record->len > LOG_BATCH_LEN)
+		{
+		    writeBatch(batch, batchLen);
+		    batchLen = 0;
+		}
+	    memcpy(batch + batchLen, record->txt, record->len);
+	    batchLen += record->len;
+	    popLogRecord(record);
+	}
+    writeBatch(batch, batchLen);
+
+    pthread_mutex_lock(&flushMutex);
+    writtenPos = dequeuePos;
+    pthread_cond_broadcast(&flushedCond);
+    pthread_mutex_unlock(&flushMutex);
+}
+
+/**
+ * The function of the writer thread. Waits for the records and writes them to the log file
+ * @param arg Not used
+ * @return NULL
+ */
+static void* runWriter(void *arg)
+{
+    while(!atomic_load(&writerStopping))
+	{
+	    writeRecords();
+
+	    atomic_store(&writerSleeping, true);
+	    atomic_thread_fence(memory_order_seq_cst);
+	    if( (frontLogRecord() != NULL) || (atomic_load(&droppedNum) != 0) || atomic_load(&writerStopping) )
+		{
+		    atomic_store(&writerSleeping, false);
+		    continue;
+		}
+
+	    uint64_t counter;
+	    if( (read(writerEvent, &counter, sizeof(counter)) == ERR) && (errno != EINTR) )
+		break;
+	    atomic_store(&writerSleeping, false);
+	}
+    writeRecords();
+    return NULL;
+}
+
+/**
+ * Stop the writer thread after writing all the waiting records and close the log file.
+ * Should be called with locked mutex
+ */
+static void stopWriter()
+{
+    if(!atomic_load(&writerRunning))
+	return;
+
+    atomic_store(&writerStopping, true);
+    const uint64_t one = 1;
+    if(write(writerEvent, &one, sizeof(one)) != sizeof(one))
+	perror("");
+    pthread_join(writerThread, NULL);
+
+    atomic_store(&writerRunning, false);
+    close(writerEvent);
+    writerEvent = ERR;
+    close(logDescr);
+    logDescr = ERR;
+}
+
+/**
+ * Close the log file at the exit of the process
+ */
+static void closeLogAtExit()
+{
+    pthread_mutex_lock(&mutex);
+    stopWriter();
+    pthread_mutex_unlock(&mutex);
+}
 
 /**
  * Open the log file with the given name.
- * The give name will be saved in the global value fileName 
+ * The give name will be saved in the global value fileName.
+ * The records are written by the thread running while the file is open
  * @param name The name of the log file
  */
 void openLogFile(const char *name)
@@ -78,51 +367,116 @@ void openLogFile(const char *name)
 	    return;
 	}
 
+    pthread_mutex_lock(&mutex);
+    if(atomic_load(&writerRunning) && (strcmp(name, fileName) == 0))
+	{
+	    pthread_mutex_unlock(&mutex);
+	    return;
+	}
+    stopWriter();
+
     chgLogFileName(name);
-    
-    logFile = fopen(fileName, "a+");
-    if(logFile == NULL)
+
+    logDescr = open(fileName, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if(logDescr == ERR)
 	{
 	    printf("ERROR: can't open the log file '%s'\n", fileName);
 	    perror("");
+	    pthread_mutex_unlock(&mutex);
+	    return;
+	}
+    atomic_store(&curSize, lseek(logDescr, 0L, SEEK_END));
+
+    if(atomic_load(&enqueuePos) == 0)
+	{
+	    size_t i;
+	    for(i = 0; i < LOG_RECORDS_NUM; ++i)
+		atomic_init(&records[i].seq, i);
+	}
+
+    writerEvent = eventfd(0, EFD_CLOEXEC);
+    atomic_store(&writerStopping, false);
+    atomic_store(&writerSleeping, false);
+    if( (writerEvent == ERR) || (pthread_create(&writerThread, NULL, runWriter, NULL) != 0) )
+	{
+	    printf("ERROR: can't run the thread writing to the log file '%s'\n", fileName);
+	    perror("");
+	    if(writerEvent != ERR)
+		close(writerEvent);
+	    writerEvent = ERR;
+	    close(logDescr);
+	    logDescr = ERR;
+	    pthread_mutex_unlock(&mutex);
+	    return;
 	}
+    atomic_store(&writerRunning, true);
+
+    if(!isAtExitSet)
+	isAtExitSet = (atexit(closeLogAtExit) == 0);
 
-    fseek(logFile, 0L, SEEK_END);
-    curSize = ftell(logFile);
-    
-    pthread_mutex_init(&mutex, NULL);
+    pthread_mutex_unlock(&mutex);
 }
 
 
 /**
- * Close the log file if it has been opened before
+ * Close the log file if it has been opened before.
+ * All the records waiting for writing are written before closing
  */
 void closeLogFile()
 {
-    pthread_mutex_destroy(&mutex);
-
-    if(logFile == NULL)
+    pthread_mutex_lock(&mutex);
+    if(!atomic_load(&writerRunning))
 	{
-	    printf("ERROR: can't close the log file %s, the stream pointer to one is NULL\n", fileName);
+	    printf("ERROR: can't close the log file %s, it hasn't been opened\n", fileName);
+	    pthread_mutex_unlock(&mutex);
 	    return;
 	}
-    
-    if(fclose(logFile) == EOF)
+    stopWriter();
+    pthread_mutex_unlock(&mutex);
+}
+
+/**
+ * Wait until all the records written to the log before the call are in the log file
+ */
+void flushLog()
+{
+    if(!atomic_load(&writerRunning))
+	return;
+
+    const size_t pos = atomic_load(&enqueuePos);
+    pthread_mutex_lock(&flushMutex);
+    while( (writtenPos < pos) && atomic_load(&writerRunning) )
 	{
-	    printf("ERROR: can't close the log file '%s'\n", fileName);
-    	    perror("");
+	    struct timespec deadline;
+	    clock_gettime(CLOCK_REALTIME, &deadline);
+	    deadline.tv_nsec += 10 * 1000 * 1000;
+	    if(deadline.tv_nsec >= 1000 * 1000 * 1000)
+		{
+		    deadline.tv_nsec -= 1000 * 1000 * 1000;
+		    ++deadline.tv_sec;
+		}
+	    pthread_cond_timedwait(&flushedCond, &flushMutex, &deadline);
 	}
-    logFile = NULL;
+    pthread_mutex_unlock(&flushMutex);
 }
 
 /**
- * Get current date string pointer
+ * Get current date string pointer.
+ * The string is formatted once a second by each thread
  * @return The pointer to the string of current date
  */
 const char* getCurDate()
 {
-    const time_t curTime = time(NULL);
-    return ctime(&curTime);
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    if(now.tv_sec != threadDateTime)
+	{
+	    struct tm date;
+	    localtime_r(&now.tv_sec, &date);
+	    strftime(threadDate, DATE_LEN, "%a %b %e %H:%M:%S %Y\n", &date);
+	    threadDateTime = now.tv_sec;
+	}
+    return threadDate;
 }
 
 /**
@@ -150,24 +504,58 @@ char* addDateToTxt(const char* txt, const char *tag)
 }
 
 /**
- * Write the given text and tag to log file
+ * Append the given string to the record formatted in the buffer of the current thread
+ * @param len The current length of the record
+ * @param str The string
+ * @return The new length of the record
+ */
+static size_t appendToRecord(size_t len, const char *str)
+{
+    while( (*str != '\0') && (len < LOG_RECORD_LEN) )
+	threadBuff[len++] = *str++;
+    return len;
+}
+
+/**
+ * Format the record of the given parts and tag and push it into the queue of the records.
+ * The log file is opened if it hasn't been opened before
+ * @param parts The strings of the record's text
+ * @param partsNum The number of the strings
+ * @param tag The tag
+ * @param addEOL Should the end of line be added if the text doesn't have one
+ */
+static void addRecord(const char *parts[], const size_t partsNum, const char *tag, const bool addEOL)
+{
+    if(!atomic_load_explicit(&writerRunning, memory_order_acquire))
+	openLogFile((fileName[0] != '\0') ? fileName : LOG_FILE_NAME);
+
+    const char *date = getCurDate();
+    size_t len = strlen(date) - 1;
+    memcpy(threadBuff, date, len);
+    threadBuff[len++] = ':';
+    len = appendToRecord(len, tag);
+    len = appendToRecord(len, ": ");
+
+    size_t i;
+    for(i = 0; i < partsNum; ++i)
+	len = appendToRecord(len, parts[i]);
+
+    if(len == LOG_RECORD_LEN)
+	threadBuff[len - 1] = '\n';
+    else if(addEOL && (threadBuff[len - 1] != '\n'))
+	threadBuff[len++] = '\n';
+
+    pushLogRecord(threadBuff, len);
+}
+
+/**
+ * Write the given text and tag to log file.
+ * The text is formatted by the calling thread and written by the writer thread
  * @param txt The text for writing
  * @param tag The tag
  */
 void writeToLog(const char *txt, const char *tag)
 {    
-    pthread_mutex_lock (&mutex);
-
-    //    if(logFile == NULL)
-    //	{
-    //	    printf("ERROR: can't write to the log file %s, the stream pointer to one is NULL\n", fileName);
-    //	    return;
-    //	}
-    openLogFile(LOG_FILE_NAME);
-    
-    if(curSize >= MAX_LOG_FILE_LEN)
-	clearLogFile();
-
     if(txt == NULL)
 	{
 	    printf("ERROR: the given text for writing to the log file %s is NULL\n", fileName);
@@ -186,21 +574,8 @@ void writeToLog(const char *txt, const char *tag)
     if(strlen(tag) == 0)
 	return;
 
-    fflush(logFile);
-    
-    char* txtWithDate = addDateToTxt(txt, tag);
-    size_t len = strlen(txtWithDate);
-    if(fwrite(txtWithDate, sizeof(char), len, logFile) != len)
-	{
-	    printf("ERROR: all the given text hasn't written to the log file '%s'\n", fileName);
-	    perror("");
-	}
-    free(txtWithDate);
-    curSize += len;
-
-    closeLogFile(LOG_FILE_NAME);
-    
-    pthread_mutex_unlock(&mutex);
+    const char *parts[] = { txt };
+    addRecord(parts, 1, tag, false);
 }
 
 /**
@@ -221,15 +596,11 @@ void writeToLog2(const char *txt1, const char *txt2, const char *tag)
 	    printf("ERROR: the given 2nd part of the text for writing to the log file %s is NULL\n", fileName);
 	    return;
 	}
-    size_t len = strlen(txt1) + strlen(txt2) + 2;
-    char *str = (char*) malloc(len);
-    bzero(str, len);
-    str = strcpy(str, txt1);
-    str = strcat(str, txt2);
-    if(txt2[strlen(txt2) - 1] != '\n')
-	str[len-2] = '\n'; 
-    writeToLog(str, tag);
-    free(str);
+    if( (tag == NULL) || (strlen(tag) == 0) )
+	return;
+
+    const char *parts[] = { txt1, txt2 };
+    addRecord(parts, 2, tag, true);
 }
 
 /**
@@ -237,21 +608,19 @@ void writeToLog2(const char *txt1, const char *txt2, const char *tag)
  */
 void clearLogFile()
 {
-    if(logFile == NULL)
+    if(logDescr == ERR)
 	{
-	    printf("ERROR: can't clear the log file %s, the stream pointer to one is NULL\n", fileName);
+	    printf("ERROR: can't clear the log file %s, it hasn't been opened\n", fileName);
 	    return;
 	}
-    closeLogFile();
 
-    if(remove(fileName) != 0)
+    if(ftruncate(logDescr, 0) != 0)
     	{
-    	    printf("ERROR: can't remove the log file %s", fileName);
+    	    printf("ERROR: can't clear the log file %s", fileName);
     	    perror("");
     	    return;
     	}
-    
-    openLogFile(fileName);
+    atomic_store(&curSize, 0);
 }
 
 
@@ -266,25 +635,88 @@ void writeToLogIfError(const int result, const char *funcName, const char *error
 {
     if (result == ERR)
     {
-	#define ERRSTR "ERROR: "
-	#define STR "(): "
-    	size_t len = strlen(ERRSTR) + strlen(funcName) + strlen(STR) + strlen(errorStr) + 2;
-    	char *str = (char*) calloc(sizeof(char), len);
-    	strcat(str, ERRSTR);
-    	strcat(str, funcName);
-	strcat(str, STR);
-    	strcat(str, errorStr);
-	strcat(str, "\n");
-        writeToLog(str, TAG);
-	free(str);
+	const char *parts[] = { "ERROR: ", funcName, "(): ", errorStr, "\n" };
+	addRecord(parts, 5, TAG, false);
     }
 }
 
 /**
- * Get the size of the log file in bytes
+ * Set the rotation of the log file. The rotation is done by the writer thread
+ * @param maxSize The maximal size of the log file in bytes
+ * @param generations The number of the rotated files kept. The log file is cleared instead of rotating if it's 0
+ */
+void setLogRotation(const long maxSize, const int generations)
+{
+    if( (maxSize <= 0) || (generations < 0) )
+	{
+	    printf("ERROR: the given log rotation size %ld or number of files %d is invalid\n", maxSize, generations);
+	    return;
+	}
+    atomic_store(&maxLogSize, maxSize);
+    atomic_store(&generationsNum, generations);
+}
+
+/**
+ * Set the current level of the log. The messages of the lower levels aren't written
+ * @param level The level: LOG_LEVEL_TRACE ... LOG_LEVEL_ERROR
+ */
+void setLogLevel(const int level)
+{
+    if( (level < LOG_LEVEL_TRACE) || (level > LOG_LEVEL_ERROR) )
+	{
+	    printf("ERROR: the given log level %d is invalid\n", level);
+	    return;
+	}
+    atomic_store_explicit(&logLevel, level, memory_order_relaxed);
+}
+
+/**
+ * Get the current level of the log
+ * @return The level
+ */
+int getLogLevel()
+{
+    return atomic_load_explicit(&logLevel, memory_order_relaxed);
+}
+
+/**
+ * Get the level of the log by its name
+ * @param name The name of the level: trace, debug, info, warn or error
+ * @return The level or -1 if there is no level with the given name
+ */
+int getLogLevelByName(const char *name)
+{
+    if(name == NULL)
+	return ERR;
+
+    size_t level;
+    for(level = 0; level < LEVELS_NUM; ++level)
+	{
+	    if(strcmp(name, levelsNames[level]) == 0)
+		return level;
+	}
+    return ERR;
+}
+
+/**
+ * Get the name of the given level of the log
+ * @param level The level
+ * @return The name of the level or NULL if the level is invalid
+ */
+const char* getLogLevelName(const int level)
+{
+    if( (level < LOG_LEVEL_TRACE) || (level > LOG_LEVEL_ERROR) )
+	return NULL;
+    return levelsNames[level];
+}
+
+/**
+ * Get the size of the log file in bytes.
+ * Waits until the records written to the log before are in the file
  * @return The size of the log file in bytes
  */
 long getLogSizeBytes()
 {
-    return curSize;
+    flushLog();
+    return atomic_load(&curSize);
 }
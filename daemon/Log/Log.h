@@ -31,26 +31,101 @@
 #include <stdio.h>
 
 /**
- * The maximal number of lines within the log file.
- * When the file has the maximal length it will be cleared
+ * The default maximal size of the log file in bytes.
+ * When the file has the maximal size it will be rotated
  */
-#define MAX_LOG_FILE_LEN 10000
+#define MAX_LOG_FILE_LEN (1024 * 1024)
+
+/**
+ * The default number of the rotated log files kept as LOG_FILE_NAME.1 ... LOG_FILE_NAME.N,
+ * the first one is the newest
+ */
+#define LOG_GENERATIONS_NUM 5
 
 #define LOG_FILE_NAME "log.txt"                      /**< the name of the file for writing logs info */
 
+#define LOG_LEVEL_TRACE 0                            /**< The level of the messages of every data passing the daemon */
+#define LOG_LEVEL_DEBUG 1                            /**< The level of the messages of every executed command */
+#define LOG_LEVEL_INFO  2                            /**< The level of the messages of the connections' state */
+#define LOG_LEVEL_WARN  3                            /**< The level of the warnings */
+#define LOG_LEVEL_ERROR 4                            /**< The level of the errors */
+
+/**
+ * The lowest level of the messages compiled in. The messages of the lower levels are compiled out.
+ * The release builds(NDEBUG) compile out the trace and debug messages
+ */
+#ifndef LOG_COMPILED_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILED_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_COMPILED_LEVEL LOG_LEVEL_TRACE
+#endif
+#endif
+
+/**
+ * Write to the log by the given call if the given level is compiled in and isn't lower than the current level.
+ * The arguments of the call aren't evaluated otherwise
+ */
+#define LOG_AT(level, call) do { if( ((level) >= LOG_COMPILED_LEVEL) && ((level) >= getLogLevel()) ) call; } while(0)
+
+#define LOG_TRACE(txt, tag)         LOG_AT(LOG_LEVEL_TRACE, writeToLog(txt, tag))          /**< Write the trace message */
+#define LOG_TRACE2(txt1, txt2, tag) LOG_AT(LOG_LEVEL_TRACE, writeToLog2(txt1, txt2, tag))  /**< Write the trace message of two texts */
+#define LOG_DEBUG(txt, tag)         LOG_AT(LOG_LEVEL_DEBUG, writeToLog(txt, tag))          /**< Write the debug message */
+#define LOG_DEBUG2(txt1, txt2, tag) LOG_AT(LOG_LEVEL_DEBUG, writeToLog2(txt1, txt2, tag))  /**< Write the debug message of two texts */
+#define LOG_INFO(txt, tag)          LOG_AT(LOG_LEVEL_INFO, writeToLog(txt, tag))           /**< Write the info message */
+#define LOG_INFO2(txt1, txt2, tag)  LOG_AT(LOG_LEVEL_INFO, writeToLog2(txt1, txt2, tag))   /**< Write the info message of two texts */
+#define LOG_WARN(txt, tag)          LOG_AT(LOG_LEVEL_WARN, writeToLog(txt, tag))           /**< Write the warning */
+#define LOG_WARN2(txt1, txt2, tag)  LOG_AT(LOG_LEVEL_WARN, writeToLog2(txt1, txt2, tag))   /**< Write the warning of two texts */
+#define LOG_ERROR(txt, tag)         LOG_AT(LOG_LEVEL_ERROR, writeToLog(txt, tag))          /**< Write the error */
+#define LOG_ERROR2(txt1, txt2, tag) LOG_AT(LOG_LEVEL_ERROR, writeToLog2(txt1, txt2, tag))  /**< Write the error of two texts */
+
+/**
+ * Set the current level of the log. The messages of the lower levels aren't written
+ * @param level The level: LOG_LEVEL_TRACE ... LOG_LEVEL_ERROR
+ */
+void setLogLevel(const int level);
+
 /**
- * Open the log file with the given name
+ * Get the current level of the log
+ * @return The level
+ */
+int getLogLevel();
+
+/**
+ * Get the level of the log by its name
+ * @param name The name of the level: trace, debug, info, warn or error
+ * @return The level or -1 if there is no level with the given name
+ */
+int getLogLevelByName(const char *name);
+
+/**
+ * Get the name of the given level of the log
+ * @param level The level
+ * @return The name of the level or NULL if the level is invalid
+ */
+const char* getLogLevelName(const int level);
+
+/**
+ * Open the log file with the given name.
+ * The records are written by the thread running while the file is open
  * @param name The name of the file
  */
 void openLogFile(const char *name);
 
 /**
- * Close the log file
+ * Close the log file. All the records waiting for writing are written before closing
  */
 void closeLogFile();
 
 /**
- * Write the given text to the log file with the given tag
+ * Wait until all the records written to the log before the call are in the log file
+ */
+void flushLog();
+
+/**
+ * Write the given text to the log file with the given tag regardless of the current level.
+ * The text is formatted by the calling thread and written by the writer thread.
+ * The log file is opened if it hasn't been opened before
  * @param txt The text for adding to the log
  * @param tag The tag of the text
  */
@@ -70,6 +145,13 @@ void writeToLog2(const char *txt1, const char *txt2, const char *tag);
  */
 void clearLogFile();
 
+/**
+ * Set the rotation of the log file. The rotation is done by the writer thread
+ * @param maxSize The maximal size of the log file in bytes
+ * @param generations The number of the rotated files kept. The log file is cleared instead of rotating if it's 0
+ */
+void setLogRotation(const long maxSize, const int generations);
+
 /**
  * Write error string to the log file
  * @param result The result index, if result is error then the given error string should be written to the log file
@@ -80,7 +162,8 @@ void clearLogFile();
 void writeToLogIfError(const int result, const char *funcName, const char *errorStr, const char *TAG);
 
 /**
- * Get log file's size in bytes
+ * Get log file's size in bytes.
+ * Waits until the records written to the log before are in the file
  */
 long getLogSizeBytes();
 
@@ -0,0 +1,394 @@
+/**
+ * @file
+ * The tracing of the requests passing the daemon's threads
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/syscall.h>
+
+#include <pthread.h>
+
+#define PHASE_COMPLETE 'X'                   /**< The phase of the Chrome trace event having the duration */
+#define PHASE_INSTANT  'i'                   /**< The phase of the Chrome trace event without the duration */
+
+/**
+ * \struct TraceEvent
+ * \brief The recorded span or instant event. It's read by the dumping thread while the owner thread may overwrite it,
+ * so the sequence number is changed before and after the writing of the fields
+ */
+struct TraceEvent
+{
+    atomic_size_t seq;                       /**< The position of the ring the event has been written for, 0 while it's being written */
+    const char *name;                        /**< The name of the event */
+    int connId;                              /**< The ID of the connection */
+    int reqId;                               /**< The ID of the request */
+    uint64_t start;                          /**< The start time in microseconds */
+    uint64_t duration;                       /**< The duration in microseconds */
+    char phase;                              /**< PHASE_COMPLETE or PHASE_INSTANT */
+};
+
+/**
+ * \struct TraceRing
+ * \brief The last events of a thread. It's written by its thread only
+ */
+struct TraceRing
+{
+    char threadName[TRACE_THREAD_NAME_LEN];  /**< The name of the thread */
+    atomic_long threadId;                    /**< The system ID of the thread */
+    atomic_bool isExited;                    /**< Has the thread exited, then the ring may be taken by a new thread with the same name */
+    atomic_size_t pos;                       /**< The number of the events written to the ring */
+    struct TraceEvent events[TRACE_RING_LEN];   /**< The events */
+};
+
+struct TraceRing *rings[MAX_TRACE_THREADS_NUM];   /**< The rings of the traced threads, they are kept after the threads' exit */
+atomic_size_t ringsNum;                      /**< The number of the rings */
+pthread_mutex_t ringsMutex = PTHREAD_MUTEX_INITIALIZER;   /**< The mutex of adding and taking the rings */
+pthread_key_t ringKey;                       /**< The key of the thread's ring, its destructor marks the ring of the exited thread */
+pthread_once_t ringKeyOnce = PTHREAD_ONCE_INIT;   /**< The creation of the ring's key */
+
+atomic_bool traceEnabled;                    /**< Is the tracing enabled */
+
+__thread struct TraceRing *threadRing = NULL;    /**< The ring of the current thread */
+__thread bool isThreadRingFailed = false;        /**< The ring of the current thread can't be added */
+__thread int requestConnId = -1;                /**< The ID of the connection of the request executed by the current thread */
+__thread int requestReqId = -1;                 /**< The ID of the request executed by the current thread */
+
+/**
+ * Enable or disable the tracing. The tracing is disabled by default
+ * @param enabled Should the spans be recorded
+ */
+void setTraceEnabled(const bool enabled)
+{
+    atomic_store_explicit(&traceEnabled, enabled, memory_order_relaxed);
+}
+
+/**
+ * Is the tracing enabled
+ * @return true The spans are recorded
+ */
+bool isTraceEnabled()
+{
+    return atomic_load_explicit(&traceEnabled, memory_order_relaxed);
+}
+
+/**
+ * Get the time of the monotonic clock the spans are measured by
+ * @return The time in microseconds
+ */
+uint64_t getTraceTime()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * Mark the ring of the exited thread
+ * @param ring The ring
+ */
+static void releaseThreadRing(void *ring)
+{
+    atomic_store_explicit(&((struct TraceRing*) ring)->isExited, true, memory_order_release);
+}
+
+/**
+ * Create the key of the thread's ring
+ */
+static void createRingKey()
+{
+    pthread_key_create(&ringKey, releaseThreadRing);
+}
+
+/**
+ * Take the ring of an exited thread with the given name.
+ * Should be called while the rings' mutex is locked
+ * @param name The name of the thread
+ * @return The ring or NULL if there is no such one
+ */
+static struct TraceRing* takeExitedRing(const char *name)
+{
+    const size_t num = atomic_load_explicit(&ringsNum, memory_order_relaxed);
+    size_t i;
+    for(i = 0; i < num; i++)
+	{
+	    if(atomic_load_explicit(&rings[i]->isExited, memory_order_acquire) &&
+	       (strncmp(rings[i]->threadName, name, TRACE_THREAD_NAME_LEN - 1) == 0))
+		{
+		    atomic_store_explicit(&rings[i]->isExited, false, memory_order_relaxed);
+		    return rings[i];
+		}
+	}
+    return NULL;
+}
+
+/**
+ * Get the ring of the current thread, it's added at the first call.
+ * The ring of an exited thread with the same name is taken if there is one,
+ * then the restarted threads are traced after the rings' number has reached MAX_TRACE_THREADS_NUM
+ * @param name The name of the thread or NULL if it's unknown
+ * @return The ring or NULL if there is no place for it
+ */
+static struct TraceRing* getNamedThreadRing(const char *name)
+{
+    if( (threadRing != NULL) || isThreadRingFailed )
+	return threadRing;
+
+    pthread_once(&ringKeyOnce, createRingKey);
+    const long threadId = syscall(SYS_gettid);
+
+    pthread_mutex_lock(&ringsMutex);
+    struct TraceRing *ring = (name != NULL) ? takeExitedRing(name): NULL;
+    if(ring != NULL)
+	{
+	    atomic_store_explicit(&ring->threadId, threadId, memory_order_relaxed);
+	    threadRing = ring;
+	}
+    pthread_mutex_unlock(&ringsMutex);
+
+    if(threadRing == NULL)
+	{
+	    ring = calloc(1, sizeof(struct TraceRing));
+	    if(ring == NULL)
+		{
+		    isThreadRingFailed = true;
+		    return NULL;
+		}
+	    atomic_store_explicit(&ring->threadId, threadId, memory_order_relaxed);
+	    snprintf(ring->threadName, TRACE_THREAD_NAME_LEN, "%ld", threadId);
+
+	    pthread_mutex_lock(&ringsMutex);
+	    const size_t num = atomic_load_explicit(&ringsNum, memory_order_relaxed);
+	    if(num < MAX_TRACE_THREADS_NUM)
+		{
+		    rings[num] = ring;
+		    atomic_store_explicit(&ringsNum, num + 1, memory_order_release);
+		    threadRing = ring;
+		}
+	    pthread_mutex_unlock(&ringsMutex);
+
+	    if(threadRing == NULL)
+		{
+		    free(ring);
+		    isThreadRingFailed = true;
+		    return NULL;
+		}
+	}
+    pthread_setspecific(ringKey, threadRing);
+    return threadRing;
+}
+
+/**
+ * Get the ring of the current thread, it's added at the first call
+ * @return The ring or NULL if there is no place for it
+ */
+static struct TraceRing* getThreadRing()
+{
+    return getNamedThreadRing(NULL);
+}
+
+/**
+ * Set the name of the current thread in the dumped traces.
+ * If it's called before the first event of the thread, the ring of an exited thread with the same name is reused
+ * @param name The name
+ */
+void setTraceThreadName(const char *name)
+{
+    struct TraceRing *ring = getNamedThreadRing(name);
+    if(ring == NULL)
+	return;
+    pthread_mutex_lock(&ringsMutex);
+    strncpy(ring->threadName, name, TRACE_THREAD_NAME_LEN - 1);
+    ring->threadName[TRACE_THREAD_NAME_LEN - 1] = '\0';
+    pthread_mutex_unlock(&ringsMutex);
+}
+
+/**
+ * Write the event to the ring of the current thread
+ * @param name The name of the event
+ * @param connId The ID of the connection
+ * @param reqId The ID of the request
+ * @param start The start time
+ * @param duration The duration
+ * @param phase PHASE_COMPLETE or PHASE_INSTANT
+ */
+static void recordTraceEvent(const char *name, const int connId, const int reqId, const uint64_t start, const uint64_t duration, const char phase)
+{
+    struct TraceRing *ring = getThreadRing();
+    if(ring == NULL)
+	return;
+
+    const size_t pos = atomic_load_explicit(&ring->pos, memory_order_relaxed);
+    struct TraceEvent *event = &ring->events[pos % TRACE_RING_LEN];
+    atomic_store_explicit(&event->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    event->name     = name;
+    event->connId   = connId;
+    event->reqId    = reqId;
+    event->start    = start;
+    event->duration = duration;
+    event->phase    = phase;
+    atomic_store_explicit(&event->seq, pos + 1, memory_order_release);
+    atomic_store_explicit(&ring->pos, pos + 1, memory_order_release);
+}
+
+/**
+ * Record the span of the request's hop which has finished now.
+ * Nothing is recorded if the tracing is disabled or the span has started while it has been disabled
+ * @param name The name of the hop, it should be a constant string
+ * @param connId The ID of the connection the request has arrived from
+ * @param reqId The ID of the request or NO_REQUEST
+ * @param start The start time of the span got by TRACE_START()
+ */
+void traceSpan(const char *name, const int connId, const int reqId, const uint64_t start)
+{
+    if( (start == 0) || !isTraceEnabled() )
+	return;
+    const uint64_t end = getTraceTime();
+    recordTraceEvent(name, connId, reqId, start, (end > start) ? end - start: 0, PHASE_COMPLETE);
+}
+
+/**
+ * Set the request executed now by the current thread, its IDs are given to the spans recorded by traceRequestSpan()
+ * @param connId The ID of the connection the request has arrived from
+ * @param reqId The ID of the request or NO_REQUEST
+ */
+void setTraceRequest(const int connId, const int reqId)
+{
+    requestConnId = connId;
+    requestReqId  = reqId;
+}
+
+/**
+ * Forget the request executed by the current thread, the next spans recorded by traceRequestSpan() have no IDs
+ */
+void clearTraceRequest()
+{
+    setTraceRequest(-1, -1);
+}
+
+/**
+ * Record the span of the hop of the request executed now by the current thread.
+ * Nothing is recorded if the tracing is disabled or the span has started while it has been disabled
+ * @param name The name of the hop, it should be a constant string
+ * @param start The start time of the span got by TRACE_START()
+ */
+void traceRequestSpan(const char *name, const uint64_t start)
+{
+    traceSpan(name, requestConnId, requestReqId, start);
+}
+
+/**
+ * Record the instant event of the request if the tracing is enabled
+ * @param name The name of the event, it should be a constant string
+ * @param connId The ID of the connection the request has arrived from
+ * @param reqId The ID of the request or NO_REQUEST
+ */
+void traceInstant(const char *name, const int connId, const int reqId)
+{
+    if(isTraceEnabled())
+	recordTraceEvent(name, connId, reqId, getTraceTime(), 0, PHASE_INSTANT);
+}
+
+/**
+ * Write the events of the ring which haven't been overwritten while reading
+ * @param file The file
+ * @param ring The ring
+ * @param isFirst Is no event written to the file yet
+ */
+static void dumpTraceRing(FILE *file, struct TraceRing *ring, bool *isFirst)
+{
+    const int pid = getpid();
+    const long threadId = atomic_load_explicit(&ring->threadId, memory_order_relaxed);
+    fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+	    *isFirst ? "": ",", pid, threadId, ring->threadName);
+    *isFirst = false;
+
+    const size_t pos = atomic_load_explicit(&ring->pos, memory_order_acquire);
+    size_t i = (pos > TRACE_RING_LEN) ? pos - TRACE_RING_LEN: 0;
+    for( ; i < pos; i++)
+	{
+	    struct TraceEvent *event = &ring->events[i % TRACE_RING_LEN];
+	    if(atomic_load_explicit(&event->seq, memory_order_acquire) != i + 1)
+		continue;
+	    const struct TraceEvent copy = { .name = event->name, .connId = event->connId, .reqId = event->reqId,
+					     .start = event->start, .duration = event->duration, .phase = event->phase };
+	    atomic_thread_fence(memory_order_acquire);
+	    if(atomic_load_explicit(&event->seq, memory_order_relaxed) != i + 1)
+		continue;
+
+	    fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,", copy.name, copy.phase, (unsigned long long) copy.start);
+	    if(copy.phase == PHASE_COMPLETE)
+		fprintf(file, "\"dur\":%llu,", (unsigned long long) copy.duration);
+	    else
+		fprintf(file, "\"s\":\"t\",");
+	    fprintf(file, "\"pid\":%d,\"tid\":%ld,\"args\":{\"conn\":%d,\"req\":%d}}", pid, threadId, copy.connId, copy.reqId);
+	}
+}
+
+/**
+ * Write the events kept by all the threads to the given file as the Chrome trace events' JSON.
+ * The events are read while the threads may record the new ones, the overwritten events are skipped
+ * @param name The name of the file
+ * @return true The file has been written
+ */
+bool dumpTrace(const char *name)
+{
+    FILE *file = fopen(name, "w");
+    if(file == NULL)
+	return false;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool isFirst = true;
+    const size_t num = atomic_load_explicit(&ringsNum, memory_order_acquire);
+    size_t i;
+    for(i = 0; i < num; i++)
+	dumpTraceRing(file, rings[i], &isFirst);
+    fprintf(file, "\n]}\n");
+
+    return fclose(file) == 0;
+}
+
+/**
+ * Forget the events kept by all the threads.
+ * The events recorded at the same time may be kept
+ */
+void clearTrace()
+{
+    const size_t num = atomic_load_explicit(&ringsNum, memory_order_acquire);
+    size_t i, j;
+    for(i = 0; i < num; i++)
+	{
+	    for(j = 0; j < TRACE_RING_LEN; j++)
+		atomic_store_explicit(&rings[i]->events[j].seq, 0, memory_order_relaxed);
+	}
+}
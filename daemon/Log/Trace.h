@@ -0,0 +1,123 @@
+/**
+ * @file
+ * The tracing of the requests passing the daemon's threads.
+ * Every thread records the spans of the request's hops into its own ring buffer,
+ * the rings are dumped on demand as the JSON of the Chrome trace events(chrome://tracing, Perfetto)
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __TRACE_HEADER
+#define __TRACE_HEADER
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TRACE_FILE_NAME "trace.json"                 /**< The default name of the file the traces are dumped to */
+#define TRACE_RING_LEN 4096                          /**< The number of the last events kept by every thread */
+#define MAX_TRACE_THREADS_NUM 32                     /**< The maximal number of the traced threads */
+#define TRACE_THREAD_NAME_LEN 16                     /**< The maximal length of the name of a traced thread */
+
+/**
+ * Get the start time of a span if the tracing is enabled
+ * @return The current time in microseconds or 0 if the tracing is disabled
+ */
+#define TRACE_START() (isTraceEnabled() ? getTraceTime(): 0)
+
+/**
+ * Enable or disable the tracing. The tracing is disabled by default
+ * @param enabled Should the spans be recorded
+ */
+void setTraceEnabled(const bool enabled);
+
+/**
+ * Is the tracing enabled
+ * @return true The spans are recorded
+ */
+bool isTraceEnabled();
+
+/**
+ * Get the time of the monotonic clock the spans are measured by
+ * @return The time in microseconds
+ */
+uint64_t getTraceTime();
+
+/**
+ * Set the name of the current thread in the dumped traces.
+ * If it's called before the first event of the thread, the ring of an exited thread with the same name is reused
+ * @param name The name
+ */
+void setTraceThreadName(const char *name);
+
+/**
+ * Record the span of the request's hop which has finished now.
+ * Nothing is recorded if the tracing is disabled or the span has started while it has been disabled
+ * @param name The name of the hop, it should be a constant string
+ * @param connId The ID of the connection the request has arrived from
+ * @param reqId The ID of the request or NO_REQUEST
+ * @param start The start time of the span got by TRACE_START()
+ */
+void traceSpan(const char *name, const int connId, const int reqId, const uint64_t start);
+
+/**
+ * Set the request executed now by the current thread, its IDs are given to the spans recorded by traceRequestSpan()
+ * @param connId The ID of the connection the request has arrived from
+ * @param reqId The ID of the request or NO_REQUEST
+ */
+void setTraceRequest(const int connId, const int reqId);
+
+/**
+ * Forget the request executed by the current thread, the next spans recorded by traceRequestSpan() have no IDs
+ */
+void clearTraceRequest();
+
+/**
+ * Record the span of the hop of the request executed now by the current thread.
+ * Nothing is recorded if the tracing is disabled or the span has started while it has been disabled
+ * @param name The name of the hop, it should be a constant string
+ * @param start The start time of the span got by TRACE_START()
+ */
+void traceRequestSpan(const char *name, const uint64_t start);
+
+/**
+ * Record the instant event of the request if the tracing is enabled
+ * @param name The name of the event, it should be a constant string
+ * @param connId The ID of the connection the request has arrived from
+ * @param reqId The ID of the request or NO_REQUEST
+ */
+void traceInstant(const char *name, const int connId, const int reqId);
+
+/**
+ * Write the events kept by all the threads to the given file as the Chrome trace events' JSON
+ * @param name The name of the file
+ * @return true The file has been written
+ */
+bool dumpTrace(const char *name);
+
+/**
+ * Forget the events kept by all the threads
+ */
+void clearTrace();
+
+#endif
@@ -1,9 +1,11 @@
 #include "CUnit/Basic.h"
 #include "../Log.h"
+#include "../Trace.h"
 #include "errno.h"
 #include "string.h"
 #include "unistd.h"
 #include "stdlib.h"
+#include "pthread.h"
 
 #define LOG_FILE_NAME "log.txt"
 
@@ -12,11 +14,15 @@ FILE *file = NULL;
 #define BUFF_LEN 100
 char buff[BUFF_LEN] = {'\0'};
 
+#define TRACE_BUFF_LEN 2048
+
 char *date;
 
 int initSuite(void)
 {
     remove(LOG_FILE_NAME); 
+    remove(LOG_FILE_NAME ".1");
+    remove(LOG_FILE_NAME ".2");
     return 0;
 }
 
@@ -50,6 +56,7 @@ void testWrite2Log()
     if(file != NULL)
 	{
 	    writeToLog("Test1\n", "TAG");
+	    flushLog();
 	    CU_ASSERT(0 != fread(buff, sizeof(char), BUFF_LEN, file));
 	    CU_ASSERT_PTR_NOT_NULL(strstr(buff, "TAG: Test1"));
 	}
@@ -80,6 +87,7 @@ void testWrite2Log2()
     if(file != NULL)
 	{
 	    writeToLog2("Test2", "Test3\n", "TAG");
+	    flushLog();
 	    CU_ASSERT(0 != fread(buff, sizeof(char), BUFF_LEN, file));
 	    CU_ASSERT_PTR_NOT_NULL(strstr(buff, "TAG: Test2Test3"));
 	}
@@ -94,6 +102,7 @@ void testWriteToLogIfError()
     if(file != NULL)
 	{
 	    writeToLogIfError(-1, __func__, "error", "TAG");
+	    flushLog();
 	    CU_ASSERT(0 != fread(buff, sizeof(char), BUFF_LEN, file));
 	    CU_ASSERT_PTR_NOT_NULL(strstr(buff, "TAG: ERROR: testWriteToLogIfError(): error"));
 	}
@@ -114,6 +123,97 @@ void testClrLog()
     CU_ASSERT(getLogSizeBytes() < MAX_LOG_FILE_LEN);
 }
 
+void testRotateLog()
+{
+    setLogRotation(1000, 2);
+    int i;
+    for(i = 0; i < 100; ++i)
+	{
+	    writeToLog2("test2", "test3", "tag");
+	    flushLog();
+	}
+    CU_ASSERT(0 == access(LOG_FILE_NAME ".1", F_OK));
+    CU_ASSERT(0 == access(LOG_FILE_NAME ".2", F_OK));
+    CU_ASSERT(0 != access(LOG_FILE_NAME ".3", F_OK));
+    setLogRotation(MAX_LOG_FILE_LEN, LOG_GENERATIONS_NUM);
+}
+
+void testDumpTrace()
+{
+    traceSpan("disabled", 1, 2, TRACE_START());
+    setTraceEnabled(true);
+    setTraceThreadName("test");
+    const uint64_t start = TRACE_START();
+    CU_ASSERT(start != 0);
+    traceSpan("span", 3, 4, start);
+    traceInstant("instant", 5, 6);
+    setTraceEnabled(false);
+
+    CU_ASSERT(dumpTrace(TRACE_FILE_NAME));
+    FILE *traceFile = fopen(TRACE_FILE_NAME, "r");
+    if(traceFile != NULL)
+	{
+	    char traceBuff[TRACE_BUFF_LEN] = {'\0'};
+	    CU_ASSERT(0 != fread(traceBuff, sizeof(char), TRACE_BUFF_LEN - 1, traceFile));
+	    CU_ASSERT_PTR_NOT_NULL(strstr(traceBuff, "\"traceEvents\""));
+	    CU_ASSERT_PTR_NOT_NULL(strstr(traceBuff, "\"name\":\"test\""));
+	    CU_ASSERT_PTR_NOT_NULL(strstr(traceBuff, "\"name\":\"span\",\"ph\":\"X\""));
+	    CU_ASSERT_PTR_NOT_NULL(strstr(traceBuff, "\"conn\":3,\"req\":4"));
+	    CU_ASSERT_PTR_NOT_NULL(strstr(traceBuff, "\"name\":\"instant\",\"ph\":\"i\""));
+	    CU_ASSERT_PTR_NULL(strstr(traceBuff, "disabled"));
+	    fclose(traceFile);
+	}
+    else
+	{
+	    CU_FAIL("Can't open trace file");
+	}
+    remove(TRACE_FILE_NAME);
+}
+
+void* traceRestartedThread(void *arg)
+{
+    setTraceThreadName("restarted");
+    traceInstant("restarted_event", *(int*) arg, 0);
+    return NULL;
+}
+
+void testTraceRestartedThreads()
+{
+    setTraceEnabled(true);
+    int i;
+    for(i = 0; i < MAX_TRACE_THREADS_NUM + 4; i++)
+	{
+	    pthread_t thread;
+	    if(0 != pthread_create(&thread, NULL, traceRestartedThread, &i))
+		{
+		    CU_FAIL("Can't create thread");
+		    break;
+		}
+	    pthread_join(thread, NULL);
+	}
+    setTraceEnabled(false);
+
+    CU_ASSERT(dumpTrace(TRACE_FILE_NAME));
+    FILE *traceFile = fopen(TRACE_FILE_NAME, "r");
+    if(traceFile != NULL)
+	{
+	    char traceBuff[TRACE_BUFF_LEN * 4] = {'\0'};
+	    CU_ASSERT(0 != fread(traceBuff, sizeof(char), sizeof(traceBuff) - 1, traceFile));
+	    char lastEvent[BUFF_LEN];
+	    snprintf(lastEvent, BUFF_LEN, "\"conn\":%d,\"req\":0", MAX_TRACE_THREADS_NUM + 3);
+	    CU_ASSERT_PTR_NOT_NULL(strstr(traceBuff, lastEvent));
+	    const char *name = strstr(traceBuff, "\"name\":\"restarted\"");
+	    CU_ASSERT_PTR_NOT_NULL(name);
+	    if(name != NULL)
+		CU_ASSERT_PTR_NULL(strstr(name + 1, "\"name\":\"restarted\""));
+	    fclose(traceFile);
+	}
+    else
+	{
+	    CU_FAIL("Can't open trace file");
+	}
+    remove(TRACE_FILE_NAME);
+}
 
 int main(const int argc, char* argv[])
 {
@@ -139,7 +239,10 @@ int main(const int argc, char* argv[])
        NULL == CU_add_test(pSuite, "write 2 strings to log's file", testWrite2Log2)        ||
        NULL == CU_add_test(pSuite, "add date to a text           ", testAddDateToTxt)      ||
        NULL == CU_add_test(pSuite, "write to log if error        ", testWriteToLogIfError) ||
-       NULL == CU_add_test(pSuite, "clearing log's file          ", testClrLog))
+       NULL == CU_add_test(pSuite, "clearing log's file          ", testClrLog)            ||
+       NULL == CU_add_test(pSuite, "rotating log's file          ", testRotateLog)         ||
+       NULL == CU_add_test(pSuite, "dumping the traces           ", testDumpTrace)         ||
+       NULL == CU_add_test(pSuite, "tracing the restarted threads", testTraceRestartedThreads))
    {
       CU_cleanup_registry();
       return CU_get_error();
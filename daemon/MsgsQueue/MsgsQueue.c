@@ -1,6 +1,6 @@
 /**
  * @file
- * Linux Messages Queue for interprocess communication
+ * Messages queue for interprocess communication over the local socket
  **
  * The MIT License (MIT)
  *
@@ -32,8 +32,7 @@
 #include <string.h>
 
 #include <sys/types.h>
-#include <sys/ipc.h>
-#include <sys/msg.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 
@@ -41,53 +40,59 @@
 
 
 /**
- * Create the file of messages queue
- * @return true The file has created successfully
+ * Does the file of messages queue exist?
+ * @return true The file does exist
  */
-bool createQueueMsgsFile()
+bool doesQueueMsgsFileExist()
 {
-  FILE *file = fopen(FILE_NAME, "w+");
-  if(file == NULL)
-    {
-	writeToLog2("ERROR: createQueueMsgsFile(): Can't create the file for the messages queue: ", strerror(errno), TAG);
-	return false;
-    }
-
-  if(fclose(file) == EOF)
-    {
-	writeToLog2("ERROR: createQueueMsgsFile(): Can't close the file for the messages queue: ", strerror(errno), TAG);
-	return false;
-    }
-  return true;
+    return (access(FILE_NAME, R_OK | W_OK) != ERROR);
 }
 
 /**
- * Does the file of messages queue exist?
- * @return true The file does exist
+ * Open the socket of the messages queue. It's the sequenced packets local socket,
+ * so the messages keep their boundaries and the order
+ * @param addr The address of the socket's file
+ * @return The socket's descriptor or ERROR
  */
-bool doesQueueMsgsFileExist()
+const int initMsgsQueue(struct sockaddr_un *addr)
 {
-    return (access(FILE_NAME, R_OK | W_OK) != ERROR);
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    strncpy(addr->sun_path, FILE_NAME, sizeof(addr->sun_path) - 1);
+
+    const int sockDescr = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if(sockDescr == ERROR)
+	writeToLog2("ERROR initMsgsQueue(): Can't create the socket of the messages queue: ", strerror(errno), TAG);
+
+    return sockDescr;
 }
 
 /**
- * Initialize the the queue of messages
- * @param permissionFlag The flag of the queue permission
- * @return The messages queue ID
+ * Send the message of the given type with the given text through the given socket.
+ * The message waiting for a free space in the socket is limited by the socket's send timeout if it's set
+ * @param sockDescr The socket's descriptor
+ * @param type The type of the message
+ * @param msgTxt The text of the message
+ * @param shouldWait Should the message wait for a free space, otherwise it's dropped if there is no one
+ * @return true The message has sent successfully
  */
-const int initMsgsQueue(const int permissionFlag)
-{    
-  const key_t key = ftok(FILE_NAME, 'B');
-  
-  if (key == ERROR)
-    {
-	writeToLog2("ERROR initMsgsQueue(): Can't create messages queue: ", strerror(errno), TAG);
-      return false;
-    }
+bool sendQueueMsg(const int sockDescr, const long type, const char *msgTxt, const bool shouldWait)
+{
+    if( (msgTxt == NULL) || (strlen(msgTxt) == 0) || (strlen(msgTxt) >= MSG_STR_MAX_LEN) )
+	{
+	    writeToLog("ERROR sendQueueMsg(): Can't send message, the given message text is invalid\n", TAG);
+	    return false;
+	}
 
-  int msgid = ERROR;
-  if ( (msgid = msgget(key, permissionFlag)) == ERROR )
-      writeToLog2("ERROR initMsgsQueue(): Can't create messages queue: ", strerror(errno), TAG);
+    struct message msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.mtype = type;
+    strcpy(msg.mtxt, msgTxt);
 
-  return msgid;
+    if(send(sockDescr, &msg, sizeof(msg), shouldWait ? MSG_NOSIGNAL: (MSG_DONTWAIT | MSG_NOSIGNAL)) == ERROR)
+	{
+	    writeToLog2("ERROR sendQueueMsg(): Can't send a message to the queue: ", strerror(errno), TAG);
+	    return false;
+	}
+    return true;
 }
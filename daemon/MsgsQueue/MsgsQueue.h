@@ -30,14 +30,21 @@
 #define MSGSQUEUE_H_
 
 #include <stdbool.h>
+#include <sys/un.h>
 
 #define MSG_STR_MAX_LEN 50         /**< The maximal length of a message */
-#define FILE_NAME "queue.msgs"     /**< The file name for messages queue */
+#define FILE_NAME "queue.msgs"     /**< The file name of the messages queue's socket */
 #define ERROR -1                   /**< The code of an error */
 
+#define MAX_QUEUE_CLIENTS_NUM 8    /**< The maximal number of the clients connected to the server at once */
+
+#define REQUEST_MSG_TYPE      1    /**< The type of the messages sent by the client */
+#define REPLY_MSG_TYPE        2    /**< The type of the replies sent by the server */
+#define NOTIFICATION_MSG_TYPE 3    /**< The type of the notifications sent by the server */
+
 /**
  * \struct message
- * \brief The structure of a message
+ * \brief The structure of a message. Every message is one packet of the socket
  */
 struct message
 {
@@ -51,7 +58,7 @@ struct message
  */
 struct MsgsQueueData
 {
-    int queueID;                                    /**< The ID of the messages queue, that should be initialized */
+    int queueID;                                    /**< The descriptor of the messages queue's socket, that should be initialized */
     char receivedMsgTxt[MSG_STR_MAX_LEN];           /**< The string array of a message's text */    
 };
 
@@ -62,16 +69,22 @@ struct MsgsQueueData
 bool doesQueueMsgsFileExist();
 
 /**
- * Create the file of messages queue
- * @return true The file has created successfully
+ * Open the socket of the messages queue. It's the sequenced packets local socket,
+ * so the messages keep their boundaries and the order
+ * @param addr The address of the socket's file
+ * @return The socket's descriptor or ERROR
  */
-bool createQueueMsgsFile();
+const int initMsgsQueue(struct sockaddr_un *addr);
 
 /**
- * Initialize the the queue of messages
- * @param permissionFlag The flag of the queue permission
- * @return The messages queue ID
+ * Send the message of the given type with the given text through the given socket.
+ * The message waiting for a free space in the socket is limited by the socket's send timeout if it's set
+ * @param sockDescr The socket's descriptor
+ * @param type The type of the message
+ * @param msgTxt The text of the message
+ * @param shouldWait Should the message wait for a free space, otherwise it's dropped if there is no one
+ * @return true The message has sent successfully
  */
-const int initMsgsQueue(const int permissionFlag);
+bool sendQueueMsg(const int sockDescr, const long type, const char *msgTxt, const bool shouldWait);
     
 #endif
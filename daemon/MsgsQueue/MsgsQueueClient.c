@@ -27,6 +27,7 @@
  */
 
 #include "MsgsQueue.h"
+#include "MsgsQueueClient.h"
 #include "Log.h"
 
 #include "string.h"
@@ -34,28 +35,51 @@
 #include "strings.h"
 
 #include <sys/types.h>
-#include <sys/ipc.h>
-#include <sys/msg.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #define TAG "MSGS_QUEUE_CLIENT"                /**< The tag for writing to log file */
 
 
-struct MsgsQueueData clientQueueData;
+struct MsgsQueueData clientQueueData = { ERROR, "" };
+
+char notificationTxt[MSG_STR_MAX_LEN] = "";    /**< The last notification which hasn't been received yet */
 
 /**
- * Initialize the messages queue of the client side
+ * Initialize the messages queue of the client side. Connects to the server if it isn't connected yet
  * @return true The queue has initialized successfully
  */
 bool initQueueClient()
 {    
     bzero(clientQueueData.receivedMsgTxt, MSG_STR_MAX_LEN);
 
-    if(doesQueueMsgsFileExist())
-	clientQueueData.queueID = initMsgsQueue(0644);
-    else
+    if(clientQueueData.queueID != ERROR)
+	return true;
+    if(!doesQueueMsgsFileExist())
+	return false;
+
+    struct sockaddr_un addr;
+    clientQueueData.queueID = initMsgsQueue(&addr);
+    if(clientQueueData.queueID == ERROR)
 	return false;
 
-    return clientQueueData.queueID != ERROR;
+    if(connect(clientQueueData.queueID, (struct sockaddr*)&addr, sizeof(addr)) == ERROR)
+	{
+	    writeToLog2("ERROR initQueueClient(): Can't connect to the messages queue: ", strerror(errno), TAG);
+	    closeQueueClient();
+	    return false;
+	}
+    return true;
+}
+
+/**
+ * Close the messages queue of the client side
+ */
+void closeQueueClient()
+{
+    if(clientQueueData.queueID != ERROR)
+	close(clientQueueData.queueID);
+    clientQueueData.queueID = ERROR;
 }
 
 /**
@@ -76,34 +100,64 @@ bool sendMsgClient(const char *msgTxt)
 	    return false;
 	}
     
-    struct message answer;
-    bzero(answer.mtxt, MSG_STR_MAX_LEN);
-    answer.mtype = 1;
-    strcpy(answer.mtxt, msgTxt);
-    
-    if (msgsnd(clientQueueData.queueID, &answer, sizeof(answer.mtxt), 0) == ERROR) /* +1 for '\0' */
+    if(!sendQueueMsg(clientQueueData.queueID, REQUEST_MSG_TYPE, msgTxt, true))
 	{
-	    writeToLog2("ERROR sndMsgClient(): Can't send a messages to queue: ", strerror(errno), TAG);
+	    closeQueueClient();         // the next initialization reconnects
 	    return false;
 	}
     return true;
 }
 
 /**
- * Receive the message on the client side from the server one
- * @return The text of the message
+ * Receive a message from the server's side. The notification is kept as the last one
+ * @param flags The flags of receiving, MSG_DONTWAIT for not waiting for the message
+ * @return The type of the received message or ERROR
  */
-char* receiveMsgClient()
+static const long receiveQueueMsg(const int flags)
 {
     struct message msg;
+    const ssize_t len = recv(clientQueueData.queueID, &msg, sizeof(msg), flags);
+    if(len != sizeof(msg))
+	{
+	    if( (len == 0) || ( (len == ERROR) && (errno != EAGAIN) && (errno != EWOULDBLOCK) ) )
+		{
+		    writeToLog("ERROR receiveQueueMsg(): The connection to the messages queue is lost\n", TAG);
+		    closeQueueClient();
+		}
+	    return ERROR;
+	}
+
+    msg.mtxt[MSG_STR_MAX_LEN - 1] = '\0';
+    strcpy((msg.mtype == NOTIFICATION_MSG_TYPE) ? notificationTxt: clientQueueData.receivedMsgTxt, msg.mtxt);
+    return msg.mtype;
+}
+
+/**
+ * Receive the message on the client side from the server one.
+ * The notifications arrived before the message are kept for receiveNotificationClient()
+ * @return The text of the message or "" if there is an error
+ */
+char* receiveMsgClient()
+{
     bzero(clientQueueData.receivedMsgTxt, MSG_STR_MAX_LEN);
-    
-    if (msgrcv(clientQueueData.queueID, &msg, sizeof(msg.mtxt), 0, 0) == ERROR)
-	writeToLog2("ERROR receiveMsgClient(): Can't receive a messages from queue: ", strerror(errno), TAG);
-    else
-	strcpy(clientQueueData.receivedMsgTxt, msg.mtxt);
+
+    long type = ERROR;
+    while( (clientQueueData.queueID != ERROR) && ( (type = receiveQueueMsg(0)) == NOTIFICATION_MSG_TYPE) );
+    if(type != REPLY_MSG_TYPE)
+	writeToLog("ERROR receiveMsgClient(): Can't receive a message from queue\n", TAG);
 
     return clientQueueData.receivedMsgTxt;
 }
 
+/**
+ * Receive the last notification sent by the server. Doesn't wait if there is no notification
+ * @return The text of the notification or "" if there is no one
+ */
+char* receiveNotificationClient()
+{
+    while( (clientQueueData.queueID != ERROR) && (receiveQueueMsg(MSG_DONTWAIT) != ERROR) );
 
+    strcpy(clientQueueData.receivedMsgTxt, notificationTxt);
+    notificationTxt[0] = '\0';
+    return clientQueueData.receivedMsgTxt;
+}
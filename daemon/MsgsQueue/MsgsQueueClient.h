@@ -32,11 +32,16 @@
 #include "MsgsQueue.h"
 
 /**
- * Initialize the messages queue of the client side
+ * Initialize the messages queue of the client side. Connects to the server if it isn't connected yet
  * @return true The queue has initialized successfully
  */
 bool initQueueClient();
 
+/**
+ * Close the messages queue of the client side
+ */
+void closeQueueClient();
+
 /**
  * Send message with the given text from the clien side to the server one
  * @param msgTxt The text of the message
@@ -45,9 +50,16 @@ bool initQueueClient();
 bool sendMsgClient(const char *msgTxt);
 
 /**
- * Receive the message on the client side from the server one
- * @return The text of the message
+ * Receive the message on the client side from the server one.
+ * The notifications arrived before the message are kept for receiveNotificationClient()
+ * @return The text of the message or "" if there is an error
  */
 char* receiveMsgClient();
 
+/**
+ * Receive the last notification sent by the server. Doesn't wait if there is no notification
+ * @return The text of the notification or "" if there is no one
+ */
+char* receiveNotificationClient();
+
 #endif
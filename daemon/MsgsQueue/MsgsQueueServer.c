@@ -27,203 +27,302 @@
  */
 
 #include <sys/types.h>
-#include <sys/ipc.h>
-#include <sys/msg.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/time.h>
 
 #include <errno.h>
 
+#include <poll.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
-#include <strings.h>
 #include <string.h>
 #include <unistd.h>
 
 #include <Log.h>
 
 #include "MsgsQueue.h"
+#include "MsgsQueueServer.h"
 
 #include <pthread.h>
 
 #define TAG "MSGS_QUEUE_SERVER" /**< the tag for writing to log file */
 
-#define HAS_NEW_MSG 4                       /**< there is a new message in queue */
-#define NO_NEW_MSG  5                       /**< there are no new  messages in queue */
-
-int receivingMsgStatus = NO_NEW_MSG;        /**< the server's receiving status */
-
-
+#define NO_CLIENT -1                        /**< the ID of the free client's slot */
+#define REPLY_SEND_TIMEOUT_MS 1000          /**< the timeout of waiting for a free space for the reply in the client's socket */
 
 /**
- * /struct msg
- *  The structure of a message
+ * \struct QueueClient
+ * \brief The client connected to the messages queue
  */
-struct message msg;    
-
-#define RECEIVING 1                      /**< receiving a message */
-#define SENDING   2                      /**< sending a message */
-#define STOP      3                      /**< stopping the queue */
+struct QueueClient
+{
+    int id;                                 /**< The ID of the client, the replies are sent by it */
+    int sockDescr;                          /**< The descriptor of the client's socket */
+};
 
-int runingStatus = RECEIVING;            /**< the running status of the messages server */
+struct QueueClient clients[MAX_QUEUE_CLIENTS_NUM];   /**< the connected clients */
+int lastClientID = 0;                                 /**< the ID given to the last connected client */
 
-pthread_mutex_t statusMutex;             /**< the mutex of the server's status */
+pthread_mutex_t clientsMutex = PTHREAD_MUTEX_INITIALIZER;   /**< the mutex of the clients */
 
-struct MsgsQueueData serverQueueData;
+int listenDescr = ERROR;                 /**< the socket waiting for the clients' connections */
+int stopEvent = ERROR;                   /**< the event signaled for stopping the queue */
+pthread_mutex_t stopMutex = PTHREAD_MUTEX_INITIALIZER;   /**< the mutex of the stop event, it's closed by the queue's thread while it may be signaled */
 
+MsgArrivedCallback msgArrivedCallback = NULL;   /**< The function called when a new message has arrived */
+void *msgArrivedContext = NULL;                 /**< The context of the function called when a new message has arrived */
 
 /**
- * Set the running status
- * @param status The status code: RECEIVING, SENDING or STOP
+ * Set the function which should be called when a new message has arrived.
+ * Should be called before running the messages queue
+ * @param callback The function or NULL
+ * @param context The context which the function should be called with
  */
-void setRunningStatus(const int status)
+void setMsgArrivedCallback(MsgArrivedCallback callback, void *context)
 {
-    pthread_mutex_lock   (&statusMutex);
-    runingStatus = status;
-    pthread_mutex_unlock (&statusMutex);
+    msgArrivedCallback = callback;
+    msgArrivedContext  = context;
 }
 
 /**
- * Send message from the server's side
+ * Send message from the server's side to the given client.
+ * The reply waits for a free space in the client's socket, it isn't dropped: if it can't be sent
+ * during REPLY_SEND_TIMEOUT_MS, the client's connection is shut down, so the client waiting for the reply gets its end
+ * @param clientID The ID of the client
  * @param msgTxt The text of the message
  * @return true The message has sent successfully
  */
-bool sendMsgServer(const char *msgTxt)
+bool sendMsgServer(const int clientID, const char *msgTxt)
 {
-    if(msgTxt == NULL)
+    bool res = false;
+    pthread_mutex_lock   (&clientsMutex);
+    int i;
+    for(i = 0; i < MAX_QUEUE_CLIENTS_NUM; i++)
+	if(clients[i].id == clientID)
+	    break;
+    if(i < MAX_QUEUE_CLIENTS_NUM)
 	{
-	    writeToLog("ERROR sndMsgServer(): Can't send message, the given message text is NULL\n", TAG);
-	    return false;
+	    res = sendQueueMsg(clients[i].sockDescr, REPLY_MSG_TYPE, msgTxt, true);
+	    if(!res && (shutdown(clients[i].sockDescr, SHUT_RDWR) == ERROR))   // the queue's thread closes it
+		writeToLog2("ERROR sendMsgServer(): Can't shut down the client's connection: ", strerror(errno), TAG);
 	}
-    if(strlen(msgTxt) == 0)
+    else
+	writeToLog("ERROR sendMsgServer(): Can't send message, the client has disconnected\n", TAG);
+    pthread_mutex_unlock (&clientsMutex);
+    return res;
+}
+
+/**
+ * Send the notification from the server's side to all the connected clients.
+ * The notification doesn't wait for a free space in the clients' sockets, it's dropped if there is no one
+ * @param msgTxt The text of the notification
+ * @return true The notification has sent to all the clients successfully
+ */
+bool sendNotificationServer(const char *msgTxt)
+{
+    bool res = true;
+    pthread_mutex_lock   (&clientsMutex);
+    for(int i = 0; i < MAX_QUEUE_CLIENTS_NUM; i++)
+	if( (clients[i].id != NO_CLIENT) && !sendQueueMsg(clients[i].sockDescr, NOTIFICATION_MSG_TYPE, msgTxt, false) )
+	    res = false;
+    pthread_mutex_unlock (&clientsMutex);
+    return res;
+}
+
+/**
+ * Initialize the messages queue on the server's side
+ * @return true Initialized successfully
+ */
+bool initQueueServer()
+{
+    for(int i = 0; i < MAX_QUEUE_CLIENTS_NUM; i++)
 	{
-	    writeToLog("ERROR sndMsgServer(): Can't send message, the given message text is empty\n", TAG);
+	    clients[i].id        = NO_CLIENT;
+	    clients[i].sockDescr = ERROR;
+	}
+
+    if( (remove(FILE_NAME) == ERROR) && (errno != ENOENT) )
+	writeToLog2("ERROR initQueueServer(): Can't remove the old file of the messages queue: ", strerror(errno), TAG);
+
+    struct sockaddr_un addr;
+    listenDescr = initMsgsQueue(&addr);
+    if(listenDescr == ERROR)
+	return false;
+
+    if( (bind(listenDescr, (struct sockaddr*)&addr, sizeof(addr)) == ERROR) ||
+	(listen(listenDescr, MAX_QUEUE_CLIENTS_NUM) == ERROR) )
+	{
+	    writeToLog2("ERROR initQueueServer(): Can't listen on the socket of the messages queue: ", strerror(errno), TAG);
+	    close(listenDescr);
+	    listenDescr = ERROR;
 	    return false;
 	}
-    
-    setRunningStatus(SENDING);
-
-    struct message answer;
-    bzero(answer.mtxt, MSG_STR_MAX_LEN);
-    answer.mtype = 1;
-    strcpy(answer.mtxt, msgTxt);
-    
-    if (msgsnd(serverQueueData.queueID, &answer, sizeof(answer.mtxt), 0) == ERROR) /* +1 for '\0' */
+
+    pthread_mutex_lock   (&stopMutex);
+    stopEvent = eventfd(0, EFD_CLOEXEC);
+    pthread_mutex_unlock (&stopMutex);
+    if(stopEvent == ERROR)
 	{
-	    writeToLog2("ERROR sndMsgServer(): Can't send a messages to queue: ", strerror(errno), TAG);
-	    setRunningStatus(STOP);  
+	    writeToLog2("ERROR initQueueServer(): Can't create the stop event: ", strerror(errno), TAG);
+	    close(listenDescr);
+	    listenDescr = ERROR;
 	    return false;
 	}
-    
-    setRunningStatus(RECEIVING);  
     return true;
 }
 
 /**
- * Receive a message on the server's side
- * @return The text of the received message
+ * Accept the connection of a new client. The connection is closed if there are too many clients
  */
-char* receiveMsgServer()
-{    
-    pthread_mutex_lock   (&statusMutex);
-    if(receivingMsgStatus == HAS_NEW_MSG)	
+static void acceptClient()
+{
+    const int sockDescr = accept(listenDescr, NULL, NULL);
+    if(sockDescr == ERROR)
 	{
-	    receivingMsgStatus = NO_NEW_MSG;
-	    pthread_mutex_unlock (&statusMutex);
-	    return serverQueueData.receivedMsgTxt;
+	    writeToLog2("ERROR acceptClient(): Can't accept the client's connection: ", strerror(errno), TAG);
+	    return;
 	}
-    pthread_mutex_unlock (&statusMutex);
-    return "";
-}
 
-/**
- * Initialize the messages queue on the server's side
- * @return true Initialized successfully
- */
-bool initQueueServer()
-{
-    bzero(serverQueueData.receivedMsgTxt, MSG_STR_MAX_LEN);
-    bzero(msg.mtxt, MSG_STR_MAX_LEN);
-    
-    if(createQueueMsgsFile())
-	serverQueueData.queueID = initMsgsQueue(0644 | IPC_CREAT);
+    const struct timeval timeout = { REPLY_SEND_TIMEOUT_MS / 1000, (REPLY_SEND_TIMEOUT_MS % 1000) * 1000 };
+    if(setsockopt(sockDescr, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == ERROR)
+	writeToLog2("ERROR acceptClient(): Can't set the timeout of sending to the client: ", strerror(errno), TAG);
+
+    pthread_mutex_lock   (&clientsMutex);
+    int i;
+    for(i = 0; i < MAX_QUEUE_CLIENTS_NUM; i++)
+	if(clients[i].id == NO_CLIENT)
+	    {
+		clients[i].id        = ++lastClientID;
+		clients[i].sockDescr = sockDescr;
+		break;
+	    }
+    pthread_mutex_unlock (&clientsMutex);
 
-    return (serverQueueData.queueID != ERROR);
+    if(i == MAX_QUEUE_CLIENTS_NUM)
+	{
+	    writeToLog("ERROR acceptClient(): Can't accept the client's connection, there are too many clients\n", TAG);
+	    close(sockDescr);
+	}
 }
 
 /**
- * Get the running status of the server's side messages queue
- * @return The status code: RECEIVING, SENDING or STOP
+ * Close the connection of the client in the given slot
+ * @param slot The index of the client
  */
-const int getRunningStatus()
+static void closeClient(const int slot)
 {
-    int status;
-    
-    pthread_mutex_lock   (&statusMutex);
-    status = runingStatus;
-    pthread_mutex_unlock (&statusMutex);
-    
-    return status;
+    pthread_mutex_lock   (&clientsMutex);
+    close(clients[slot].sockDescr);
+    clients[slot].id        = NO_CLIENT;
+    clients[slot].sockDescr = ERROR;
+    pthread_mutex_unlock (&clientsMutex);
 }
 
 /**
- * Run the messages queue
+ * Receive the message of the client in the given slot and pass it to the callback.
+ * The client's connection is closed if the client has disconnected
+ * @param slot The index of the client
  */
-void runQueue()
+static void receiveClientMsg(const int slot)
 {
-    while(getRunningStatus() != STOP)
+    struct message msg;
+    const ssize_t len = recv(clients[slot].sockDescr, &msg, sizeof(msg), 0);
+    if(len <= 0)
 	{
-	    if (getRunningStatus() == SENDING)
-		continue;
-	    if (getRunningStatus() == RECEIVING)
-		{
-		    if (msgrcv(serverQueueData.queueID, &msg, sizeof(msg.mtxt), 0, 0) != ERROR)
-			{
-			    strcpy(serverQueueData.receivedMsgTxt, msg.mtxt);
-
-			    pthread_mutex_lock   (&statusMutex);
-			    receivingMsgStatus = HAS_NEW_MSG;
-			    pthread_mutex_unlock (&statusMutex);
-			    
-			    bzero(msg.mtxt, MSG_STR_MAX_LEN);
-
-			}
-		    else if(errno != EIDRM)
-			{
-			    writeToLog2("ERROR runQueue(): Can't get a messages from queue: ", strerror(errno), TAG);
-			    break;
-			}
-		}
+	    if(len == ERROR)
+		writeToLog2("ERROR receiveClientMsg(): Can't receive a message from the client: ", strerror(errno), TAG);
+	    closeClient(slot);
+	    return;
+	}
+
+    if( (len == sizeof(msg)) && (msg.mtype == REQUEST_MSG_TYPE) )
+	{
+	    msg.mtxt[MSG_STR_MAX_LEN - 1] = '\0';
+	    if(msgArrivedCallback != NULL)
+		msgArrivedCallback(clients[slot].id, msg.mtxt, msgArrivedContext);
 	}
+    else
+	writeToLog("ERROR receiveClientMsg(): The received message is invalid\n", TAG);
 }
 
 /**
- * Stop the messages queue and delete it
+ * Close the connections of the clients and the queue's descriptors.
+ * The stop event is closed under its mutex, so deleteQueue() never signals the closed descriptor
  */
-void deleteMsgsQueue()
+static void closeQueueServer()
 {
-    setRunningStatus(STOP);
-    sleep(1);
+    for(int i = 0; i < MAX_QUEUE_CLIENTS_NUM; i++)
+	if(clients[i].id != NO_CLIENT)
+	    closeClient(i);
 
-    if (msgctl(serverQueueData.queueID, IPC_RMID, NULL) == ERROR) {
-	writeToLog2("ERROR deleteMsgsQueue(): Can't delete the messages queue: ", strerror(errno), TAG);
-  }
+    close(listenDescr);
+    listenDescr = ERROR;
+
+    pthread_mutex_lock   (&stopMutex);
+    close(stopEvent);
+    stopEvent = ERROR;
+    pthread_mutex_unlock (&stopMutex);
 }
 
 /**
- * Delete the file of the messages queue
+ * Run the messages queue. It waits for the clients' connections and messages
+ * until the queue is deleted, then closes the connections
  */
-void deleteQueueMsgsFile()
+void runQueue()
 {
-  if(remove(FILE_NAME) == ERROR)
-    {
-	writeToLog2("ERROR: createQueueMsgsFile(): Can't remove the file for the messages queue: ", strerror(errno), TAG);
-    }
+    if( (listenDescr == ERROR) || (stopEvent == ERROR) )
+	return;
+
+    struct pollfd descrs[MAX_QUEUE_CLIENTS_NUM + 2];
+    int slots[MAX_QUEUE_CLIENTS_NUM + 2];
+    while(true)
+	{
+	    descrs[0].fd     = stopEvent;
+	    descrs[1].fd     = listenDescr;
+	    unsigned int descrsNum = 2;
+	    for(int i = 0; i < MAX_QUEUE_CLIENTS_NUM; i++)
+		if(clients[i].id != NO_CLIENT)
+		    {
+			slots[descrsNum]     = i;
+			descrs[descrsNum++].fd = clients[i].sockDescr;
+		    }
+	    for(unsigned int i = 0; i < descrsNum; i++)
+		{
+		    descrs[i].events  = POLLIN;
+		    descrs[i].revents = 0;
+		}
+
+	    if(poll(descrs, descrsNum, -1) == ERROR)
+		{
+		    if(errno == EINTR)
+			continue;
+		    writeToLog2("ERROR runQueue(): Can't wait for the messages: ", strerror(errno), TAG);
+		    break;
+		}
+	    if(descrs[0].revents & POLLIN)
+		break;
+	    if(descrs[1].revents & POLLIN)
+		acceptClient();
+	    for(unsigned int i = 2; i < descrsNum; i++)
+		if(descrs[i].revents & (POLLIN | POLLHUP | POLLERR))
+		    receiveClientMsg(slots[i]);
+	}
+    closeQueueServer();
 }
 
 /**
- * Delete messages queue and its file
+ * Stop the running messages queue and delete its file
  */
 void deleteQueue()
 {
-    deleteMsgsQueue();
-    deleteQueueMsgsFile();
+    const uint64_t one = 1;
+    pthread_mutex_lock   (&stopMutex);
+    if( (stopEvent != ERROR) && (write(stopEvent, &one, sizeof(one)) == ERROR) )
+	writeToLog2("ERROR deleteQueue(): Can't signal the stop event: ", strerror(errno), TAG);
+    pthread_mutex_unlock (&stopMutex);
+
+    if(remove(FILE_NAME) == ERROR)
+	writeToLog2("ERROR deleteQueue(): Can't remove the file of the messages queue: ", strerror(errno), TAG);
 }
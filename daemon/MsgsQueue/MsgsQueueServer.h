@@ -31,6 +31,22 @@
 
 #include "MsgsQueue.h"
 
+/**
+ * The function called when a new message has arrived
+ * @param clientID The ID of the client the message has arrived from
+ * @param msgTxt The text of the message
+ * @param context The context given while setting the callback
+ */
+typedef void (*MsgArrivedCallback)(const int clientID, const char *msgTxt, void *context);
+
+/**
+ * Set the function which should be called when a new message has arrived.
+ * Should be called before running the messages queue
+ * @param callback The function or NULL
+ * @param context The context which the function should be called with
+ */
+void setMsgArrivedCallback(MsgArrivedCallback callback, void *context);
+
 /**
  * Initialize the messages queue on the server's side
  * @return true Initialized successfully
@@ -38,25 +54,31 @@
 bool initQueueServer();
 
 /**
- * Run the messages queue
+ * Run the messages queue. It waits for the clients' connections and messages
+ * until the queue is deleted, then closes the connections
  */
 void runQueue();
 
 /**
- * Send message from the server's side
+ * Send message from the server's side to the given client.
+ * The reply waits for a free space in the client's socket, it isn't dropped: if it can't be sent
+ * during REPLY_SEND_TIMEOUT_MS, the client's connection is shut down, so the client waiting for the reply gets its end
+ * @param clientID The ID of the client
  * @param msgTxt The text of the message
  * @return true The message has sent successfully
  */
-bool sendMsgServer(const char *msgTxt);
+bool sendMsgServer(const int clientID, const char *msgTxt);
 
 /**
- * Receive a message on the server's side
- * @return The text of the received message
+ * Send the notification from the server's side to all the connected clients.
+ * The notification doesn't wait for a free space in the clients' sockets, it's dropped if there is no one
+ * @param msgTxt The text of the notification
+ * @return true The notification has sent to all the clients successfully
  */
-char* receiveMsgServer();
+bool sendNotificationServer(const char *msgTxt);
 
 /**
- * Delete messages queue and its file
+ * Stop the running messages queue and delete its file
  */
 void deleteQueue();
 
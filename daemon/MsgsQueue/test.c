@@ -5,10 +5,17 @@
 #include "Log.h"
 
 #include "pthread.h"
+#include "string.h"
+#include "time.h"
 
 
 pthread_t thread;
 
+pthread_mutex_t arrivedMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t arrivedCond = PTHREAD_COND_INITIALIZER;
+int arrivedClientID = -1;
+char arrivedMsgTxt[MSG_STR_MAX_LEN] = "";
+
 int initSuite(void)
 {
     remove(FILE_NAME); 
@@ -21,6 +28,15 @@ int cleanSuite(void)
     return 0;
 }
 
+void onMsgArrived(const int clientID, const char *msgTxt, void *context)
+{
+    pthread_mutex_lock(&arrivedMutex);
+    arrivedClientID = clientID;
+    strcpy(arrivedMsgTxt, msgTxt);
+    pthread_cond_signal(&arrivedCond);
+    pthread_mutex_unlock(&arrivedMutex);
+}
+
 void testInitQueueServer()
 {
     CU_ASSERT_TRUE(initQueueServer());
@@ -45,6 +61,7 @@ void *runServerQueue()
 
 void testRunQueueServer()
 {
+    setMsgArrivedCallback(onMsgArrived, NULL);
     if(pthread_create(&thread, NULL, runServerQueue, NULL) != 0)
 	{
 	    CU_FAIL("Can't create thread for Server Queue");
@@ -68,15 +85,22 @@ void testSendMsgFromClient()
 
 void testReceiveMsgByServer()
 {
-    sleep(2);
-    CU_ASSERT_STRING_EQUAL(receiveMsgServer(), "client");
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 2;
+
+    pthread_mutex_lock(&arrivedMutex);
+    while( (arrivedMsgTxt[0] == '\0') && (pthread_cond_timedwait(&arrivedCond, &arrivedMutex, &deadline) == 0) );
+    pthread_mutex_unlock(&arrivedMutex);
+
+    CU_ASSERT_STRING_EQUAL(arrivedMsgTxt, "client");
+    CU_ASSERT_NOT_EQUAL(arrivedClientID, -1);
     CU_ASSERT_NOT_EQUAL(access(LOG_FILE_NAME, F_OK), 0);
 }
 
 void testSendMsgFromServer()
 {
-    CU_ASSERT_TRUE(sendMsgServer("server"));
-    CU_ASSERT_NOT_EQUAL(access(LOG_FILE_NAME, F_OK), 0);
+    CU_ASSERT_TRUE(sendMsgServer(arrivedClientID, "server"));
 }
 
 void testReceiveMsgByClient()
@@ -85,6 +109,45 @@ void testReceiveMsgByClient()
     CU_ASSERT_NOT_EQUAL(access(LOG_FILE_NAME, F_OK), 0);
 }
 
+void testSendNotification()
+{
+    CU_ASSERT_STRING_EQUAL(receiveNotificationClient(), "");
+    CU_ASSERT_TRUE(sendNotificationServer("vol 10"));
+    CU_ASSERT_TRUE(sendNotificationServer("vol 20"));
+    CU_ASSERT_TRUE(sendMsgServer(arrivedClientID, "reply"));
+    CU_ASSERT_STRING_EQUAL(receiveMsgClient(), "reply");
+    CU_ASSERT_STRING_EQUAL(receiveNotificationClient(), "vol 20");
+    CU_ASSERT_STRING_EQUAL(receiveNotificationClient(), "");
+}
+
+char floodedReplyTxt[MSG_STR_MAX_LEN] = "";
+
+void *receiveFloodedReply()
+{
+    usleep(100000);                             // the reply is sent while the client's socket is full
+    strcpy(floodedReplyTxt, receiveMsgClient());
+    return NULL;
+}
+
+void testFloodedReply()
+{
+    while(sendNotificationServer("vol 30"));   // the client's socket is full
+
+    pthread_t replyThread;
+    if(pthread_create(&replyThread, NULL, receiveFloodedReply, NULL) != 0)
+	{
+	    CU_FAIL("Can't create thread for receiving the reply");
+	    return;
+	}
+    const bool isSent = sendMsgServer(arrivedClientID, "flooded");
+    CU_ASSERT_TRUE(isSent);
+    if(!isSent)
+	pthread_cancel(replyThread);            // the reply would never arrive
+    pthread_join(replyThread, NULL);
+    CU_ASSERT_STRING_EQUAL(floodedReplyTxt, "flooded");
+    CU_ASSERT_STRING_EQUAL(receiveNotificationClient(), "vol 30");
+    remove(LOG_FILE_NAME);                      // the dropped notification is logged
+}
 
 int main()
 {
@@ -99,12 +162,14 @@ int main()
    }
 
    if (NULL == CU_add_test(pSuite, "init server queue    ", testInitQueueServer)    ||
-       NULL == CU_add_test(pSuite, "init client queue    ", testRunQueueClient)     ||
-       NULL == CU_add_test(pSuite, "send msg from server ", testSendMsgFromServer)  ||
-       NULL == CU_add_test(pSuite, "receive msg by client", testReceiveMsgByClient) ||
        NULL == CU_add_test(pSuite, "run server queue     ", testRunQueueServer)     ||
+       NULL == CU_add_test(pSuite, "init client queue    ", testRunQueueClient)     ||
        NULL == CU_add_test(pSuite, "send msg from client ", testSendMsgFromClient)  ||
        NULL == CU_add_test(pSuite, "receive msg by server", testReceiveMsgByServer) ||
+       NULL == CU_add_test(pSuite, "send msg from server ", testSendMsgFromServer)  ||
+       NULL == CU_add_test(pSuite, "receive msg by client", testReceiveMsgByClient) ||
+       NULL == CU_add_test(pSuite, "send notification    ", testSendNotification)   ||
+       NULL == CU_add_test(pSuite, "reply after flood    ", testFloodedReply)       ||
        NULL == CU_add_test(pSuite, "delete server queue  ", testDelQueueServer) )
    {
       CU_cleanup_registry();
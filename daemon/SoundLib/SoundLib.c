@@ -61,27 +61,37 @@ enum AUDIO_ACTIONS
  */
 enum SOUND_STATE { UNMUTED, MUTED };
 
-long volume_, state_;   /**< Current volume percent and the state of sound */
-long minv, maxv;        /**< Minimal and maximal volume */
-
-snd_mixer_t* handle;
-snd_mixer_elem_t* elem;
+/**
+ * \struct SoundControl
+ * \brief The session of the sound system mixer
+ */
+struct SoundControl
+{
+    snd_mixer_t* handle;        /**< The handle of the open mixer or NULL if the mixer isn't attached */
+    snd_mixer_elem_t* elem;     /**< The used mixer element */
+    long minv, maxv;            /**< Minimal and maximal volume */
+    SoundChangedCallback callback;   /**< The function called when the volume or the mute state has changed */
+    void *context;                   /**< The context of the function called when the sound has changed */
+};
 
 /**
  * Make the given action on the sound volume, e.g. mute or get the current
  * volume value.
+ * @param control The sound control session
  * @param action The action type: get mute state or set mute, get or set volume
  * @param vol The current sound volume
  * @return ERR or NO_ERR
  */
-const int doSoundVolAction(const int action, long *vol)
+const int doSoundVolAction(struct SoundControl *control, const int action, long *vol)
 {
+    const long minv = control->minv;
+    const long maxv = control->maxv;
     int mute;
     int res;
     switch (action)
 	{
 	  case AUDIO_VOLUME_GET_VOLUME:
-	      res = snd_mixer_selem_get_playback_volume(elem, 0, vol);
+	      res = snd_mixer_selem_get_playback_volume(control->elem, 0, vol);
 	      if(res != NO_ERR)
 		  {
 		      writeToLog2("ERR: Can't get volume ", snd_strerror(res), TAG);
@@ -92,7 +102,7 @@ const int doSoundVolAction(const int action, long *vol)
 	      
 	  case AUDIO_VOLUME_SET_VOLUME:
 	      *vol = (*vol * (maxv - minv) / (MAX_VOL - 1)) + minv;
-	      res = snd_mixer_selem_set_playback_volume_all(elem, *vol);
+	      res = snd_mixer_selem_set_playback_volume_all(control->elem, *vol);
 	      if(res != NO_ERR)
 		  {
 		      writeToLog2("ERR: Can't set volume ", snd_strerror(res), TAG);
@@ -102,7 +112,7 @@ const int doSoundVolAction(const int action, long *vol)
 	      break;
 	      
 	  case AUDIO_VOLUME_GET_MUTE:
-	      res = snd_mixer_selem_get_playback_switch(elem, 0, &mute);
+	      res = snd_mixer_selem_get_playback_switch(control->elem, 0, &mute);
 	      if(res != NO_ERR)
 		  {
 		      writeToLog2("ERR: Can't get mute state ", snd_strerror(res), TAG);
@@ -113,7 +123,7 @@ const int doSoundVolAction(const int action, long *vol)
 	      
 	  case AUDIO_VOLUME_SET_MUTE:
 	      mute = (*vol == 0) ? MUTED : UNMUTED;
-	      res = snd_mixer_selem_set_playback_switch_all(elem, mute);
+	      res = snd_mixer_selem_set_playback_switch_all(control->elem, mute);
 	      if(res != NO_ERR)
 		  {
 		      writeToLog2("ERR: Can't set mute state ", snd_strerror(res), TAG);
@@ -126,153 +136,348 @@ const int doSoundVolAction(const int action, long *vol)
 }
 
 /**
- * Initialise the sound control
- * @return The sound control handler
+ * Detach the mixer of the sound control session
+ * @param control The sound control session
  */
-const int initSoundControl()
+static void detachSoundControl(struct SoundControl *control)
 {
-    snd_mixer_selem_id_t* sid;    
-        
-    snd_mixer_selem_id_malloc(&sid);
-    snd_mixer_selem_id_set_index(sid, 0);
-    snd_mixer_selem_id_set_name(sid, AUDIO_MIXER);
+    if(control->handle == NULL)
+	return;
+    
+    const int res = snd_mixer_close(control->handle);
+    if(res != NO_ERR)
+	writeToLog2("ERR: Can't close the open mixer ", snd_strerror(res), TAG);
 
-    int res = snd_mixer_open(&handle, 0);
+    control->handle = NULL;
+    control->elem   = NULL;
+}
+
+/**
+ * Call the callback of the changed sound with the current volume and mute state.
+ * Called by the mixer while handling its events
+ * @param elem The changed mixer element
+ * @param mask The mask of the event
+ * @return 0
+ */
+static int onMixerElemChanged(snd_mixer_elem_t *elem, unsigned int mask)
+{
+    struct SoundControl *control = snd_mixer_elem_get_callback_private(elem);
+    if( (mask == SND_CTL_EVENT_MASK_REMOVE) || !(mask & SND_CTL_EVENT_MASK_VALUE) )
+	return 0;
+    if( (control == NULL) || (control->callback == NULL) )
+	return 0;
+
+    long volume = 0;
+    long state  = UNMUTED;
+    if( (doSoundVolAction(control, AUDIO_VOLUME_GET_VOLUME, &volume) == NO_ERR) &&
+	(doSoundVolAction(control, AUDIO_VOLUME_GET_MUTE, &state) == NO_ERR) )
+	control->callback(volume, state == MUTED, control->context);
+    return 0;
+}
+
+/**
+ * Attach the mixer of the sound card to the sound control session
+ * @param control The sound control session
+ * @return ERR or NO_ERR
+ */
+static const int attachSoundControl(struct SoundControl *control)
+{
+    int res = snd_mixer_open(&control->handle, 0);
     if(res < 0)
 	{
 	    writeToLog2("ERR: Can't open mixer ", snd_strerror(res), TAG);
+	    control->handle = NULL;
 	    return ERR;
 	}
-    res = snd_mixer_attach(handle, AUDIO_CARD);
+    res = snd_mixer_attach(control->handle, AUDIO_CARD);
     if(res < 0)
 	{
 	    writeToLog2("ERR: Can't attach the open mixer ", snd_strerror(res), TAG);
+	    detachSoundControl(control);
 	    return ERR;
 	}
-    res = snd_mixer_selem_register(handle, NULL, NULL);
+    res = snd_mixer_selem_register(control->handle, NULL, NULL);
     if(res < 0)
 	{
 	    writeToLog2("ERR: Can't register the open mixer ", snd_strerror(res), TAG);
+	    detachSoundControl(control);
 	    return ERR;
 	}
-    res = snd_mixer_load(handle);
+    res = snd_mixer_load(control->handle);
     if(res < 0)
 	{
 	    writeToLog2("ERR: Can't load the open mixer ", snd_strerror(res), TAG);
+	    detachSoundControl(control);
 	    return ERR;
 	}
 
-    //    elem = snd_mixer_first_elem(handle);
-    //    snd_mixer_selem_get_id(elem, sid);
-    //    writeToLog2("Name: ", snd_mixer_selem_id_get_name(sid), TAG);
-    elem = snd_mixer_find_selem(handle, sid);
+    snd_mixer_selem_id_t* sid;    
+    snd_mixer_selem_id_malloc(&sid);
+    snd_mixer_selem_id_set_index(sid, 0);
+    snd_mixer_selem_id_set_name(sid, AUDIO_MIXER);
+
+    control->elem = snd_mixer_find_selem(control->handle, sid);
 
     snd_mixer_selem_id_free(sid);
+
+    if(control->elem == NULL)
+	{
+	    writeToLog2("ERR: Can't find the mixer ", AUDIO_MIXER, TAG);
+	    detachSoundControl(control);
+	    return ERR;
+	}
     
-    res = snd_mixer_selem_get_playback_volume_range(elem, &minv, &maxv);
-    if(res < 0)
+    res = snd_mixer_selem_get_playback_volume_range(control->elem, &control->minv, &control->maxv);
+    if( (res < 0) || (control->maxv == control->minv) )
 	{
 	    writeToLog2("ERR: Can't get the playback volume of the open mixer ", snd_strerror(res), TAG);
+	    detachSoundControl(control);
 	    return ERR;
 	}
-    
-    res = doSoundVolAction(AUDIO_VOLUME_GET_VOLUME, &volume_);
-    if(res == NO_ERR)
-	res = doSoundVolAction(AUDIO_VOLUME_GET_MUTE, &state_);
-    return res;
+
+    snd_mixer_elem_set_callback_private(control->elem, control);
+    snd_mixer_elem_set_callback(control->elem, onMixerElemChanged);
+
+    writeToLog("The sound mixer has attached\n", TAG);
+    return NO_ERR;
 }
 
 /**
- * Finish sound control using
+ * Prepare the sound control session for an action. Attach the mixer if it isn't attached yet,
+ * otherwise update the mixer's values changed by other applications.
+ * If the sound card has disappeared, the mixer is re-attached
+ * @param control The sound control session
+ * @return ERR or NO_ERR
  */
-void finishSoundControl()
+static const int prepareSoundControl(struct SoundControl *control)
 {
-    int res = snd_mixer_close(handle);
-    if(res != NO_ERR)
-	writeToLog2("ERR: Can't close the open mixer ", snd_strerror(res), TAG);
+    if(control->handle == NULL)
+	return attachSoundControl(control);
+
+    const int res = snd_mixer_handle_events(control->handle);
+    if(res < 0)
+	{
+	    writeToLog2("ERR: The sound mixer is lost, re-attaching it: ", snd_strerror(res), TAG);
+	    detachSoundControl(control);
+	    return attachSoundControl(control);
+	}
+    return NO_ERR;
+}
+
+/**
+ * Make the given action on the sound volume by the session. If the action fails,
+ * the mixer is re-attached and the action is made once more
+ * @param control The sound control session
+ * @param action The action type: get mute state or set mute, get or set volume
+ * @param vol The current sound volume
+ * @return ERR or NO_ERR
+ */
+static const int doSoundAction(struct SoundControl *control, const int action, long *vol)
+{
+    if(control == NULL)
+	{
+	    writeToLog("ERR: The given sound control session is NULL\n", TAG);
+	    return ERR;
+	}
+    if(prepareSoundControl(control) != NO_ERR)
+	return ERR;
+
+    const long givenVol = *vol;
+    if(doSoundVolAction(control, action, vol) == NO_ERR)
+	return NO_ERR;
+
+    detachSoundControl(control);
+    if(attachSoundControl(control) != NO_ERR)
+	return ERR;
+
+    *vol = givenVol;
+    return doSoundVolAction(control, action, vol);
+}
+
+/**
+ * Open the session of the sound control
+ * @return The sound control session or NULL if there is no memory for it.
+ *         The sound card is attached lazily, so the session is valid even if the card isn't available yet
+ */
+struct SoundControl* openSoundControl()
+{
+    struct SoundControl *control = calloc(1, sizeof(struct SoundControl));
+    if(control == NULL)
+	{
+	    writeToLog("ERR: Can't allocate the sound control session\n", TAG);
+	    return NULL;
+	}
+    attachSoundControl(control);
+    return control;
+}
+
+/**
+ * Close the session of the sound control
+ * @param control The sound control session
+ */
+void closeSoundControl(struct SoundControl *control)
+{
+    if(control == NULL)
+	return;
+
+    detachSoundControl(control);
+    free(control);
     
-    res = snd_config_update_free_global();
+    const int res = snd_config_update_free_global();
     if(res != NO_ERR)
 	writeToLog2("ERR: Can't free the sound resources ", snd_strerror(res), TAG);
 }
 
 /**
- * Make the sound state muted
+ * Set the function which should be called when the volume or the mute state has changed,
+ * e.g. by the volume keys of the desktop
+ * @param control The sound control session
+ * @param callback The function or NULL
+ * @param context The context which the function should be called with
  */
-void mute()
+void setSoundChangedCallback(struct SoundControl *control, SoundChangedCallback callback, void *context)
 {
-    const int res = initSoundControl();
+    if(control == NULL)
+	return;
+    control->callback = callback;
+    control->context  = context;
+}
+
+/**
+ * Get the descriptors which should be polled for the events of the mixer.
+ * Attaches the mixer if it isn't attached yet
+ * @param control The sound control session
+ * @param descrs The array for the descriptors
+ * @param space The length of the array
+ * @return The number of the descriptors, 0 if the mixer isn't attached
+ */
+const unsigned int getSoundControlDescrs(struct SoundControl *control, struct pollfd *descrs, const unsigned int space)
+{
+    if(control == NULL)
+	return 0;
+    if( (control->handle == NULL) && (attachSoundControl(control) != NO_ERR) )
+	return 0;
+
+    const int count = snd_mixer_poll_descriptors_count(control->handle);
+    if(count <= 0)
+	return 0;
     
-    if((res == NO_ERR) && (state_ == UNMUTED))
+    const int res = snd_mixer_poll_descriptors(control->handle, descrs, ((unsigned int)count < space) ? count: space);
+    if(res < 0)
 	{
-	    state_ = MUTED;
-	    doSoundVolAction(AUDIO_VOLUME_SET_MUTE, &state_);
+	    writeToLog2("ERR: Can't get the descriptors of the mixer ", snd_strerror(res), TAG);
+	    return 0;
 	}
-
-    finishSoundControl();
+    return res;
 }
 
 /**
- * Unmute the sound state
+ * Handle the events of the polled mixer descriptors. The callback of the changed sound is called from here
+ * @param control The sound control session
+ * @param descrs The polled descriptors
+ * @param descrsNum The number of the descriptors
  */
-void unmute()
+void handleSoundControlEvents(struct SoundControl *control, struct pollfd *descrs, const unsigned int descrsNum)
 {
-    const int res = initSoundControl();
-	
-    if( (res == NO_ERR) && (state_ == MUTED) )
+    if( (control == NULL) || (control->handle == NULL) || (descrsNum == 0) )
+	return;
+
+    unsigned short revents = 0;
+    const int res = snd_mixer_poll_descriptors_revents(control->handle, descrs, descrsNum, &revents);
+    if( (res < 0) || (revents & (POLLERR | POLLNVAL | POLLHUP)) )
 	{
-	    state_ = UNMUTED;
-	    doSoundVolAction(AUDIO_VOLUME_SET_MUTE, &state_);
+	    writeToLog("ERR: The sound mixer is lost, it will be re-attached\n", TAG);
+	    detachSoundControl(control);
+	    return;
 	}
+    if(revents & POLLIN)
+	prepareSoundControl(control);
+}
 
-    finishSoundControl();
+/**
+ * Make the sound state muted
+ * @param control The sound control session
+ * @return true The sound state is muted
+ */
+const bool mute(struct SoundControl *control)
+{
+    long state = UNMUTED;
+    if(doSoundAction(control, AUDIO_VOLUME_GET_MUTE, &state) != NO_ERR)
+	return false;
+    if(state == MUTED)
+	return true;
+    state = MUTED;
+    return doSoundAction(control, AUDIO_VOLUME_SET_MUTE, &state) == NO_ERR;
+}
+
+/**
+ * Unmute the sound state
+ * @param control The sound control session
+ * @return true The sound state is unmuted
+ */
+const bool unmute(struct SoundControl *control)
+{
+    long state = MUTED;
+    if(doSoundAction(control, AUDIO_VOLUME_GET_MUTE, &state) != NO_ERR)
+	return false;
+    if(state == UNMUTED)
+	return true;
+    state = UNMUTED;
+    return doSoundAction(control, AUDIO_VOLUME_SET_MUTE, &state) == NO_ERR;
 }
 
 /**
  * Change the current value by the given value
  * if the given value > 0, then increase the current volume by value
  * if the given value < 0, then decrease the current volume by value
+ * @param control The sound control session
  * @param value The value of change. 
+ * @return true The volume has been changed
  */
-void chgVol(const int value)
+const bool chgVol(struct SoundControl *control, const int value)
 {
-    const int res = initSoundControl();
-    
-    if(res == NO_ERR)
-	{
-	    if(value > 0)
-		volume_ = (volume_ + value) <= MAX_VOL ? volume_ + value: MAX_VOL;
-	    else
-		volume_ = (volume_ + value) >= 0 ? volume_ + value : 0;
-	    doSoundVolAction(AUDIO_VOLUME_SET_VOLUME, &volume_);
-	}
-    
-    finishSoundControl();
+    long volume = 0;
+    if(doSoundAction(control, AUDIO_VOLUME_GET_VOLUME, &volume) != NO_ERR)
+	return false;
+    if(value > 0)
+	volume = (volume + value) <= MAX_VOL ? volume + value: MAX_VOL;
+    else
+	volume = (volume + value) >= 0 ? volume + value : 0;
+    return doSoundVolAction(control, AUDIO_VOLUME_SET_VOLUME, &volume) == NO_ERR;
+}
+
+/**
+ * Set the current volume to the given value
+ * @param control The sound control session
+ * @param value The value of the volume in percents, it's limited by 0 and the maximal volume
+ * @return true The volume has been set
+ */
+const bool setVol(struct SoundControl *control, const int value)
+{
+    long volume = (value > MAX_VOL) ? MAX_VOL: ( (value < 0) ? 0: value );
+    return doSoundVolAction(control, AUDIO_VOLUME_SET_VOLUME, &volume) == NO_ERR;
 }
 
 /**
  * Get current volume
+ * @param control The sound control session
  * @return The current volume percents
  */
-const long getVol()
+const long getVol(struct SoundControl *control)
 {
-    initSoundControl();
-    finishSoundControl();
-    return volume_;
+    long volume = 0;
+    doSoundAction(control, AUDIO_VOLUME_GET_VOLUME, &volume);
+    return volume;
 }
 
 /**
  * Is the sound state muted
+ * @param control The sound control session
  * @return True if the sound state is muted
  */
-const bool isMuted()
+const bool isMuted(struct SoundControl *control)
 {
-    const int res = initSoundControl();
-    
-    if(res == NO_ERR)
-	doSoundVolAction(AUDIO_VOLUME_GET_MUTE, &state_);
-    
-    finishSoundControl();
-    
-    return state_ == MUTED;
+    long state = UNMUTED;
+    doSoundAction(control, AUDIO_VOLUME_GET_MUTE, &state);
+    return state == MUTED;
 }
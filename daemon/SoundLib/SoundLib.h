@@ -30,35 +30,107 @@
 #define SOUND_VOL_CONTROL_H_
 
 #include <stdbool.h>
+#include <poll.h>
+
+/**
+ * \struct SoundControl
+ * \brief The session of the sound system mixer. It's kept open between the volume
+ * operations and re-attached only when the sound card has disappeared
+ */
+struct SoundControl;
+
+/**
+ * The function called when the volume or the mute state of the mixer has changed
+ * @param volume The current volume percents
+ * @param muted Is the sound state muted
+ * @param context The context given while setting the callback
+ */
+typedef void (*SoundChangedCallback)(const long volume, const bool muted, void *context);
+
+/**
+ * Open the session of the sound control
+ * @return The sound control session or NULL if there is no memory for it.
+ *         The sound card is attached lazily, so the session is valid even if the card isn't available yet
+ */
+struct SoundControl* openSoundControl();
+
+/**
+ * Close the session of the sound control
+ * @param control The sound control session
+ */
+void closeSoundControl(struct SoundControl *control);
+
+/**
+ * Set the function which should be called when the volume or the mute state has changed,
+ * e.g. by the volume keys of the desktop
+ * @param control The sound control session
+ * @param callback The function or NULL
+ * @param context The context which the function should be called with
+ */
+void setSoundChangedCallback(struct SoundControl *control, SoundChangedCallback callback, void *context);
+
+/**
+ * Get the descriptors which should be polled for the events of the mixer.
+ * Attaches the mixer if it isn't attached yet
+ * @param control The sound control session
+ * @param descrs The array for the descriptors
+ * @param space The length of the array
+ * @return The number of the descriptors, 0 if the mixer isn't attached
+ */
+const unsigned int getSoundControlDescrs(struct SoundControl *control, struct pollfd *descrs, const unsigned int space);
+
+/**
+ * Handle the events of the polled mixer descriptors. The callback of the changed sound is called from here
+ * @param control The sound control session
+ * @param descrs The polled descriptors
+ * @param descrsNum The number of the descriptors
+ */
+void handleSoundControlEvents(struct SoundControl *control, struct pollfd *descrs, const unsigned int descrsNum);
 
 /**
  * Make the sound state muted
+ * @param control The sound control session
+ * @return true The sound state is muted
  */
-void mute();
+const bool mute(struct SoundControl *control);
 
 /**
  * Unmute the sound state
+ * @param control The sound control session
+ * @return true The sound state is unmuted
  */
-void unmute();
+const bool unmute(struct SoundControl *control);
 
 /**
  * Change the current value by the given value
  * if the given value > 0, then increase the current volume by value
  * if the given value < 0, then decrease the current volume by value
+ * @param control The sound control session
  * @param value The value of change. 
+ * @return true The volume has been changed
+ */
+const bool chgVol(struct SoundControl *control, const int value);
+
+/**
+ * Set the current volume to the given value
+ * @param control The sound control session
+ * @param value The value of the volume in percents, it's limited by 0 and the maximal volume
+ * @return true The volume has been set
  */
-void chgVol(const int value);
+const bool setVol(struct SoundControl *control, const int value);
 
 /**
  * Get current volume
+ * @param control The sound control session
  * @return The current volume percents
  */
-const long getVol();
+const long getVol(struct SoundControl *control);
 
 /**
  * Is the sound state muted
+ * @param control The sound control session
  * @return True if the sound state is muted
  */
-const bool isMuted();
+const bool isMuted(struct SoundControl *control);
 
 #endif
@@ -8,12 +8,15 @@
 
 char result[RESULT_LEN] = {'\0'};
 
+struct SoundControl *control = NULL;
+
 
 
 
 
 int cleanSuite(void)
 {
+    closeSoundControl(control);
     return 0;
 }
 
@@ -43,7 +46,8 @@ void execCommand(char *command)
 int initSuite(void)
 {
     execCommand("amixer set Master 80%");
-    return 0;
+    control = openSoundControl();
+    return (control == NULL) ? -1: 0;
 }
 
 void testGetCurVol()
@@ -51,7 +55,7 @@ void testGetCurVol()
     execCommand("amixer sget Master | grep % | cut -d '[' -f 2 | sed 's/%.*//'");
     long curVol = atol(result);
     
-    CU_ASSERT_EQUAL(curVol, getVol());
+    CU_ASSERT_EQUAL(curVol, getVol(control));
 }
 
 void testDecVol()
@@ -61,7 +65,7 @@ void testDecVol()
 
     #define DEC_VAL 11
     
-    chgVol(-DEC_VAL);
+    chgVol(control, -DEC_VAL);
     
     execCommand("amixer sget Master | grep % | cut -d '[' -f 2 | sed 's/%.*//'");
     long curVol = atol(result);
@@ -76,7 +80,7 @@ void testIncVol()
 
     #define DEC_VAL 11
     
-    chgVol(DEC_VAL);
+    chgVol(control, DEC_VAL);
     
     execCommand("amixer sget Master | grep % | cut -d '[' -f 2 | sed 's/%.*//'");
     long curVol = atol(result);
@@ -84,13 +88,22 @@ void testIncVol()
     CU_ASSERT_EQUAL(prevVol + DEC_VAL, curVol);
 }
 
+void testSetVol()
+{
+    #define SET_VAL 42
+
+    setVol(control, SET_VAL);
+
+    execCommand("amixer sget Master | grep % | cut -d '[' -f 2 | sed 's/%.*//'");
+    CU_ASSERT_EQUAL(SET_VAL, atol(result));
+}
 
 void testMuteState()
 {
     execCommand("amixer sget Master | grep % | cut -d '[' -f 4 | sed 's/].*//'");
     bool muted = (strcmp(result, "off\n") == 0);
 
-    CU_ASSERT_TRUE(muted == isMuted());
+    CU_ASSERT_TRUE(muted == isMuted(control));
 }
 
 void testSetMute()
@@ -99,19 +112,19 @@ void testSetMute()
     bool muted = (strcmp(result, "off\n") == 0);
     if(muted)
 	{
-	    unmute();
+	    unmute(control);
 	    execCommand("amixer sget Master | grep % | cut -d '[' -f 4 | sed 's/].*//'");
 	    CU_ASSERT_TRUE(strcmp(result, "on\n") == 0);
-	    mute();
+	    mute(control);
 	    execCommand("amixer sget Master | grep % | cut -d '[' -f 4 | sed 's/].*//'");
 	    CU_ASSERT_TRUE(strcmp(result, "off\n") == 0);	    
 	}
     else
 	{
-	    mute();
+	    mute(control);
 	    execCommand("amixer sget Master | grep % | cut -d '[' -f 4 | sed 's/].*//'");
 	    CU_ASSERT_TRUE(strcmp(result, "off\n") == 0);
-	    unmute();
+	    unmute(control);
 	    execCommand("amixer sget Master | grep % | cut -d '[' -f 4 | sed 's/].*//'");
 	    CU_ASSERT_TRUE(strcmp(result, "on\n") == 0);
 	}	
@@ -131,6 +144,7 @@ int main()
    if (NULL == CU_add_test(pSuite, "get current volume      ", testGetCurVol) ||
        NULL == CU_add_test(pSuite, "decrease volume         ", testDecVol)  ||
        NULL == CU_add_test(pSuite, "increase volume         ", testIncVol)  ||
+       NULL == CU_add_test(pSuite, "set volume              ", testSetVol)  ||
        NULL == CU_add_test(pSuite, "check mute/unmute state ", testMuteState) ||
        NULL == CU_add_test(pSuite, "set mute/unmute state   ", testSetMute))
    {
@@ -0,0 +1,523 @@
+/**
+ * @file
+ * The load generator measuring the end-to-end latency of the WiFi daemon.
+ * It opens the given number of the connections to the daemon, every connection sends the commands of the given mix
+ * by the binary frames with the target rate and waits for their replies.
+ * The throughput and the percentiles of the latency are written as a text and as JSON
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <errno.h>
+}
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "CommandsNames.h"
+#include "frames.h"
+
+using namespace std;
+using namespace std::chrono;
+
+#define DEFAULT_HOST "127.0.0.1"                   /**< The default host of the daemon: loopback */
+#define DEFAULT_CONNECTIONS_NUM 4                  /**< The default number of the concurrent connections */
+#define DEFAULT_RATE 1000                          /**< The default target rate of all the connections in requests per second */
+#define DEFAULT_DURATION_SEC 10                    /**< The default duration of the measurement in seconds */
+#define DEFAULT_MIX "hello:1,get_vol:4,chg_vol:2,mute:1"   /**< The default mix of the commands and their weights */
+#define DEFAULT_JSON_FILE "bench.json"             /**< The default file of the JSON report */
+
+#define RECV_BUFF_LEN 4096                         /**< The length of the buffer of the received data */
+#define REPLY_TIMEOUT_SEC 5                        /**< The timeout of waiting for a reply */
+
+typedef steady_clock::time_point TimePoint;
+
+/**
+ * \struct BenchOptions
+ * \brief The options of the measurement given by the command line
+ */
+struct BenchOptions
+{
+    string host;                                   /**< The host of the daemon */
+    string port;                                   /**< The port of the daemon */
+    unsigned int connectionsNum;                   /**< The number of the concurrent connections */
+    double rate;                                   /**< The target rate of all the connections, 0 - as fast as the replies arrive */
+    unsigned int durationSec;                      /**< The duration of the measurement in seconds */
+    string mix;                                    /**< The mix of the commands: NAME:WEIGHT,... */
+    string jsonFile;                               /**< The file of the JSON report */
+};
+
+/**
+ * \struct MixEntry
+ * \brief The command of the mix
+ */
+struct MixEntry
+{
+    string name;                                   /**< The name of the command: hello, get_vol, chg_vol or mute */
+    unsigned int weight;                           /**< The weight of the command in the mix */
+};
+
+/**
+ * \struct ConnectionResult
+ * \brief The results of a connection's requests
+ */
+struct ConnectionResult
+{
+    map<string, vector<double>> latencies;         /**< The latencies of the replied requests in microseconds by the commands' names */
+    unsigned long errorsNum;                       /**< The number of the ERR replies */
+    bool isFailed;                                 /**< Has the connection been broken */
+    string failure;                                /**< The reason of the connection's failure */
+
+    ConnectionResult(): errorsNum(0), isFailed(false) {}
+};
+
+/**
+ * Print the usage of the program
+ * @param progName The name of the program
+ */
+void printUsage(const char *progName)
+{
+    cerr << "Usage: " << progName << " -p PORT [-h HOST] [-c CONNECTIONS] [-r RATE] [-d SECONDS] [-m MIX] [-j JSON_FILE]" << endl
+	 << "\t-p PORT        The port of the daemon run by 'vol_daemon wifi PORT'" << endl
+	 << "\t-h HOST        The host of the daemon, default " << DEFAULT_HOST << endl
+	 << "\t-c CONNECTIONS The number of the concurrent connections, default " << DEFAULT_CONNECTIONS_NUM << endl
+	 << "\t-r RATE        The target rate of all the connections in requests per second, 0 - without pauses, default " << DEFAULT_RATE << endl
+	 << "\t-d SECONDS     The duration of the measurement, default " << DEFAULT_DURATION_SEC << endl
+	 << "\t-m MIX         The commands and their weights, default " << DEFAULT_MIX << endl
+	 << "\t-j JSON_FILE   The file of the JSON report, default " << DEFAULT_JSON_FILE << endl;
+}
+
+/**
+ * Parse the options of the command line
+ * @param argc The number of the arguments
+ * @param argv The arguments
+ * @param options The parsed options
+ * @return true The options are valid
+ */
+bool parseOptions(int argc, char *argv[], BenchOptions &options)
+{
+    options.host           = DEFAULT_HOST;
+    options.connectionsNum = DEFAULT_CONNECTIONS_NUM;
+    options.rate           = DEFAULT_RATE;
+    options.durationSec    = DEFAULT_DURATION_SEC;
+    options.mix            = DEFAULT_MIX;
+    options.jsonFile       = DEFAULT_JSON_FILE;
+
+    int opt;
+    while((opt = getopt(argc, argv, "p:h:c:r:d:m:j:")) != -1)
+	{
+	    switch(opt)
+		{
+		case 'p': options.port           = optarg;       break;
+		case 'h': options.host           = optarg;       break;
+		case 'c': options.connectionsNum = atoi(optarg); break;
+		case 'r': options.rate           = atof(optarg); break;
+		case 'd': options.durationSec    = atoi(optarg); break;
+		case 'm': options.mix            = optarg;       break;
+		case 'j': options.jsonFile       = optarg;       break;
+		default:  return false;
+		}
+	}
+    return !options.port.empty() && (options.connectionsNum > 0) && (options.durationSec > 0) && (options.rate >= 0);
+}
+
+/**
+ * Parse the mix of the commands
+ * @param mixStr The string of the mix: NAME:WEIGHT,... the weight is 1 if it's absent
+ * @param mix The parsed mix
+ * @return true The mix is valid
+ */
+bool parseMix(const string &mixStr, vector<MixEntry> &mix)
+{
+    istringstream stream(mixStr);
+    string entryStr;
+    while(getline(stream, entryStr, ','))
+	{
+	    MixEntry entry;
+	    const size_t colonPos = entryStr.find(':');
+	    entry.name   = entryStr.substr(0, colonPos);
+	    entry.weight = (colonPos == string::npos) ? 1: atoi(entryStr.c_str() + colonPos + 1);
+	    if( (entry.name != HELLO) && (entry.name != GET_VOL) && (entry.name != CHG_VOL) && (entry.name != MUTE) )
+		{
+		    cerr << "ERROR: The command '" << entry.name << "' can't be in the mix" << endl;
+		    return false;
+		}
+	    if(entry.weight > 0)
+		mix.push_back(entry);
+	}
+    if(mix.empty())
+	cerr << "ERROR: The mix of the commands is empty" << endl;
+    return !mix.empty();
+}
+
+/**
+ * Connect to the daemon
+ * @param host The host of the daemon
+ * @param port The port of the daemon
+ * @return The socket's descriptor or -1
+ */
+int connectToDaemon(const string &host, const string &port)
+{
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *list = NULL;
+    if(getaddrinfo(host.c_str(), port.c_str(), &hints, &list) != 0)
+	return -1;
+
+    int sockDescr = -1;
+    for(struct addrinfo *info = list; info != NULL; info = info->ai_next)
+	{
+	    sockDescr = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+	    if(sockDescr == -1)
+		continue;
+	    if(connect(sockDescr, info->ai_addr, info->ai_addrlen) == 0)
+		break;
+	    close(sockDescr);
+	    sockDescr = -1;
+	}
+    freeaddrinfo(list);
+
+    if(sockDescr != -1)
+	{
+	    const int yes = 1;
+	    setsockopt(sockDescr, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+	    struct timeval timeout = { REPLY_TIMEOUT_SEC, 0 };
+	    setsockopt(sockDescr, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	}
+    return sockDescr;
+}
+
+/**
+ * Build the frame of the given command
+ * @param reqId The request ID of the frame
+ * @param opcode The opcode of the command
+ * @param param The parameter of the command or the empty string
+ * @return The frame
+ */
+string buildCommandFrame(const uint16_t reqId, const uint8_t opcode, const string &param)
+{
+    string frame(FRAME_HEADER_LEN, '\0');
+    if(!param.empty())
+	{
+	    frame += static_cast<char>(param.size());
+	    frame += param;
+	}
+    const size_t restLen = frame.size() - 3;
+    frame[0] = static_cast<char>(FRAME_MAGIC);
+    frame[1] = static_cast<char>(restLen >> 8);
+    frame[2] = static_cast<char>(restLen & 0xFF);
+    frame[3] = static_cast<char>(reqId >> 8);
+    frame[4] = static_cast<char>(reqId & 0xFF);
+    frame[5] = static_cast<char>(opcode);
+    return frame;
+}
+
+/**
+ * Wait for the reply frame of the request with the given ID.
+ * The notifications arriving meanwhile(frames or text lines) are skipped
+ * @param sockDescr The socket's descriptor
+ * @param buff The data received but not handled yet
+ * @param reqId The request ID
+ * @param reply The text of the reply: its parameters separated by spaces
+ * @return true The reply has arrived
+ */
+bool waitReply(const int sockDescr, string &buff, const uint16_t reqId, string &reply)
+{
+    char data[RECV_BUFF_LEN];
+    while(true)
+	{
+	    while(!buff.empty())
+		{
+		    if(static_cast<uint8_t>(buff[0]) != FRAME_MAGIC)
+			{
+			    const size_t eol = buff.find('\n');
+			    if(eol == string::npos)
+				break;
+			    buff.erase(0, eol + 1);
+			    continue;
+			}
+		    if(buff.size() < FRAME_HEADER_LEN)
+			break;
+		    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(buff.data());
+		    const size_t frameLen = 3 + ((bytes[1] << 8) | bytes[2]);
+		    if(buff.size() < frameLen)
+			break;
+
+		    const bool isReply = (bytes[5] == REPLY_OPCODE) && (((bytes[3] << 8) | bytes[4]) == reqId);
+		    if(isReply)
+			{
+			    reply.clear();
+			    for(size_t pos = FRAME_HEADER_LEN; pos < frameLen; )
+				{
+				    const size_t paramLen = bytes[pos++];
+				    if(!reply.empty())
+					reply += ' ';
+				    reply.append(buff, pos, paramLen);
+				    pos += paramLen;
+				}
+			}
+		    buff.erase(0, frameLen);
+		    if(isReply)
+			return true;
+		}
+
+	    const ssize_t len = recv(sockDescr, data, sizeof(data), 0);
+	    if(len <= 0)
+		return false;
+	    buff.append(data, len);
+	}
+}
+
+/**
+ * Send the commands of the mix by a connection until the end of the measurement.
+ * The commands of the mix are sent in turn, every one is repeated by its weight.
+ * The changes of the system's sound are undone by the next sending of the same command:
+ * the volume is increased and decreased by turns, the mute command is followed by the unmute one.
+ * The latency is measured from the time the request has been scheduled to, so the delays of the previous replies are counted too
+ * @param options The options of the measurement
+ * @param mix The mix of the commands
+ * @param sockDescr The socket's descriptor of the connection
+ * @param index The index of the connection
+ * @param start The time of the measurement's start
+ * @param result The results of the connection
+ */
+void runConnection(const BenchOptions &options, const vector<MixEntry> &mix, const int sockDescr, const unsigned int index,
+		   const TimePoint start, ConnectionResult &result)
+{
+    vector<string> schedule;
+    for(vector<MixEntry>::const_iterator it = mix.begin(); it != mix.end(); ++it)
+	schedule.insert(schedule.end(), it->weight, it->name);
+    rotate(schedule.begin(), schedule.begin() + index % schedule.size(), schedule.end());
+
+    const duration<double> interval((options.rate > 0) ? options.connectionsNum / options.rate: 0);
+    const TimePoint end = start + seconds(options.durationSec);
+
+    string buff;
+    bool isVolIncreased = false, isMuted = false;
+    uint16_t reqId = 0;
+    for(unsigned long requestsNum = 0; ; requestsNum++)
+	{
+	    TimePoint scheduled = start + duration_cast<steady_clock::duration>(interval * static_cast<double>(requestsNum));
+	    if(scheduled >= end)
+		break;
+	    if(options.rate > 0)
+		this_thread::sleep_until(scheduled);
+	    else
+		scheduled = steady_clock::now();
+	    if(scheduled >= end)
+		break;
+
+	    const string &name = schedule[requestsNum % schedule.size()];
+	    string frame;
+	    ++reqId;
+	    if(name == CHG_VOL)
+		{
+		    isVolIncreased = !isVolIncreased;
+		    frame = buildCommandFrame(reqId, CHG_VOL_OPCODE, isVolIncreased ? "1": "-1");
+		}
+	    else if(name == MUTE)
+		{
+		    isMuted = !isMuted;
+		    frame = buildCommandFrame(reqId, isMuted ? MUTE_OPCODE: UNMUTE_OPCODE, "");
+		}
+	    else
+		frame = buildCommandFrame(reqId, (name == HELLO) ? HELLO_OPCODE: GET_VOL_OPCODE, "");
+
+	    string reply;
+	    if( (::send(sockDescr, frame.data(), frame.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(frame.size())) ||
+		!waitReply(sockDescr, buff, reqId, reply) )
+		{
+		    result.isFailed = true;
+		    result.failure  = string("The connection to the daemon is broken: ") + ((errno != 0) ? strerror(errno): "closed");
+		    break;
+		}
+	    result.latencies[name].push_back(duration<double, micro>(steady_clock::now() - scheduled).count());
+	    if(reply == ERR)
+		++result.errorsNum;
+	}
+}
+
+/**
+ * Get the percentile of the sorted latencies by the nearest rank
+ * @param latencies The sorted latencies
+ * @param percent The percent of the percentile
+ * @return The percentile or 0 if there are no latencies
+ */
+double getPercentile(const vector<double> &latencies, const double percent)
+{
+    if(latencies.empty())
+	return 0;
+    size_t rank = static_cast<size_t>(percent / 100 * latencies.size() + 0.999999);
+    rank = max<size_t>(rank, 1);
+    return latencies[min(rank, latencies.size()) - 1];
+}
+
+/**
+ * Write the statistics of the latencies as a JSON object
+ * @param out The output stream
+ * @param latencies The sorted latencies
+ * @param durationSec The duration of the measurement
+ */
+void writeJsonStats(ostream &out, const vector<double> &latencies, const double durationSec)
+{
+    out << "{\"requests\":" << latencies.size()
+	<< ",\"throughput\":" << latencies.size() / durationSec
+	<< ",\"p50_us\":"     << getPercentile(latencies, 50)
+	<< ",\"p99_us\":"     << getPercentile(latencies, 99)
+	<< ",\"p999_us\":"    << getPercentile(latencies, 99.9)
+	<< ",\"max_us\":"     << (latencies.empty() ? 0: latencies.back()) << "}";
+}
+
+/**
+ * Write the statistics of the latencies as a line of the text report
+ * @param out The output stream
+ * @param name The name of the statistics
+ * @param latencies The sorted latencies
+ * @param durationSec The duration of the measurement
+ */
+void writeTextStats(ostream &out, const string &name, const vector<double> &latencies, const double durationSec)
+{
+    char line[160];
+    snprintf(line, sizeof(line), "%-10s %10zu %12.1f %10.1f %10.1f %10.1f %10.1f",
+	     name.c_str(), latencies.size(), latencies.size() / durationSec, getPercentile(latencies, 50),
+	     getPercentile(latencies, 99), getPercentile(latencies, 99.9), latencies.empty() ? 0: latencies.back());
+    out << line << endl;
+}
+
+/**
+ * Run the measurement and write its reports
+ * @param argc The number of the arguments
+ * @param argv The arguments, see printUsage()
+ * @return 0 The measurement has been done without failures
+ */
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+    vector<MixEntry> mix;
+    if(!parseOptions(argc, argv, options))
+	{
+	    printUsage(argv[0]);
+	    return 1;
+	}
+    if(!parseMix(options.mix, mix))
+	return 1;
+
+    // the connections are opened before the start, so the time of accepting them isn't measured
+    vector<int> sockDescrs;
+    for(unsigned int i = 0; i < options.connectionsNum; i++)
+	{
+	    const int sockDescr = connectToDaemon(options.host, options.port);
+	    if(sockDescr == -1)
+		{
+		    cerr << "ERROR: Can't connect to the daemon " << options.host << ":" << options.port << endl;
+		    for_each(sockDescrs.begin(), sockDescrs.end(), close);
+		    return 1;
+		}
+	    sockDescrs.push_back(sockDescr);
+	}
+
+    vector<ConnectionResult> results(options.connectionsNum);
+    vector<thread> threads;
+    const TimePoint start = steady_clock::now();
+    for(unsigned int i = 0; i < options.connectionsNum; i++)
+	threads.push_back(thread(runConnection, cref(options), cref(mix), sockDescrs[i], i, start, ref(results[i])));
+    for(vector<thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+	it->join();
+    for_each(sockDescrs.begin(), sockDescrs.end(), close);
+    const double durationSec = duration<double>(steady_clock::now() - start).count();
+
+    vector<double> all;
+    map<string, vector<double>> byCommand;
+    unsigned long errorsNum = 0, failedNum = 0;
+    for(vector<ConnectionResult>::const_iterator res = results.begin(); res != results.end(); ++res)
+	{
+	    for(map<string, vector<double>>::const_iterator it = res->latencies.begin(); it != res->latencies.end(); ++it)
+		{
+		    byCommand[it->first].insert(byCommand[it->first].end(), it->second.begin(), it->second.end());
+		    all.insert(all.end(), it->second.begin(), it->second.end());
+		}
+	    errorsNum += res->errorsNum;
+	    if(res->isFailed)
+		{
+		    ++failedNum;
+		    cerr << "ERROR: " << res->failure << endl;
+		}
+	}
+    sort(all.begin(), all.end());
+    for(map<string, vector<double>>::iterator it = byCommand.begin(); it != byCommand.end(); ++it)
+	sort(it->second.begin(), it->second.end());
+
+    cout << "Connections: " << options.connectionsNum << ", target rate: " << options.rate << " req/s, duration: "
+	 << durationSec << " s, mix: " << options.mix << endl;
+    cout << "Errors: " << errorsNum << ", failed connections: " << failedNum << endl;
+    char header[160];
+    snprintf(header, sizeof(header), "%-10s %10s %12s %10s %10s %10s %10s",
+	     "command", "requests", "req/s", "p50(us)", "p99(us)", "p999(us)", "max(us)");
+    cout << header << endl;
+    for(map<string, vector<double>>::const_iterator it = byCommand.begin(); it != byCommand.end(); ++it)
+	writeTextStats(cout, it->first, it->second, durationSec);
+    writeTextStats(cout, "total", all, durationSec);
+
+    ofstream json(options.jsonFile.c_str());
+    if(!json)
+	{
+	    cerr << "ERROR: Can't open the file " << options.jsonFile << endl;
+	    return 1;
+	}
+    json << "{\"connections\":" << options.connectionsNum << ",\"target_rate\":" << options.rate
+	 << ",\"duration_s\":" << durationSec << ",\"mix\":\"" << options.mix << "\",\"errors\":" << errorsNum
+	 << ",\"failed_connections\":" << failedNum << ",\"total\":";
+    writeJsonStats(json, all, durationSec);
+    json << ",\"commands\":{";
+    for(map<string, vector<double>>::const_iterator it = byCommand.begin(); it != byCommand.end(); ++it)
+	{
+	    json << ((it == byCommand.begin()) ? "": ",") << "\"" << it->first << "\":";
+	    writeJsonStats(json, it->second, durationSec);
+	}
+    json << "}}" << endl;
+    cout << "The JSON report: " << options.jsonFile << endl;
+
+    return (failedNum == 0) ? 0: 1;
+}
@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# Measuring the latency of the WiFi daemon by the load generator
+# The daemon is run on the given port, the load generator connects to it by loopback
+# and the daemon is stopped after the measurement
+# The sound backend of the daemon is given by SOUND_BACKEND: alsa or mem[:LATENCY_US], the in-memory one by default
+
+if [ $# -lt 1 ]; then
+    echo "Should be: $0 port_num [load generator's options]"
+    exit 1
+fi
+
+PORT=$1
+shift
+
+PROG_NAME=vol_daemon
+BENCH_NAME=vol_bench
+STOP_SCRIPT=stop.sh
+SOUND_BACKEND=${SOUND_BACKEND:-mem}
+
+if [ -n "`pgrep $PROG_NAME`" ]; then
+    echo "The daemon $PROG_NAME is running already, stop it before the measurement"
+    exit 1
+fi
+
+echo "Running the daemon on the port $PORT with the sound backend $SOUND_BACKEND..."
+./$PROG_NAME --sound=$SOUND_BACKEND wifi $PORT
+
+for i in `seq 1 10`; do
+    (echo -n > /dev/tcp/127.0.0.1/$PORT) 2>/dev/null && break || sleep 1;
+done
+
+./$BENCH_NAME -p $PORT "$@"
+RESULT=$?
+
+./$STOP_SCRIPT
+exit $RESULT
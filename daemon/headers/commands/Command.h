@@ -30,12 +30,24 @@
 #define HEADER_COMMAND
 
 #include <string>
-#include <list>
 
 #include "CommandsNames.h"
 
 using namespace std;
 
+#define COMMAND_PARAMS_MAX_NUM 4        /**< The maximal number of a command's parameters */
+
+/**
+ * \struct CommandParams
+ * \brief The parameters of a command. The strings point into the buffer
+ * the command's string has been parsed in, so they aren't copied
+ */
+struct CommandParams
+{
+    const char *strs[COMMAND_PARAMS_MAX_NUM];    /**< The null terminated strings of the parameters */
+    size_t num;                                  /**< The number of the parameters */
+};
+
 /**
  * The abstract class of a command
  */
@@ -49,11 +61,11 @@ class Command
     virtual string execute() = 0;
 
     /**
-     * Execute command with the given list of parameters
-     * @param params The list of the parameters' strings
+     * Execute command with the given parameters
+     * @param params The parameters' strings
      * @return The string of execution result
      */
-    virtual string execute(const list<string> &params) const = 0;
+    virtual string execute(const CommandParams &params) const = 0;
 
     /**
      * Destructor
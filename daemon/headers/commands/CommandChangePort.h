@@ -65,11 +65,11 @@ class CommandChangePort : public Command
     CommandChangePort(CommandsDispatcher &dispatcher) throw (invalid_argument&): dispatcher_(dispatcher) {}
 
     /**
-     * Execute command with the given list of parameters
-     * @param params The list of the parameters'' strings
+     * Execute command with the given parameters
+     * @param params The parameters'' strings
      * @return The string of execution result     
      */
-    string execute(const list<string> &params) const;
+    string execute(const CommandParams &params) const;
 };
 
 #endif
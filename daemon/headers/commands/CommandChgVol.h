@@ -63,11 +63,11 @@ class CommandChgVol: public Command
     string execute() { cerr << "The command hasn't executed\n"; return ERR; }
 
     /**
-     * Execute command with the given list of parameters
-     * @param params The list of the parameters' strings
+     * Execute command with the given parameters
+     * @param params The parameters' strings
      * @return The string of execution result
      */
-    string execute(const list<string> &params) const;
+    string execute(const CommandParams &params) const;
 };
 
 
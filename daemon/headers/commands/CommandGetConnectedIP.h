@@ -34,11 +34,12 @@
 #include "NetConnector.h"
 
 /**
- * Command for getting the IP of a connected client
+ * Command for getting the IP of the connected client which has sent the command
  */
 class CommandGetConnectedIP: public Command
 {
     NetConnector &netConnector_;                /**< The reference to the network connector */
+    const int &clientID_;                       /**< The reference to the ID of the network client whose command is executed, -1 if there is no one */
 
     CommandGetConnectedIP() = delete;
 
@@ -46,8 +47,9 @@ class CommandGetConnectedIP: public Command
     /**
      * Constructor
      * @param connector The network connector's reference for initializing the local one
+     * @param clientID The reference to the ID of the network client whose command is executed, it's set by the dispatcher
      */
-    CommandGetConnectedIP(NetConnector &connector): netConnector_(connector) {}
+    CommandGetConnectedIP(NetConnector &connector, const int &clientID): netConnector_(connector), clientID_(clientID) {}
 
     /**
      * Destructor
@@ -61,11 +63,11 @@ class CommandGetConnectedIP: public Command
     std::string execute();
 
     /**
-     * Execute command with the given list of parameters
-     * @param params The list of the parameters'' strings
+     * Execute command with the given parameters
+     * @param params The parameters'' strings
      * @return The string of execution result     
      */
-    std::string execute(const list<std::string> &params) const { std::cerr << "The command mute with parameters hasn't implemented\n";
+    std::string execute(const CommandParams &params) const { std::cerr << "The command mute with parameters hasn't implemented\n";
     													   return OK; };
 };
 
@@ -63,11 +63,11 @@ class CommandGetCurVol: public Command
     std::string execute();
 
     /**
-     * Execute command with the given list of parameters
-     * @param params The list of the parameters'' strings
+     * Execute command with the given parameters
+     * @param params The parameters'' strings
      * @return The string of execution result     
      */    
-    std::string execute(const std::list<std::string> &params) const { std::cerr << "The command 'execute' with parameters hasn't executed\n";
+    std::string execute(const CommandParams &params) const { std::cerr << "The command 'execute' with parameters hasn't executed\n";
 	                                                              return ERR; }
 };
 
@@ -61,11 +61,11 @@ class CommandHello: public Command
     std::string execute();
 
     /**
-     * Execute command with the given list of parameters
-     * @param params The list of the parameters'' strings
+     * Execute command with the given parameters
+     * @param params The parameters'' strings
      * @return The string of execution result     
      */    
-    std::string execute(const list<std::string> &params) const { std::cerr << "The command hello with parameters hasn't implemented\n";
+    std::string execute(const CommandParams &params) const { std::cerr << "The command hello with parameters hasn't implemented\n";
     								   return OK; };
 };
 
@@ -0,0 +1,67 @@
+/**
+ * Command to get or change the level of the daemon's log
+ * @file
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef COMMANDLOGLEVEL_H_
+#define COMMANDLOGLEVEL_H_
+
+#include "Command.h"
+
+/**
+ * Command to get or change the level of the daemon's log.
+ * The messages of the levels lower than the current one aren't written
+ */
+class CommandLogLevel : public Command
+{
+    static const char* TAG;                      /**< The tag for writing to log file */
+
+ public:
+    /**
+     * Constructor
+     */
+    CommandLogLevel() {}
+
+    /**
+     * Destructor
+     */
+    ~CommandLogLevel() {}
+
+    /**
+     * Get the name of the current level of the log
+     * @return The name of the level: trace, debug, info, warn or error
+     */
+    std::string execute();
+
+    /**
+     * Change the level of the log to the level with the given name
+     * @param params The parameters' strings, the first one is the name of the level
+     * @return The string of execution result: OK or ERR
+     */
+    std::string execute(const CommandParams &params) const;
+};
+
+#endif
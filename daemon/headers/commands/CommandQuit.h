@@ -63,11 +63,11 @@ class CommandQuit: public Command
     std::string execute() { dispatcher_.stop();
 	                    return OK; }
     /**
-     * Execute command with the given list of parameters
-     * @param params The list of the parameters'' strings
+     * Execute command with the given parameters
+     * @param params The parameters'' strings
      * @return The string of execution result     
      */
-    std::string execute(const std::list<std::string> &params) const { std::cerr << "The command mute with parameters hasn't implemented\n";
+    std::string execute(const CommandParams &params) const { std::cerr << "The command mute with parameters hasn't implemented\n";
     								      return OK; };
 };
 
@@ -0,0 +1,74 @@
+/**
+ * @file
+ * The command getting the metrics of the commands and of the connectors
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef COMMANDSTATS_H_
+#define COMMANDSTATS_H_
+
+#include "Command.h"
+
+class Metrics;
+
+/**
+ * Command to get the metrics recorded by the dispatcher.
+ * Without a parameter it gets the totals: the number of the executed commands, of the ERR results, of the queued commands and its maximum.
+ * The parameter is the name of a command: the number of the executions, of the ERR results, p50, p99, p999 and max latency in microseconds,
+ * or the name of a connector(net, gui, snd): the received bytes, the sent bytes, the number of the queued commands and its maximum
+ */
+class CommandStats : public Command
+{
+    const Metrics &metrics_;                     /**< The metrics of the dispatcher */
+
+    static const char* TAG;                      /**< The tag for writing to log file */
+
+ public:
+    /**
+     * Constructor
+     * @param metrics The metrics of the dispatcher
+     */
+    CommandStats(const Metrics &metrics): metrics_(metrics) {}
+
+    /**
+     * Destructor
+     */
+    ~CommandStats() {}
+
+    /**
+     * Get the totals of the commands
+     * @return The numbers separated by spaces
+     */
+    std::string execute();
+
+    /**
+     * Get the metrics of the command or of the connector with the given name
+     * @param params The parameters' strings, the first one is the name
+     * @return The numbers separated by spaces or ERR if there is nothing with the given name
+     */
+    std::string execute(const CommandParams &params) const;
+};
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * @file
+ * Command to control the tracing of the requests' hops
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef COMMANDTRACE_H_
+#define COMMANDTRACE_H_
+
+#include "Command.h"
+
+/**
+ * Command to control the tracing of the requests' hops through the connectors, the dispatcher and the sound threads.
+ * Without a parameter it gets the state of the tracing: on or off.
+ * The parameter on/off enables/disables the tracing, dump writes the kept spans to the trace file
+ * as the Chrome trace events' JSON, clear forgets them
+ */
+class CommandTrace : public Command
+{
+    static const char* TAG;                      /**< The tag for writing to log file */
+
+ public:
+    /**
+     * Constructor
+     */
+    CommandTrace() {}
+
+    /**
+     * Destructor
+     */
+    ~CommandTrace() {}
+
+    /**
+     * Get the state of the tracing
+     * @return The string of the state: on or off
+     */
+    std::string execute();
+
+    /**
+     * Enable, disable, dump or clear the tracing
+     * @param params The parameters' strings, the first one is on, off, dump or clear
+     * @return The string of execution result: OK or ERR
+     */
+    std::string execute(const CommandParams &params) const;
+};
+
+#endif
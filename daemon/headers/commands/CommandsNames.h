@@ -41,12 +41,68 @@
 #define QUIT         "quit"              /**< Quit */
 #define CHG_VOL      "chg_vol"           /**< Change the current volume of the system sound */
 #define GET_VOL      "get_vol"           /**< Get the current volume of the system sound */ 
+#define SET_VOL      "set_vol"           /**< Set the current volume of the system sound */
 #define HELLO        "hello"             /**< Hello */
+#define LOG_LEVEL    "log_level"         /**< Get or change the level of the log: trace, debug, info, warn or error */
+#define STATS        "stats"             /**< Get the metrics of a command or of a connector(net, gui, snd), the totals without a parameter */
+#define TRACE        "trace"             /**< Get the tracing state, turn it on or off, dump the traces or clear them */
+
+#define BATCH_SEPARATOR ';'             /**< The separator of the commands of a batch arrived in one message */
 
 #define ERR	     "ERR"               /**< Error - is the response to a command */
 #define OK           "OK"                /**< OK - is the response to a command */
 #define TRUE_        "true"              /**< true - is the response to a command */
 #define FALSE_       "false"             /**< false - is the response to a command */
 
+/**
+ * The opcodes of the commands in the binary frames of the network protocol
+ */
+#define REPLY_OPCODE        0            /**< The frame of a reply to a command */
+#define HELLO_OPCODE        1            /**< HELLO */
+#define GET_PORT_OPCODE     2            /**< GET_PORT */
+#define CHG_PORT_OPCODE     3            /**< CHG_PORT */
+#define MUTE_OPCODE         4            /**< MUTE */
+#define IS_MUTED_OPCODE     5            /**< IS_MUTED */
+#define UNMUTE_OPCODE       6            /**< UNMUTE */
+#define LOCAL_IP_OPCODE     7            /**< LOCAL_IP */
+#define CONNECTED_IP_OPCODE 8            /**< CONNECTED_IP */
+#define QUIT_OPCODE         9            /**< QUIT */
+#define CHG_VOL_OPCODE      10           /**< CHG_VOL */
+#define GET_VOL_OPCODE      11           /**< GET_VOL */
+#define LOG_LEVEL_OPCODE    12           /**< LOG_LEVEL */
+#define SET_VOL_OPCODE      13           /**< SET_VOL */
+#define STATS_OPCODE        14           /**< STATS */
+#define TRACE_OPCODE        15           /**< TRACE */
+#define COMMANDS_OPCODES_NUM 16          /**< The number of the commands' opcodes */
+#define NO_OPCODE           -1           /**< There is no command with the given name */
+#define NOTIFICATION_OPCODE 255          /**< The frame of a notification */
+
+/**
+ * The initializer of the array of the commands' names indexed by their opcodes
+ */
+#define COMMANDS_NAMES_BY_OPCODES { NULL, HELLO, GET_PORT, CHG_PORT, MUTE, IS_MUTED, UNMUTE, \
+				    LOCAL_IP, CONNECTED_IP, QUIT, CHG_VOL, GET_VOL, LOG_LEVEL, SET_VOL, STATS, TRACE }
+
+#define VOL_CHANGED  "vol"               /**< The notification of the changed volume, followed by the volume value */
+#define MUTED        "muted"             /**< The notification of the muted system sound */
+#define UNMUTED      "unmuted"           /**< The notification of the unmuted system sound */
+
+#ifdef __cplusplus
+#include <stddef.h>
+
+/**
+ * Get the FNV-1a hash of the given command's name.
+ * It's computed at compile time for the names above, so they can be the labels of a switch
+ * and the compiler rejects the names having the same hash
+ * @param name The name, it needn't be null terminated
+ * @param len The length of the name
+ * @param hash The hash of the previous characters of the name
+ * @return The hash of the name
+ */
+constexpr unsigned int hashCommandName(const char *name, const size_t len, const unsigned int hash = 2166136261u)
+{
+    return (len == 0) ? hash: hashCommandName(name + 1, len - 1, (hash ^ static_cast<unsigned char>(*name)) * 16777619u);
+}
+#endif
 
 #endif
@@ -0,0 +1,121 @@
+/**
+ * @file
+ * The sound backend controlling the ALSA mixer
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef ALSASOUNDBACKEND_H_
+#define ALSASOUNDBACKEND_H_
+
+#include "SoundBackend.h"
+
+#include <mutex>
+
+struct SoundControl;
+
+/**
+ * The backend controlling the Master element of the default ALSA card by the sound library
+ */
+class AlsaSoundBackend: public SoundBackend
+{
+    struct SoundControl *soundControl_;      /**< The session of the sound system mixer */
+
+    std::mutex controlMutex_;                /**< The mutex of the session, it's used by the commands and by the connector's thread */
+
+ public:
+    /**
+     * Constructor
+     * Opens the session of the mixer, the card is attached lazily
+     */
+    AlsaSoundBackend();
+
+    /**
+     * Destructor
+     */
+    ~AlsaSoundBackend();
+
+    /**
+     * Set the function which should be called when the volume or the mute state has changed
+     * @param callback The function or NULL
+     * @param context The context which the function should be called with
+     */
+    void setChangedCallback(ChangedCallback callback, void *context);
+
+    /**
+     * Get the descriptors which should be polled for the events of the mixer.
+     * Attaches the mixer if it isn't attached yet
+     * @param descrs The array for the descriptors
+     * @param space The length of the array
+     * @return The number of the descriptors, 0 if the mixer isn't attached
+     */
+    const unsigned int getDescrs(struct pollfd *descrs, const unsigned int space);
+
+    /**
+     * Handle the events of the polled mixer descriptors. The changed callback is called from here
+     * @param descrs The polled descriptors
+     * @param descrsNum The number of the descriptors
+     */
+    void handleEvents(struct pollfd *descrs, const unsigned int descrsNum);
+
+    /**
+     * Make the sound state muted
+     * @return true The sound state is muted
+     */
+    const bool mute();
+
+    /**
+     * Unmute the sound state
+     * @return true The sound state is unmuted
+     */
+    const bool unmute();
+
+    /**
+     * Change the current volume by the given value
+     * @param value The value of the change in percents, negative for decreasing
+     * @return true The volume has been changed
+     */
+    const bool chgVol(const int value);
+
+    /**
+     * Set the current volume to the given value
+     * @param value The value of the volume in percents
+     * @return true The volume has been set
+     */
+    const bool setVol(const int value);
+
+    /**
+     * Get the current volume
+     * @return The current volume percents
+     */
+    const long getVol();
+
+    /**
+     * Is the sound state muted
+     * @return true The sound state is muted
+     */
+    const bool isMuted();
+};
+
+#endif
@@ -4,9 +4,9 @@
  * The target of the connector is to receive a data
  * and to send one.
  * E.g. network connector is for connecting data between
- * command dispatcher and network. When the dispatcher
- * wants to receive a data from network it calls to the
- * function receive() of the connector. If the dispatcher
+ * command dispatcher and network. When a data arrives from
+ * network the connector pushes it into the commands queue
+ * of the dispatcher. If the dispatcher
  * wants to send a data to network it calls the function
  * send() of the connector.
  *
@@ -39,6 +39,7 @@
 
 #include <string>
 
+class CommandsQueue;
 
 /**
  * The target of the connector to connect some item(GUI, sound system or network)
@@ -47,18 +48,41 @@
  */
 class Connector
 {
+protected:
+
+    CommandsQueue *commandsQueue_;     /**< The queue the arrived commands should be pushed into */
+
 public:
 
+    /**
+     * Constructor
+     */
+    Connector(): commandsQueue_(NULL) {}
+
     /**
      * Destructor
      */
     virtual ~Connector() {}
+
+    /**
+     * Set the queue the arrived commands should be pushed into
+     * @param commandsQueue The queue of commands
+     */
+    void setCommandsQueue(CommandsQueue *commandsQueue) { commandsQueue_ = commandsQueue; }
     
     /**
      * Send data string to connector
      * @param dataStr The string of the sent data
+     * @param clientID The ID of the client the data should be sent to
+     * @param requestID The ID of the client's request the data replies to, -1 if the request has no ID
+     */
+    virtual void send(const std::string &dataStr, const int clientID, const int requestID) = 0;
+
+    /**
+     * Send the notification string to all the clients of the connector
+     * @param dataStr The string of the notification
      */
-    virtual void send(const std::string &dataStr) = 0;
+    virtual void notify(const std::string &dataStr) {}
     
     /**
      * Get a data string arrived to the connector
@@ -37,6 +37,16 @@
 
 using namespace std;
 
+/**
+ * \struct BtLibFuncs
+ * \brief The functions of the bluetooth library resolved once at the connector's startup
+ */
+struct BtLibFuncs
+{
+    const char* (*getLocalAddr)();            /**< Get the name of the local adapter, its address if the name isn't resolved */
+    const char* (*getConnectedAddr)();        /**< Get the name of the connected device, NULL if it isn't resolved */
+};
+
 /**
  * The class should send, receive string data between the daemon and a connected clint,
  * make port operations
@@ -49,13 +59,40 @@ class ConnectorBT: public NetConnector
     
     int socketDescr;                          /**< The currently used socket descriptor */
 
+    void *btLibHandle_;                       /**< The handle of the loaded bluetooth library or NULL */
+    BtLibFuncs btLibFuncs_;                   /**< The functions resolved from the bluetooth library */
+
     /**
-     * Call to the function from a dynamic library
-     * @param funcName The name of the function
+     * Push the arrived data into the commands queue.
+     * Called by the connection library when a new data has arrived
+     * @param connId The ID of the connection the data arrived from
+     * @param reqId The ID of the client's request or NO_REQUEST
+     * @param dataStr The string of the arrived data
+     * @param context The pointer to the connector instance
+     */
+    static void onDataArrived(const int connId, const int reqId, const char *dataStr, void *context);
+
+    /**
+     * Load the bluetooth library and resolve its functions.
+     * If the library or a function is missing, the function isn't resolved and the address queries return ""
      * @param libName The name of the library
-     * @return The string result of the function
      */
-    const char* callToFuncFromDynLib(const char *funcName, const char *libName) const;
+    void loadBtLib(const char *libName);
+
+    /**
+     * Resolve the function of the loaded bluetooth library
+     * @param funcName The name of the function
+     * @return The pointer to the function or NULL
+     */
+    void* getBtLibFunc(const char *funcName) const;
+
+    /**
+     * Call to the resolved function returning a string
+     * @param func The function or NULL
+     * @param funcName The name of the function for logging
+     * @return The string result of the function or "" if the function isn't resolved
+     */
+    const string callToBtLibFunc(const char* (*func)(), const char *funcName) const;
 
  public:
 
@@ -65,9 +102,9 @@ class ConnectorBT: public NetConnector
     ConnectorBT();
     
     /**
-     * Destructor
+     * Destructor. Unloads the bluetooth library
      */
-    ~ConnectorBT() {}
+    ~ConnectorBT();
 
     /**
      * Run the connector
@@ -83,8 +120,16 @@ class ConnectorBT: public NetConnector
     /**
      * Send data string to connector
      * @param dataStr The string of the sent data
+     * @param clientID The ID of the client the data should be sent to
+     * @param requestID The ID of the client's request the data replies to
      */    
-    void send(const string &dataStr);
+    void send(const string &dataStr, const int clientID, const int requestID);
+
+    /**
+     * Send the notification string to all the connected clients
+     * @param dataStr The string of the notification
+     */
+    void notify(const string &dataStr);
 
     /**
      * Get a data string arrived to the connector
@@ -104,10 +149,11 @@ class ConnectorBT: public NetConnector
     const string getLocalAddrStr()     const;
 
     /**
-     * Get the string of the connected address
+     * Get the string of the connected address, there is one connected client only
+     * @param clientID The ID of the client, it's ignored
      * @return The string of the address
      */
-    const string getConnectedAddrStr() const;
+    const string getConnectedAddrStr(const int clientID) const;
 
     /**
      * Get the last error string
@@ -32,6 +32,7 @@
 #include <string>
 #include <thread>
 #include <mutex>
+#include <functional>
 #include "PortException.h"
 #include "NetConnector.h"
 
@@ -49,7 +50,28 @@ class ConnectorWiFi: public NetConnector
 
     mutex mutex_;
     
-    int socketDescr;                          /**< The currently used socket descriptor */ 
+    int socketDescr;                          /**< The currently used socket descriptor */
+
+    function<const string()> discoveryInfoProvider_;   /**< The provider of the daemon's info for the discovery replies */
+
+    /**
+     * Push the arrived data into the commands queue.
+     * Called by the connection library when a new data has arrived
+     * @param connId The ID of the connection the data arrived from
+     * @param reqId The ID of the client's request or NO_REQUEST
+     * @param dataStr The string of the arrived data
+     * @param context The pointer to the connector instance
+     */
+    static void onDataArrived(const int connId, const int reqId, const char *dataStr, void *context); 
+
+    /**
+     * Add the daemon's info to the reply to the discovery probe.
+     * Called by the connection library when a discovery probe has arrived
+     * @param info The buffer for the info's text
+     * @param len The length of the buffer
+     * @param context The pointer to the connector instance
+     */
+    static void onDiscoveryProbe(char *info, const size_t len, void *context);
 
     ConnectorWiFi() = delete;
 
@@ -66,13 +88,43 @@ class ConnectorWiFi: public NetConnector
      */
     void processPortNumErr(const string &errStr) const throw(PortException);
 
+    /**
+     * Check the given string of the port number of the datagrams
+     * @param portNum The string of the port number or ""
+     */
+    void checkDatagramPortNum(const string &portNum) const throw(PortException);
+
  public:
 
     /**
      * Constructor
      * @param portNum The string of a port number
+     * @param volPortNum The string of the port number of the volume's datagrams or "" if they aren't received
+     * @param discoveryPortNum The string of the port number of the discovery probes or "" if they aren't answered
+     */
+    inline ConnectorWiFi(const string &portNum, const string &volPortNum = "", const string &discoveryPortNum = "")  throw(PortException)
+	{ setPortNum(portNum); setVolPortNum(volPortNum); setDiscoveryPortNum(discoveryPortNum); }
+
+    /**
+     * Set the port number of the volume's datagrams.
+     * The set_vol and chg_vol commands can arrive by UDP datagrams, the stale ones are dropped
+     * @param portNum The string of the port number or "" if the datagrams shouldn't be received
+     */
+    void setVolPortNum(const string &portNum) throw(PortException);
+
+    /**
+     * Set the port number of the discovery probes.
+     * The probes from the LAN are answered by the daemon's address and info
+     * @param portNum The string of the port number or "" if the probes shouldn't be answered
      */
-    inline ConnectorWiFi(const string &portNum)  throw(PortException) { setPortNum(portNum); }
+    void setDiscoveryPortNum(const string &portNum) throw(PortException);
+
+    /**
+     * Set the provider of the daemon's info added to the replies to the discovery probes.
+     * Should be called before running the connector
+     * @param provider The function returning the space separated "NAME=VALUE" pairs
+     */
+    void setDiscoveryInfoProvider(const function<const string()> &provider) { discoveryInfoProvider_ = provider; }
 
     /**
      * Destructor
@@ -93,8 +145,16 @@ class ConnectorWiFi: public NetConnector
     /**
      * Send data string to connector
      * @param dataStr The string of the sent data
+     * @param clientID The ID of the client the data should be sent to
+     * @param requestID The ID of the client's request the data replies to
      */    
-    void send(const string &dataStr);
+    void send(const string &dataStr, const int clientID, const int requestID);
+
+    /**
+     * Send the notification string to all the connected clients
+     * @param dataStr The string of the notification
+     */
+    void notify(const string &dataStr);
 
     /**
      * Get a data string arrived to the connector
@@ -115,9 +175,10 @@ class ConnectorWiFi: public NetConnector
 
     /**
      * Get the string of the connected IP
+     * @param clientID The ID of the client or -1 for the last connected client
      * @return The string of the IP
      */
-    const string getConnectedAddrStr() const;
+    const string getConnectedAddrStr(const int clientID) const;
 
     /**
      * Get the string of the currently used port number
@@ -51,6 +51,15 @@ class GuiConnector: public Connector
      */
     bool isStopped();                   
 
+    /**
+     * Push the arrived message into the commands queue.
+     * Called by the messages queue when a new message has arrived
+     * @param clientID The ID of the GUI client the message has arrived from
+     * @param msgTxt The text of the message
+     * @param context The pointer to the connector instance
+     */
+    static void onMsgArrived(const int clientID, const char *msgTxt, void *context);
+
 public:
     /**
      * Constructor
@@ -75,14 +84,23 @@ public:
     /**
      * Send data string to connector
      * @param newDataStr The string of the sent data
+     * @param clientID The ID of the client the data should be sent to
+     * @param requestID The ID of the client's request the data replies to
      */    
-    void send(const std::string &newDataStr);
+    void send(const std::string &newDataStr, const int clientID, const int requestID);
+
+    /**
+     * Send the notification string to GUI
+     * @param dataStr The string of the notification
+     */
+    void notify(const std::string &dataStr);
 
     /**
-     * Get a data string arrived to the connector
-     * @return The arrived data string
+     * Get a data string arrived to the connector.
+     * The arrived messages are passed to the commands queue, so there is no data for receiving
+     * @return The empty string
      */    
-    const std::string receive();
+    const std::string receive() { return ""; }
 };
 
 #endif
@@ -0,0 +1,129 @@
+/**
+ * @file
+ * The sound backend keeping the volume in memory, for measuring the daemon without a sound card
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MEMSOUNDBACKEND_H_
+#define MEMSOUNDBACKEND_H_
+
+#include "SoundBackend.h"
+
+#include <atomic>
+
+/**
+ * The in-memory mixer. The volume and the mute state are atomic, so the operations don't lock.
+ * The given latency is added to every operation to imitate the cost of a real mixer
+ */
+class MemSoundBackend: public SoundBackend
+{
+    std::atomic<long> volume_;               /**< The current volume percents */
+    std::atomic<bool> muted_;                /**< Is the sound state muted */
+
+    const unsigned int latencyUs_;           /**< The delay of every operation in microseconds */
+
+    ChangedCallback callback_;               /**< The function called when the volume or the mute state has changed */
+    void *callbackContext_;                  /**< The context of the callback */
+
+    /**
+     * Wait for the latency of the operation
+     */
+    void delay() const;
+
+    /**
+     * Call the changed callback with the current state
+     */
+    void notifyChanged();
+
+ public:
+    /**
+     * Constructor
+     * @param latencyUs The delay added to every operation in microseconds
+     */
+    MemSoundBackend(const unsigned int latencyUs = 0);
+
+    /**
+     * Set the function which should be called when the volume or the mute state has changed.
+     * It's called by the thread which has changed the state
+     * @param callback The function or NULL
+     * @param context The context which the function should be called with
+     */
+    void setChangedCallback(ChangedCallback callback, void *context);
+
+    /**
+     * There are no descriptors, the state is changed only by the commands
+     * @param descrs Not used
+     * @param space Not used
+     * @return 0
+     */
+    const unsigned int getDescrs(struct pollfd *descrs, const unsigned int space) { return 0; }
+
+    /**
+     * There are no events
+     * @param descrs Not used
+     * @param descrsNum Not used
+     */
+    void handleEvents(struct pollfd *descrs, const unsigned int descrsNum) {}
+
+    /**
+     * Make the sound state muted
+     * @return true
+     */
+    const bool mute();
+
+    /**
+     * Unmute the sound state
+     * @return true
+     */
+    const bool unmute();
+
+    /**
+     * Change the current volume by the given value, the volume is limited by 0 and 100
+     * @param value The value of the change in percents, negative for decreasing
+     * @return true
+     */
+    const bool chgVol(const int value);
+
+    /**
+     * Set the current volume to the given value, it's limited by 0 and 100
+     * @param value The value of the volume in percents
+     * @return true
+     */
+    const bool setVol(const int value);
+
+    /**
+     * Get the current volume
+     * @return The current volume percents
+     */
+    const long getVol();
+
+    /**
+     * Is the sound state muted
+     * @return true The sound state is muted
+     */
+    const bool isMuted();
+};
+
+#endif
@@ -50,9 +50,10 @@ class NetConnector: public Connector
 
     /**
      * Get the string of the connected address
+     * @param clientID The ID of the client or -1 for the last connected client
      * @return The string of the address
      */
-    virtual const string getConnectedAddrStr() const = 0;
+    virtual const string getConnectedAddrStr(const int clientID) const = 0;
 
     /**
      * Get the string of the currently used port number
@@ -31,74 +31,97 @@
 
 #include "Connector.h"
 
-#include <mutex>
 #include <string>
+#include <atomic>
+
+class SoundBackend;
 
 /**
  * Class for changing sound volume and its state(mute/unmute)
  */
 class SndConnector: public Connector
 {
-    std::mutex mutex_;
-    
-    std::string dataStr_;                    /**< The string of a data */
+    SoundBackend *backend_;                  /**< The sound system mixer selected at the startup */
+
+    int stopEvent_;                          /**< The event signaled for stopping the connector */
+
+    long notifiedVolume_;                    /**< The last volume sent to the clients */
+    int notifiedMuted_;                      /**< The last mute state sent to the clients */
+    std::atomic<long> cachedVolume_;         /**< The last volume read from the mixer, it's read by the other threads without calling the mixer */
 
     static const char* TAG;                  /**< The tag for writing to the log file */
 
     /**
-     * Set the string of an arrived data
-     * @param str The string of the arrived data
+     * Push the notifications of the changed volume or mute state into the commands queue.
+     * Called by the sound backend when the mixer's state has changed
+     * @param volume The current volume percents
+     * @param muted Is the sound state muted
+     * @param context The pointer to the connector instance
      */
-    void setArrivedDataStr(const std::string &str);
+    static void onSoundChanged(const long volume, const bool muted, void *context);
 
  public:
     /**
      * Constructor
      */
-    SndConnector(): dataStr_("") {}
+    SndConnector();
 
     /**
      * Destructor
      */
-    ~SndConnector() {}
+    ~SndConnector();
 
     /**
      * Run the connector
+     * It waits for the events of the sound system mixer, e.g. changing the volume by the desktop's keys
      */    
-    void run() {}
+    void run();
 
     /**
      * Stop the connector
      */    
-    void stop() {}
+    void stop();
 
     /**
      * Send data string to connector
      * @param newDataStr The string of the sent data
+     * @param clientID The ID of the client the data should be sent to
+     * @param requestID The ID of the client's request the data replies to
      */
-    void send(const std::string &newDataStr) {}
+    void send(const std::string &newDataStr, const int clientID, const int requestID) {}
 
     /**
-     * Get a data string arrived to the connector
-     * @return The arrived data string
+     * Get a data string arrived to the connector.
+     * The sound commands get their results from the calls, so there is no arrived data
+     * @return The empty string
      */    
-    const std::string receive();
+    const std::string receive() { return ""; }
 
     /**
      * Make the system sound state muted
+     * @return true The system sound state is muted
      */
-    void doMute();
+    const bool doMute();
 
     /**
      * Make the system sound state unmuted
+     * @return true The system sound state is unmuted
      */    
-    void doUnmute();
+    const bool doUnmute();
 
     /**
      * Change system's sound volume
      * @param value The value which the volume should be changed to
+     * @return true The volume has been changed
+     */
+    const bool doChgVol(const int value);
+
+    /**
+     * Set system's sound volume
+     * @param value The value in percent which the volume should be set to
+     * @return true The volume has been set
      */
-    void doChgVol(const int value);
+    const bool doSetVol(const int value);
 
     /**
      * Get the sting of the current system's sound volume value
@@ -106,6 +129,13 @@ class SndConnector: public Connector
      */
     const std::string doGetVol();
 
+    /**
+     * Get the string of the last known system's sound volume value without calling the mixer.
+     * May be called by any thread, the value is updated by the mixer's events and by doGetVol()
+     * @return The string of the value
+     */
+    const std::string getCachedVol() const;
+
     /**
      * Is the system's sound muted?
      * @return true The system's sound muted
@@ -0,0 +1,134 @@
+/**
+ * @file
+ * The interface of the sound system's mixer used by the sound connector
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SOUNDBACKEND_H_
+#define SOUNDBACKEND_H_
+
+#include <string>
+
+struct pollfd;
+
+/**
+ * The sound system's mixer controlled by the sound commands.
+ * The backend used by the daemon is selected at the startup: the ALSA mixer or the in-memory one
+ */
+class SoundBackend
+{
+    static std::string selected_;            /**< The description of the selected backend */
+
+ public:
+
+    /**
+     * The function called when the volume or the mute state of the mixer has changed
+     * @param volume The current volume percents
+     * @param muted Is the sound state muted
+     * @param context The context given while setting the callback
+     */
+    typedef void (*ChangedCallback)(const long volume, const bool muted, void *context);
+
+    /**
+     * Destructor
+     */
+    virtual ~SoundBackend() {}
+
+    /**
+     * Select the backend created by create()
+     * @param description The name of the backend: "alsa" or "mem[:LATENCY_US]",
+     *        where LATENCY_US is the delay of 0..1000000 microseconds added to every operation of the in-memory mixer
+     * @return true The description is valid
+     */
+    static bool select(const std::string &description);
+
+    /**
+     * Create the selected backend, the ALSA one if nothing has been selected
+     * @return The backend, it should be deleted by the caller
+     */
+    static SoundBackend* create();
+
+    /**
+     * Set the function which should be called when the volume or the mute state has changed
+     * @param callback The function or NULL
+     * @param context The context which the function should be called with
+     */
+    virtual void setChangedCallback(ChangedCallback callback, void *context) = 0;
+
+    /**
+     * Get the descriptors which should be polled for the events of the mixer
+     * @param descrs The array for the descriptors
+     * @param space The length of the array
+     * @return The number of the descriptors, 0 if there are no descriptors at the moment
+     */
+    virtual const unsigned int getDescrs(struct pollfd *descrs, const unsigned int space) = 0;
+
+    /**
+     * Handle the events of the polled descriptors. The changed callback is called from here
+     * @param descrs The polled descriptors
+     * @param descrsNum The number of the descriptors
+     */
+    virtual void handleEvents(struct pollfd *descrs, const unsigned int descrsNum) = 0;
+
+    /**
+     * Make the sound state muted
+     * @return true The sound state is muted
+     */
+    virtual const bool mute() = 0;
+
+    /**
+     * Unmute the sound state
+     * @return true The sound state is unmuted
+     */
+    virtual const bool unmute() = 0;
+
+    /**
+     * Change the current volume by the given value
+     * @param value The value of the change in percents, negative for decreasing
+     * @return true The volume has been changed
+     */
+    virtual const bool chgVol(const int value) = 0;
+
+    /**
+     * Set the current volume to the given value
+     * @param value The value of the volume in percents
+     * @return true The volume has been set
+     */
+    virtual const bool setVol(const int value) = 0;
+
+    /**
+     * Get the current volume
+     * @return The current volume percents
+     */
+    virtual const long getVol() = 0;
+
+    /**
+     * Is the sound state muted
+     * @return true The sound state is muted
+     */
+    virtual const bool isMuted() = 0;
+};
+
+#endif
@@ -32,18 +32,21 @@
 #ifndef COMMANDSDISPATCHER_H_
 #define COMMANDSDISPATCHER_H_
 
-#include <map>
 #include <string>
 #include <mutex>
 #include <thread>
 #include <list>
 
 #include "Command.h"
+#include "CommandsQueue.h"
+#include "Metrics.h"
 
 #include "GuiConnector.h"
 #include "NetConnector.h"
 #include "SndConnector.h"
 
+#define MAX_BATCH_LEN 254          /**< The maximal length of a batch and of its results, the results with their EOL fit the net libraries' records of DATA_LEN bytes */
+
 /**
  * \class CommandsDispatcher
  * \brief Contains the commands set. Dispatches the commands between connectors
@@ -52,22 +55,35 @@ class CommandsDispatcher {
 
 	static const char* TAG;            /**< The for writing to log file */
 
+	static const char* commandsNames_[];  /**< The names of the commands indexed by their opcodes */
+
  protected:
 
-	map<string, Command*> commands_;   /**< The map of commands */
+	Command *commands_[COMMANDS_OPCODES_NUM];   /**< The commands indexed by their opcodes */
 
 	NetConnector *netConnector_;       /**< The connector for network */
 	GuiConnector *guiConnector_;       /**< The connector for GUI */
 	SndConnector *sndConnector_;       /**< The connector for system sound control */
 
 	bool shouldStop_;                  /**< Should the dispatcher be stopped */
+	int netClientID_;                  /**< The ID of the network connector's client whose command is executed now, -1 if the command hasn't arrived from it */
 	mutex *mutex_;                     
 
 	thread *thNetConnector_;           /**< The thread of the network connector */
 	thread *thGuiConnector_;           /**< The thread of the GUI connector */
+	thread *thSndConnector_;           /**< The thread of the sound connector */
 
 	list<Connector*> connectors_;      /**< The list of connectors */
 
+	CommandsQueue commandsQueue_;      /**< The queue of commands arrived from connectors */
+
+	mutable Metrics metrics_;          /**< The metrics of the commands and of the connectors, recorded by the executing methods */
+
+	/**
+	 * Constructor
+	 */
+	CommandsDispatcher(): commands_(), netClientID_(-1) {}
+
 	/**
 	 * Initialize commands instances
 	 */
@@ -79,11 +95,41 @@ class CommandsDispatcher {
 	void delCommands();
 	
 	/**
-	 * Execute the command by given string of the command
+	 * Execute the command by given string of the command.
+	 * The spans of the command and of its sound operations are traced with the IDs of the client's request
 	 * @param command The command's string containing the command's name and parameters
+	 * @param clientID The ID of the client the command has arrived from
+	 * @param requestID The ID of the client's request
 	 * @return The execution result string, "ERR" or "OK"
 	 */
-	const string execCommand(const string& command) const;
+	const string execCommand(const string& command, const int clientID, const int requestID) const;
+
+	/**
+	 * Execute the batch of commands separated by BATCH_SEPARATOR one after another.
+	 * The consecutive commands changing the volume are coalesced into one change.
+	 * The batch and its results are limited by MAX_BATCH_LEN bytes, the longer ones are answered by "ERR"
+	 * @param batch The string of the batch
+	 * @param clientID The ID of the client the batch has arrived from
+	 * @param requestID The ID of the client's request
+	 * @return The results of the executed commands separated by BATCH_SEPARATOR
+	 */
+	const string execBatch(const string& batch, const int clientID, const int requestID) const;
+
+	/**
+	 * Split the given batch string into the strings of its commands
+	 * @param batch The string of the batch
+	 * @return The list of the non empty commands' strings
+	 */
+	const list<string> splitBatchStr(const string &batch) const;
+
+	/**
+	 * Get the volume change of the given command if it's the command changing the volume
+	 * by a value not exceeding MAX_COALESCED_VOL_CHANGE
+	 * @param command The command's string
+	 * @param value The value of the volume change
+	 * @return true The command changes the volume by a valid value
+	 */
+	bool getVolChange(const string &command, int &value) const;
 
 	/**
 	 * Initialize connectors instances
@@ -107,17 +153,40 @@ class CommandsDispatcher {
 	void delThreads();
 
 	/**
-	 * Parse the given command string into command name and parameters if there are ones
-	 * @param str The string of the command
-	 * @return The list of the name of the command and its parameters
+	 * Parse the given command string into command name and parameters if there are ones.
+	 * The words of the string are terminated in place, nothing is copied
+	 * @param str The buffer of the command's string
+	 * @param name The name of the command
+	 * @param params The parameters of the command
+	 * @return false The string is empty or has too many parameters
+	 */
+	bool parseCommandStr(char *str, const char* &name, CommandParams &params) const;
+
+	/**
+	 * Get the opcode of the command with the given name by one probe of the names' hash
+	 * @param name The name of the command
+	 * @param len The length of the name
+	 * @return The opcode or NO_OPCODE if there is no command with the given name
 	 */
-	const list<string> parseCommandStr(const string &str) const;
+	static int getCommandOpcode(const char *name, const size_t len);
 
 	/**
 	 * Stop connectors
 	 */	
 	void stopConnectors() const;
 
+	/**
+	 * Make the connectors push the arrived commands into the commands queue.
+	 * The metrics of the connectors are recorded from here on
+	 */
+	void subscribeConnectors();
+
+	/**
+	 * Send the given notification to the clients of all the connectors
+	 * @param notification The string of the notification
+	 */
+	void notifyConnectors(const string &notification) const;
+
  public:
 
 	/**
@@ -43,6 +43,9 @@
 class CommandsDispatcherWiFi: public CommandsDispatcher 
 {
     static const char* TAG;   /**< The for writing to log file */
+
+    string volPortNum_;       /**< The port number string of the volume's datagrams or "" */
+    string discoveryPortNum_; /**< The port number string of the discovery probes or "" */
     
     /**
      * Change the port number of the net connector
@@ -77,8 +80,10 @@ class CommandsDispatcherWiFi: public CommandsDispatcher
     /**
      * Constructor
      * @param portNum The number of port string
+     * @param volPortNum The number of port string of the volume's datagrams or "" if they aren't received
+     * @param discoveryPortNum The number of port string of the discovery probes or "" if they aren't answered
      */
-    CommandsDispatcherWiFi(string &portNum) throw(PortException, GuiException);
+    CommandsDispatcherWiFi(string &portNum, const string &volPortNum = "", const string &discoveryPortNum = "") throw(PortException, GuiException);
         
     /**
      * Restart the net connector with the given new port number
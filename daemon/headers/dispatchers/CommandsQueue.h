@@ -0,0 +1,111 @@
+/**
+ * @file
+ * The queue of commands arrived from connectors.
+ * Connectors push the arrived commands into the queue, the dispatcher
+ * blocks on the queue until there is a command for execution
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef COMMANDSQUEUE_H_
+#define COMMANDSQUEUE_H_
+
+#include <cstdint>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+class Connector;
+class Metrics;
+
+/**
+ * \struct QueuedCommand
+ * \brief The command waiting for execution and the connector it arrived from
+ */
+struct QueuedCommand
+{
+    Connector *connector;            /**< The connector the command arrived from. The result should be sent back to it */
+    int clientID;                    /**< The ID of the connector's client the command arrived from */
+    int requestID;                   /**< The ID of the client's request the result replies to, -1 if the request has no ID */
+    std::string command;             /**< The string of the command or of the notification */
+    bool isNotification;             /**< Is it a notification which should be sent to all the clients */
+    uint64_t queuedTime;             /**< The trace time the command has been queued at, 0 if the tracing is disabled */
+};
+
+/**
+ * \class CommandsQueue
+ * \brief The thread safe queue of commands waiting for execution
+ */
+class CommandsQueue
+{
+    std::deque<QueuedCommand> commands_;     /**< The commands waiting for execution */
+    std::mutex mutex_;
+    std::condition_variable hasCommands_;    /**< Signaled when a command pushed or the queue stopped */
+    bool stopped_;                           /**< Has the queue been stopped */
+    Metrics *metrics_;                       /**< The metrics of the queued commands or NULL */
+
+ public:
+
+    /**
+     * Constructor
+     */
+    CommandsQueue(): stopped_(false), metrics_(NULL) {}
+
+    /**
+     * Set the metrics which the queued commands should be recorded to. Should be called before pushing
+     * @param metrics The metrics
+     */
+    void setMetrics(Metrics *metrics) { metrics_ = metrics; }
+
+    /**
+     * Push the given command into the queue and wake up the waiting consumer
+     * @param connector The connector the command arrived from
+     * @param clientID The ID of the connector's client the command arrived from
+     * @param command The string of the command
+     * @param requestID The ID of the client's request, -1 if the request has no ID
+     */
+    void push(Connector *connector, const int clientID, const std::string &command, const int requestID = -1);
+
+    /**
+     * Push the given notification into the queue and wake up the waiting consumer
+     * @param connector The connector the notification arrived from
+     * @param notification The string of the notification
+     */
+    void pushNotification(Connector *connector, const std::string &notification);
+
+    /**
+     * Wait until there is a command in the queue and pop it
+     * @param item The popped command
+     * @return false The queue has been stopped, there is no command for execution
+     */
+    bool pop(QueuedCommand &item);
+
+    /**
+     * Stop the queue and wake up the waiting consumer
+     */
+    void stop();
+};
+
+#endif
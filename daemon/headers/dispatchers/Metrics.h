@@ -0,0 +1,193 @@
+/**
+ * @file
+ * The metrics of the executed commands and of the connectors.
+ * They are recorded by the relaxed atomic operations, so the recording doesn't lock
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+#include "CommandsNames.h"
+
+class Connector;
+
+#define HISTOGRAM_SUB_BUCKETS_NUM 16             /**< The number of the buckets of every power of two, the precision is 1/16 */
+#define HISTOGRAM_BUCKETS_NUM 464                /**< The number of the buckets of the values up to 2^32 */
+#define MAX_METRICS_CONNECTORS_NUM 4             /**< The maximal number of the connectors having the metrics */
+
+/**
+ * \class LatencyHistogram
+ * \brief The HDR-style histogram of the latencies in microseconds.
+ * The values less than 32 have their own buckets, the bigger ones are counted by HISTOGRAM_SUB_BUCKETS_NUM buckets of every power of two
+ */
+class LatencyHistogram
+{
+    std::atomic<uint64_t> buckets_[HISTOGRAM_BUCKETS_NUM];   /**< The numbers of the values of the buckets */
+    std::atomic<uint64_t> count_;                            /**< The number of the recorded values */
+    std::atomic<uint64_t> max_;                              /**< The maximal recorded value */
+
+    /**
+     * Get the index of the bucket of the given value
+     * @param value The value
+     * @return The index of the bucket
+     */
+    static size_t getBucketIndex(const uint64_t value);
+
+    /**
+     * Get the highest value counted by the bucket with the given index
+     * @param index The index of the bucket
+     * @return The highest value of the bucket
+     */
+    static uint64_t getBucketValue(const size_t index);
+
+ public:
+    /**
+     * Constructor
+     */
+    LatencyHistogram();
+
+    /**
+     * Record the given value
+     * @param value The latency in microseconds
+     */
+    void record(const uint64_t value);
+
+    /**
+     * Get the number of the recorded values
+     * @return The number of the values
+     */
+    uint64_t getCount() const { return count_.load(std::memory_order_relaxed); }
+
+    /**
+     * Get the maximal recorded value
+     * @return The maximal value or 0 if nothing has been recorded
+     */
+    uint64_t getMax() const { return max_.load(std::memory_order_relaxed); }
+
+    /**
+     * Get the given percentile of the recorded values
+     * @param percent The percent of the percentile
+     * @return The highest value of the bucket having the percentile or 0 if nothing has been recorded
+     */
+    uint64_t getPercentile(const double percent) const;
+};
+
+/**
+ * \struct ConnectorMetrics
+ * \brief The metrics of a connector: the bytes of the commands and of the replies, the number of its queued commands
+ */
+struct ConnectorMetrics
+{
+    const char *name;                        /**< The name of the connector in the statistics */
+    Connector *connector;                    /**< The connector */
+    std::atomic<uint64_t> receivedBytes;     /**< The bytes of the commands arrived from the connector */
+    std::atomic<uint64_t> sentBytes;         /**< The bytes of the replies and of the notifications sent to the connector */
+    std::atomic<long> queued;                /**< The number of the connector's commands waiting for execution */
+    std::atomic<long> maxQueued;             /**< The maximal number of the connector's commands waiting for execution */
+};
+
+/**
+ * \class Metrics
+ * \brief The registry of the metrics of the commands indexed by their opcodes and of the connectors.
+ * The connectors are added before running, so the registry isn't changed while the metrics are recorded
+ */
+class Metrics
+{
+    LatencyHistogram latencies_[COMMANDS_OPCODES_NUM];          /**< The latencies of the commands' execution */
+    std::atomic<uint64_t> errors_[COMMANDS_OPCODES_NUM];        /**< The numbers of the commands' executions returned ERR */
+
+    ConnectorMetrics connectors_[MAX_METRICS_CONNECTORS_NUM];   /**< The metrics of the connectors */
+    size_t connectorsNum_;                                      /**< The number of the added connectors */
+
+    std::atomic<long> queued_;                                  /**< The number of the commands waiting for execution */
+    std::atomic<long> maxQueued_;                               /**< The maximal number of the commands waiting for execution */
+
+    /**
+     * Find the metrics of the given connector
+     * @param connector The connector
+     * @return The metrics or NULL if the connector hasn't been added
+     */
+    ConnectorMetrics* findConnector(const Connector *connector);
+
+ public:
+    /**
+     * Constructor
+     */
+    Metrics();
+
+    /**
+     * Add the connector whose metrics should be recorded. Should be called before running the connectors
+     * @param name The name of the connector in the statistics
+     * @param connector The connector
+     */
+    void addConnector(const char *name, Connector *connector);
+
+    /**
+     * Record the execution of the command
+     * @param opcode The opcode of the command
+     * @param latency The time of the execution in microseconds
+     * @param isError Has the command returned ERR
+     */
+    void recordCommand(const int opcode, const uint64_t latency, const bool isError);
+
+    /**
+     * Record the command arrived from the connector and waiting for execution.
+     * It's called while the commands queue is locked, as recordDequeued(), so the numbers of the queued commands aren't negative
+     * @param connector The connector
+     * @param bytes The length of the command
+     */
+    void recordQueued(const Connector *connector, const size_t bytes);
+
+    /**
+     * Record the command of the connector taken for execution
+     * @param connector The connector
+     */
+    void recordDequeued(const Connector *connector);
+
+    /**
+     * Record the reply or the notification sent to the connector
+     * @param connector The connector
+     * @param bytes The length of the reply
+     */
+    void recordSent(const Connector *connector, const size_t bytes);
+
+    /**
+     * Get the statistics of the command or of the connector with the given name.
+     * The statistics of a command: the number of the executions, the number of ERR results, p50, p99, p999 and max latency in microseconds.
+     * The statistics of a connector: the received bytes, the sent bytes, the number of the queued commands and its maximum.
+     * The numbers are separated by spaces, so the statistics fit the length of a reply
+     * @param name The name of the command or of the connector, the totals of all the commands if it's empty:
+     *        the number of the executions, the number of ERR results, the number of the queued commands and its maximum
+     * @return The statistics or the empty string if there is nothing with the given name
+     */
+    std::string getStats(const std::string &name) const;
+};
+
+#endif
@@ -31,8 +31,11 @@
 #include "service.h"
 
 #include "BlueToothLib.h"
+#include "BtNames.h"
 #include "synchronise.h"
+#include "frames.h"
 #include "Log.h"
+#include "Trace.h"
 #include "addr.h"
 
 #include <pthread.h>
@@ -43,9 +46,11 @@
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <string.h>
 
 #include <sys/socket.h>
 #include <netdb.h>
+#include <poll.h>
 
 
 
@@ -54,29 +59,78 @@
 
 #define MAX_SOCKETS_NUM_WAITED_FOR_ACCEPT 1                  /**< The maximal number of sockets waiting for accept */
 
-#define MAX_BT_DEV_NAME_LEN 50                               /**< The maximal length of bluetooth device */
+#define IN_BUFF_LEN (MAX_FRAME_LEN * 2)                      /**< The length of the buffer of the received data */
+
+#define STOP_EVENT_IDX      0                                /**< The index of the polled stop event */
+#define SENT_DATA_EVENT_IDX 1                                /**< The index of the polled event of the data for sending */
+#define SOCKET_IDX          2                                /**< The index of the polled listening or connection's socket */
+#define POLLED_DESCRS_NUM   3                                /**< The number of the polled descriptors */
+
+/**
+ * \struct BtConnection
+ * \brief The context of the connected client
+ */
+struct BtConnection
+{
+    int id;                                                  /**< The ID of the connection or NO_CONNECTION if there is no client */
+    int sockDescr;                                           /**< The socket descriptor of the connection */
+    char inBuff[IN_BUFF_LEN];                                /**< The buffer of the received and not yet processed data */
+    size_t inLen;                                            /**< The length of the data in the input buffer */
+    bool usesFrames;                                         /**< Has the client sent the binary frames */
+    bool isLegacyClient;                                     /**< Does the client send the text commands without EOL, until its first EOL or frame */
+};
+
 char connectedAdapterName [MAX_BT_DEV_NAME_LEN] = { 0 };     /**< The string of the name of a connected device */
 char localAdapterName     [MAX_BT_DEV_NAME_LEN] = { 0 };     /**< The string of the name of the local adapter */
 
+bdaddr_t connectedAdapterAddr;                               /**< The address of the connected device */
+bool isAdapterConnected = false;                             /**< Is there a connected device */
+pthread_mutex_t mutexConnectedAddr = PTHREAD_MUTEX_INITIALIZER; /**< The mutex of the connected device's address */
+
 /**
  * Get local address string
- * @return The string of the local address or ""
+ * @return The string of the name of the local adapter, its address if the name hasn't been resolved yet
+ *         or "" if there is no local adapter
  */
 const char* getLocalAddr()
 {
-    writeToLog2("Local addr: ", localAdapterName, TAG);
+    getLocalBtName(localAdapterName, MAX_BT_DEV_NAME_LEN);
+    LOG_DEBUG2("Local addr: ", localAdapterName, TAG);
     return localAdapterName;
 }
 
 /**
  * Get connected address string
- * @return The string of the connected address or ""
+ * @return The string of the cached name of the connected device, its address if the name hasn't been resolved yet
+ *         or "" if there is no connected device
  */
 const char* getConnectedAddr()
 {
+    pthread_mutex_lock(&mutexConnectedAddr);
+    if(isAdapterConnected)
+	getBtName(&connectedAdapterAddr, connectedAdapterName, MAX_BT_DEV_NAME_LEN);
+    else
+	connectedAdapterName[0] = '\0';
+    pthread_mutex_unlock(&mutexConnectedAddr);
     return connectedAdapterName;
 }
 
+/**
+ * Set the address of the connected device and request resolving its name
+ * @param addr The address of the device or NULL if there is no connected device
+ */
+static void setConnectedAdapterAddr(const bdaddr_t *addr)
+{
+    pthread_mutex_lock(&mutexConnectedAddr);
+    isAdapterConnected = (addr != NULL);
+    if(isAdapterConnected)
+	bacpy(&connectedAdapterAddr, addr);
+    pthread_mutex_unlock(&mutexConnectedAddr);
+
+    if(addr != NULL)
+	resolveBtName(addr);
+}
+
 
 /**
  * Close the socket connection
@@ -88,7 +142,7 @@ const int closeBtSocketConn(const int sockDescr)
     if(sockDescr <= 0)
 	return ERR;
 	
-    writeToLog("\tClosing socket connection\n", TAG);
+    LOG_INFO("\tClosing socket connection\n", TAG);
 
     const int res = close(sockDescr);
     writeToLogIfError(res, __func__, strerror(errno), TAG);
@@ -141,30 +195,13 @@ const int bindBtSocket(const int sockDescr)
 }
 
 /**
- * Initialize the name of the local bluetooth adapter
- */
-void initLocalAdapterName()
-{
-    const int adapterID      = hci_get_route(NULL);
-    const int adapterHandler = hci_open_dev(adapterID);
-    if(adapterHandler < 0)
-	{
-	    writeToLog2("ERROR: Can't open the local adapter:", strerror(errno), TAG);
-	    return;	    
-	}
-    if (hci_read_local_name(adapterHandler, MAX_BT_DEV_NAME_LEN, localAdapterName, 2000) < 0) {
-	writeToLog2("ERROR: Can't get the local adapter's name: ", strerror(errno), TAG);
-	return;
-    }
-    close(adapterHandler);
-}
-
-/**
- * Initialize the connection before listening
+ * Initialize the connection before listening.
+ * Should be called before the connection's thread starts, the data rings are emptied
  * @return socket descriptor or ERR
  */
 const int initBtConnectionBeforeListen()
 {
+    initSynchronisation();
     const int socket = createBtSocket();
     if(socket != ERR)
 	{
@@ -174,7 +211,7 @@ const int initBtConnectionBeforeListen()
 		    return ERR;		    
 		}
 	}
-    initLocalAdapterName();
+    startBtNamesResolver();
     return socket;
 }
 
@@ -194,179 +231,214 @@ const int listenBtConns(const int sockDescr)
 }
 
 /**
- * Accept a connection
+ * Accept a connection. Should be called when the listening socket is ready for reading
  * @param sockDescr A socket's descriptor
- * @return ERR if there is an error. Any other number if there is no error
+ * @param addr The address of the connected device
+ * @return The descriptor of the accepted connection or ERR
  */
-const int acceptBtConn(const int sockDescr)
+const int acceptBtConn(const int sockDescr, bdaddr_t *addr)
 {
     writeToLog("Accepting connections...\n", TAG);
     
     struct sockaddr_rc rem_addr = { 0 };
     socklen_t opt = sizeof(rem_addr);
-    int newSockDescr = accept(sockDescr, (struct sockaddr *)&rem_addr, &opt);
-    while(newSockDescr == ERR)	
-	{	    
-	    if(errno == EWOULDBLOCK)
-		{
-		    if(getRunStatus() == STOP)
-			return STOP;
-		}
-	    else
-		break;
-	    usleep(MILLISECONDS_SLEEP_TIME * 1000);
-	    newSockDescr = accept(sockDescr, (struct sockaddr *)&rem_addr, &opt);
-	}
-									     
-    writeToLogIfError(newSockDescr, __func__, strerror(errno), TAG);
-
-    const int adapterID      = hci_get_route(NULL);
-    const int adapterHandler = hci_open_dev(adapterID);
-    if(adapterHandler >= 0)
-	{	
-	    if (hci_read_remote_name(adapterHandler, &rem_addr.rc_bdaddr, MAX_BT_DEV_NAME_LEN, connectedAdapterName, 0) < 0)
-		writeToLog2("ERROR: Can't get the remote adapter's name: ", strerror(errno), TAG);
+    const int newSockDescr = accept(sockDescr, (struct sockaddr *)&rem_addr, &opt);
+    if(newSockDescr == ERR)
+	{
+	    if( (errno != EWOULDBLOCK) && (errno != EAGAIN) )
+		writeToLog2("ERROR acceptBtConn(): ", strerror(errno), TAG);
+	    return ERR;
 	}
-    else
-	writeToLog2("ERROR: Can't open the local adapter:", strerror(errno), TAG);
-    
-    close(adapterHandler);
 
-    writeToLog2("accepted connection from ", connectedAdapterName, TAG);
+    bacpy(addr, &rem_addr.rc_bdaddr);
+
+    char addrStr[18] = { 0 };
+    ba2str(addr, addrStr);
+    LOG_INFO2("accepted connection from ", addrStr, TAG);
     
     return newSockDescr;
 }
 
 /**
- * Receive a data from a client
- * @param newSockDescr A socket's descriptor
- * @param incoming_data_buffer The buffer for incoming data
- * @param buff_len The length of the data's buffer
- * @return The buffer of the incoming data or NULL if there is an error
+ * Send data by sockets.
+ * @param socketDescr The socket descriptor
+ * @param sentData The sent data
+ * @param sentDataLen The length of the sent data
+ * @return ERR or NO_ERR
+ */
+const int sendBtData(const int socketDescr, const char *sentData, const size_t sentDataLen)
+{
+    const ssize_t bytes_sent = write(socketDescr, sentData, sentDataLen);
+    
+    if(bytes_sent == ERR)
+	{
+	    writeToLog2("\tERROR sendBtData(): ", strerror(errno), TAG);
+	    return ERR;
+	}
+
+    if(bytes_sent != sentDataLen)
+	{
+	    writeToLog("\tERROR sendBtData(): The data hasn't sent successfully. The size of the sent data doesn't equal the actual data's size\n", TAG);
+	    return ERR;
+	}
+
+    return NO_ERR;
+}
+
+/**
+ * Send the given reply or notification by the protocol the client uses.
+ * The reply to a request of the binary protocol is sent as a frame, a notification is sent as
+ * a frame if the client has sent frames before
+ * @param conn The connection
+ * @param reqId The ID of the request the data is the reply to or NO_REQUEST
+ * @param sentData The string of the sent data
+ * @return ERR or NO_ERR
  */
-const char* receiveBtData(const int newSockDescr, char* incoming_data_buffer, const size_t buff_len)
+static const int sendBtMessage(const struct BtConnection *conn, const int reqId, const char *sentData)
 {
-    if(incoming_data_buffer == NULL)
-      {
-	  writeToLog("ERROR receiveData(): The given pointer to buffer for incoming data is NULL\n", TAG);
-	  return NULL;
-      }
-    if(buff_len == 0)
-      {
-	  writeToLog("ERROR receiveData(): The length of the given buffer is 0\n", TAG);
-	  return NULL;
-      }
+    LOG_DEBUG2("Sending the answer: ", sentData, TAG);
 
-    if(buff_len != 0)
-	bzero(incoming_data_buffer, buff_len);
-    
-    writeToLog("Waiting to receive data...\n", TAG);
+    if( (reqId == NO_REQUEST) && !conn->usesFrames )
+	return sendBtData(conn->sockDescr, sentData, strlen(sentData));
+
+    char frame[MAX_FRAME_LEN];
+    const size_t len = (reqId == NO_REQUEST) ? buildNotificationFrame(frame, MAX_FRAME_LEN, sentData):
+                                               buildReplyFrame(frame, MAX_FRAME_LEN, reqId, sentData);
+    if(len == 0)
+	{
+	    writeToLog2("\tERROR sendBtMessage(): Can't build the frame of the data: ", sentData, TAG);
+	    return ERR;
+	}
+    return sendBtData(conn->sockDescr, frame, len);
+}
 
-    ssize_t bytes_recieved = recv(newSockDescr, incoming_data_buffer, buff_len, 0);
-    while(bytes_recieved == ERR)	
-	{	    
-	    if(errno == EWOULDBLOCK)
+/**
+ * Send the replies and the notifications waiting for sending
+ * @param conn The connection
+ */
+static void sendBtWaitingData(struct BtConnection *conn)
+{
+    char sentData[DATA_LEN] = {'\0'};
+    int sentDataConnId = NO_CONNECTION;
+    int reqId = NO_REQUEST;
+    while(getSentData(&sentDataConnId, &reqId, sentData))
+	{
+	    if(sentDataConnId == ALL_CONNECTIONS)
 		{
-		    if(getRunStatus() == STOP)
-			return STR_END;
+		    if(conn->id != NO_CONNECTION)
+			sendBtMessage(conn, NO_REQUEST, sentData);
+		}
+	    else if(sentDataConnId == conn->id)
+		{
+		    const uint64_t start = TRACE_START();
+		    sendBtMessage(conn, reqId, sentData);
+		    traceSpan("bt:send", conn->id, reqId, start);
 		}
 	    else
-		break;
-	    usleep(MILLISECONDS_SLEEP_TIME * 1000);
-	    bytes_recieved = recv(newSockDescr, incoming_data_buffer, buff_len, 0);
+		LOG_WARN2("WARNING: The client has disconnected, the answer is dropped: ", sentData, TAG);
 	}
+}
+
+/**
+ * Receive a data from a client into the connection's input buffer.
+ * Should be called when the connection's socket is ready for reading
+ * @param conn The connection
+ * @return ERR, NO_ERR or STOP if the client has closed the connection
+ */
+const int receiveBtData(struct BtConnection *conn)
+{
+    LOG_TRACE("Receiving data...\n", TAG);
+
+    const ssize_t bytes_recieved = recv(conn->sockDescr, conn->inBuff + conn->inLen, IN_BUFF_LEN - conn->inLen, 0);
     
     if (bytes_recieved == 0)
 	{
-	    writeToLog("\tHost shut down.\n", TAG);
-	    return STR_END;
+	    LOG_INFO("\tHost shut down.\n", TAG);
+	    return STOP;
 	}
     if (bytes_recieved == ERR) 
       {
 	  writeToLog2("\tERROR receiveData(): ", strerror(errno), TAG);
-	  return NULL;
+	  return ERR;
       }
     
-    incoming_data_buffer[bytes_recieved] = '\0';    // remove EOL
-
-    return incoming_data_buffer;
+    conn->inLen += bytes_recieved;
+    return NO_ERR;
 }
 
 /**
- * Send data by sockets.
- * @param socketDescr The socket descriptor
- * @return ERR or NO_ERR
+ * Client-server conversation.
+ * Every complete message received from the client(a text line, a binary frame or a legacy client's packet without EOL) is passed as a received data,
+ * the replies are sent when the event of the data for sending is signaled.
+ * An invalid message is skipped, the invalid frame is answered by INVALID_MESSAGE_REPLY
+ * @param conn The connection
+ * @return The integer status of the conversation: ERR, NO_ERR or STOP if received the connection
+ *                                                                     end message
  */
-const int sendBtData(const int socketDescr)
+const int conversationBt(struct BtConnection *conn)
 {
-    char* sentData = getSentData();
-    writeToLog2("Sending the answer: ", sentData, TAG);
-
-    const size_t sentDataLen = strlen(sentData);
-    const ssize_t bytes_sent = write(socketDescr, sentData, sentDataLen);
-
-    bzero(sentData, sentDataLen);
-    
-    if(bytes_sent == ERR)
+    const uint64_t start = TRACE_START();
+    const int result = receiveBtData(conn);
+    if(result != NO_ERR)
+	return result;
+
+    char command[DATA_LEN] = {'\0'};
+    int reqId = NO_REQUEST;
+    bool isValid = true;
+    size_t pos = 0;
+    int len = 0;
+    while( (len = parseMessage(conn->inBuff + pos, conn->inLen - pos, conn->isLegacyClient, command, &reqId, &isValid)) > 0 )
 	{
-	    writeToLog2("\tERROR sendBtData(): ", strerror(errno), TAG);
-	    return ERR;
+	    pos += len;
+	    if( (reqId != NO_REQUEST) || (conn->inBuff[pos - 1] == '\n') )
+		conn->isLegacyClient = false;
+	    if(!isValid)
+		{
+		    writeToLog("ERROR conversationBt(): The received message is invalid, it's skipped\n", TAG);
+		    if( (reqId != NO_REQUEST) && (sendBtMessage(conn, reqId, INVALID_MESSAGE_REPLY) == ERR) )
+			return ERR;
+		    continue;
+		}
+	    if(reqId != NO_REQUEST)
+		conn->usesFrames = true;
+	    else if(strcmp(command, STR_END) == 0)
+		return STOP;
+
+	    if(strlen(command) != 0)
+		{
+		    LOG_DEBUG2("\tReceived string: ", command, TAG);
+		    traceSpan("bt:recv", conn->id, reqId, start);
+		    setReceivedData(conn->id, reqId, command);
+		}
 	}
 
-    if(bytes_sent != sentDataLen)
+    if(len == INVALID_MESSAGE)
 	{
-	    writeToLog("\tERROR sendBtData(): The data hasn't sent successfully. The size of the sent data doesn't equal the actual data's size\n", TAG);
+	    writeToLog("ERROR conversationBt(): The received data can't be split into messages, the connection is closed\n", TAG);
 	    return ERR;
 	}
+    conn->inLen -= pos;
+    memmove(conn->inBuff, conn->inBuff + pos, conn->inLen);
 
     return NO_ERR;
 }
 
 /**
- * Client-server conversation
- * @param incoming_data_buffer The string buffer for the incoming from the client data
- * @param buff_len The length of the data(send/receive) buffer
- * @param socket The socket descriptor of the conversation
- * @return The integer status of the conversation: ERR, NO_ERR or STOP if received the connection
- *                                                                     end message
+ * Close the client's connection
+ * @param conn The connection
  */
-const int conversationBt(char *incoming_data_buffer, const size_t buff_len, const int socket)
+static void closeBtConn(struct BtConnection *conn)
 {
-    if(incoming_data_buffer == NULL)
-      {
-	  writeToLog("ERROR conversationBt(): The given pointer to buffer for incoming data is NULL\n", TAG);
-	  return ERR;
-      }
-    if(buff_len == 0)
-      {
-	  writeToLog("ERROR conversationBt(): The length of the given buffer is 0\n", TAG);
-	  return ERR;
-      }
-
-    const char* str = receiveBtData(socket, incoming_data_buffer, buff_len);
-    if(str == NULL) 
-    {
-	writeToLog("ERROR conversationBt(): the received data is NULL\n", TAG);
-	return ERR;
-    }
-    if(strcmp(str, STR_END) == 0)
-    {
-	writeToLog("ERROR conversationBt(): the received data is EMTPTY\n", TAG);
-        return STOP;
-    }
-
-    writeToLog2("\tReceived string: ", incoming_data_buffer, TAG);
- 
-    setReceivedData(incoming_data_buffer);
-    setReceivedDataStatus(HAS_NEW_DATA);
-    
-    while(strlen(getSentData()) == 0);   // waiting for the input of the data for sending
-
-    return sendBtData(socket);
+    closeBtSocketConn(conn->sockDescr);
+    setConnectedAdapterAddr(NULL);
+    conn->id        = NO_CONNECTION;
+    conn->sockDescr = ERR;
 }
 
 /**
- * Run client-server connection
+ * Run client-server connection.
+ * The stop event, the event of the data for sending and the listening socket
+ * or the connected client's socket are polled, one client is connected at once
  * @param sockDescr Socket deskriptor of the server
  */
 void runBtConnection(const int sockDescr)
@@ -380,31 +452,77 @@ void runBtConnection(const int sockDescr)
 	    return;
 	}
         
-    initMutexes();
+    setTraceThreadName("bt");
+    const int sentDataEvent = initSentDataEvent();
+    const int stopEvent     = initStopEvent();
+    if( (sentDataEvent == ERR) || (stopEvent == ERR) )
+	{
+	    writeToLog2("\tERROR runBtConnection(): ", strerror(errno), TAG);
+	    setRunStatus(STOP);
+	}
+
+    struct BtConnection conn;
+    conn.id        = NO_CONNECTION;
+    conn.sockDescr = ERR;
+    int connId = 0;
 
-    char receivedDataArr[DATA_LEN] = {'\0'};
-    int newSockDescr;
+    struct pollfd descrs[POLLED_DESCRS_NUM];
     while( (getRunStatus() != STOP) )
 	{
-	    bzero(connectedAdapterName, sizeof(char));
-	    newSockDescr = acceptBtConn(sockDescr);
-	    if( (newSockDescr != ERR))
+	    descrs[STOP_EVENT_IDX].fd      = stopEvent;
+	    descrs[SENT_DATA_EVENT_IDX].fd = sentDataEvent;
+	    descrs[SOCKET_IDX].fd          = (conn.id == NO_CONNECTION) ? sockDescr: conn.sockDescr;
+	    int i;
+	    for(i = 0; i < POLLED_DESCRS_NUM; i++)
 		{
-		    bzero(receivedDataArr, sizeof(char));
-		    int result = NO_ERR;
-		    while(result == NO_ERR)
+		    descrs[i].events  = POLLIN;
+		    descrs[i].revents = 0;
+		}
+
+	    if(poll(descrs, POLLED_DESCRS_NUM, -1) == ERR)
+		{
+		    if(errno == EINTR)
+			continue;
+		    writeToLog2("\tERROR runBtConnection(): ", strerror(errno), TAG);
+		    break;
+		}
+
+	    if(descrs[STOP_EVENT_IDX].revents & POLLIN)
+		break;
+
+	    if(descrs[SENT_DATA_EVENT_IDX].revents & POLLIN)
+		{
+		    uint64_t counter;
+		    if(read(sentDataEvent, &counter, sizeof(counter)) == sizeof(counter))
+			sendBtWaitingData(&conn);
+		}
+
+	    if( (descrs[SOCKET_IDX].revents & (POLLIN | POLLHUP | POLLERR)) == 0 )
+		continue;
+
+	    if(conn.id == NO_CONNECTION)
+		{
+		    bdaddr_t addr;
+		    const int newSockDescr = acceptBtConn(sockDescr, &addr);
+		    if(newSockDescr != ERR)
 			{
-			    result = conversationBt(receivedDataArr, DATA_LEN, newSockDescr);
-			    if( (result == ERR) || (result == STOP) )
-				{
-				    closeBtSocketConn(newSockDescr);
-				    break;
-				}
+			    setConnectedAdapterAddr(&addr);
+			    conn.id             = ++connId;
+			    conn.sockDescr      = newSockDescr;
+			    conn.inLen          = 0;
+			    conn.usesFrames     = false;
+			    conn.isLegacyClient = true;
 			}
 		}
+	    else if(conversationBt(&conn) != NO_ERR)
+		closeBtConn(&conn);
 	}
-    
+
+    if(conn.id != NO_CONNECTION)
+	closeBtConn(&conn);
     closeBtSocketConn(sockDescr);
-    
-    destroyMutexes();    
+
+    stopBtNamesResolver();
+    closeStopEvent();
+    closeSentDataEvent();
 }
@@ -41,7 +41,8 @@
 void runBtConnection(const int sockDescr);
 
 /**
- * Initialize connection before listening
+ * Initialize connection before listening.
+ * Should be called before the connection's thread starts, the data rings are emptied
  * @return socket descriptor or ERR
  */
 const int initBtConnectionBeforeListen();
@@ -0,0 +1,505 @@
+/**
+ * @file
+ * The cache of the names of the bluetooth adapters
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "BtNames.h"
+#include "BlueToothLib.h"
+#include "Log.h"
+
+#include <bluetooth/hci.h>
+#include <bluetooth/hci_lib.h>
+
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define TAG "BT_NAMES"                                       /**< The tag for writing to the log file */
+
+#define CACHED_NAMES_NUM 16                                  /**< The number of the cached names of the remote adapters */
+#define PENDING_NAMES_NUM 8                                  /**< The number of the addresses waiting for resolving */
+#define RESOLVE_TIMEOUT_MS 5000                              /**< The timeout of reading a name from an adapter in milliseconds */
+
+/**
+ * \struct CachedBtName
+ * \brief The resolved name of a remote adapter
+ */
+struct CachedBtName
+{
+    bdaddr_t addr;                                           /**< The address of the adapter */
+    char name[MAX_BT_DEV_NAME_LEN];                          /**< The name of the adapter */
+};
+
+struct CachedBtName cachedNames[CACHED_NAMES_NUM];           /**< The names of the remote adapters kept across the connections */
+size_t cachedNamesNum = 0;                                   /**< The number of the used entries of the cache */
+size_t oldestCachedName = 0;                                 /**< The entry replaced when the cache is full */
+
+char localName[MAX_BT_DEV_NAME_LEN] = { 0 };                 /**< The name of the local adapter */
+bool isLocalNameResolved = false;                            /**< Has the name of the local adapter been read */
+
+bdaddr_t pendingAddrs[PENDING_NAMES_NUM];                    /**< The addresses waiting for resolving, BDADDR_ANY is the local adapter */
+size_t pendingAddrsNum = 0;                                  /**< The number of the addresses waiting for resolving */
+
+pthread_t resolverThread;                                    /**< The thread resolving the names */
+bool isResolverRunning = false;                              /**< Is the resolver thread running */
+bool isResolverStopped = false;                              /**< Should the resolver thread exit */
+
+pthread_mutex_t namesMutex = PTHREAD_MUTEX_INITIALIZER;      /**< The mutex of the cache and of the pending addresses */
+pthread_cond_t hasPendingAddrs = PTHREAD_COND_INITIALIZER;   /**< Signaled when an address is pending or the resolver is stopped */
+int resolverStopEvent = ERR;                                 /**< The event interrupting the reading of a name when the resolver is stopped */
+
+/**
+ * Find the cached name of the adapter with the given address. Should be called with the locked mutex
+ * @param addr The address of the adapter
+ * @return The cached name or NULL
+ */
+static struct CachedBtName* findCachedBtName(const bdaddr_t *addr)
+{
+    size_t i;
+    for(i = 0; i < cachedNamesNum; i++)
+	{
+	    if(bacmp(&cachedNames[i].addr, addr) == 0)
+		return &cachedNames[i];
+	}
+    return NULL;
+}
+
+/**
+ * Is the given address waiting for resolving. Should be called with the locked mutex
+ * @param addr The address of the adapter
+ * @return true The address is pending
+ */
+static bool isBtAddrPending(const bdaddr_t *addr)
+{
+    size_t i;
+    for(i = 0; i < pendingAddrsNum; i++)
+	{
+	    if(bacmp(&pendingAddrs[i], addr) == 0)
+		return true;
+	}
+    return false;
+}
+
+/**
+ * Add the given address to the addresses waiting for resolving and wake up the resolver
+ * @param addr The address of the adapter
+ */
+static void pushPendingBtAddr(const bdaddr_t *addr)
+{
+    pthread_mutex_lock(&namesMutex);
+    if( (pendingAddrsNum < PENDING_NAMES_NUM) && !isBtAddrPending(addr) )
+	{
+	    bacpy(&pendingAddrs[pendingAddrsNum++], addr);
+	    pthread_cond_signal(&hasPendingAddrs);
+	}
+    pthread_mutex_unlock(&namesMutex);
+}
+
+/**
+ * Put the resolved name of the remote adapter to the cache, the oldest name is replaced if the cache is full.
+ * Should be called with the locked mutex
+ * @param addr The address of the adapter
+ * @param name The name of the adapter
+ */
+static void cacheBtName(const bdaddr_t *addr, const char *name)
+{
+    struct CachedBtName *cached = findCachedBtName(addr);
+    if(cached == NULL)
+	{
+	    if(cachedNamesNum < CACHED_NAMES_NUM)
+		cached = &cachedNames[cachedNamesNum++];
+	    else
+		{
+		    cached = &cachedNames[oldestCachedName];
+		    oldestCachedName = (oldestCachedName + 1) % CACHED_NAMES_NUM;
+		}
+	    bacpy(&cached->addr, addr);
+	}
+    strncpy(cached->name, name, MAX_BT_DEV_NAME_LEN - 1);
+    cached->name[MAX_BT_DEV_NAME_LEN - 1] = '\0';
+}
+
+/**
+ * Get the current time of the monotonic clock
+ * @return The time in milliseconds
+ */
+static long long getTimeMs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * Wait for the event finishing the given request of the local adapter and copy its parameters.
+ * The waiting is interrupted by stopping the resolver
+ * @param adapterHandler The handler of the local adapter
+ * @param opcode The opcode of the request's command
+ * @param request The request, its event is EVT_REMOTE_NAME_REQ_COMPLETE or 0 for the command's completion
+ * @return ERR or NO_ERR, errno is ECANCELED if the resolver has been stopped
+ */
+static const int waitForHciReply(const int adapterHandler, const uint16_t opcode, struct hci_request *request)
+{
+    struct pollfd descrs[2] = { { resolverStopEvent, POLLIN, 0 }, { adapterHandler, POLLIN, 0 } };
+    const long long deadline = getTimeMs() + RESOLVE_TIMEOUT_MS;
+    unsigned char buff[HCI_MAX_EVENT_SIZE];
+    while(true)
+	{
+	    const long long timeout = deadline - getTimeMs();
+	    if(timeout <= 0)
+		{
+		    errno = ETIMEDOUT;
+		    return ERR;
+		}
+	    descrs[0].revents = descrs[1].revents = 0;
+	    if(poll(descrs, 2, timeout) < 0)
+		{
+		    if(errno == EINTR)
+			continue;
+		    return ERR;
+		}
+	    if(descrs[0].revents & POLLIN)
+		{
+		    errno = ECANCELED;
+		    return ERR;
+		}
+	    if(!(descrs[1].revents & POLLIN))
+		continue;
+
+	    ssize_t len = read(adapterHandler, buff, sizeof(buff));
+	    if(len < 0)
+		{
+		    if( (errno == EINTR) || (errno == EAGAIN) )
+			continue;
+		    return ERR;
+		}
+	    len -= 1 + HCI_EVENT_HDR_SIZE;
+	    if(len < 0)
+		continue;
+	    const hci_event_hdr *header = (const hci_event_hdr*)(buff + 1);
+	    const unsigned char *params = buff + 1 + HCI_EVENT_HDR_SIZE;
+
+	    if( (header->evt == EVT_CMD_STATUS) && (((const evt_cmd_status*)params)->opcode == opcode) )
+		{
+		    if(((const evt_cmd_status*)params)->status == 0)
+			continue;
+		    errno = EIO;
+		    return ERR;
+		}
+	    if( (header->evt == EVT_CMD_COMPLETE) && (request->event == 0) &&
+		(((const evt_cmd_complete*)params)->opcode == opcode) )
+		{
+		    params += EVT_CMD_COMPLETE_SIZE;
+		    len -= EVT_CMD_COMPLETE_SIZE;
+		}
+	    else if( (header->evt != request->event) || (request->event != EVT_REMOTE_NAME_REQ_COMPLETE) ||
+		     (bacmp(&((const evt_remote_name_req_complete*)params)->bdaddr, &((const remote_name_req_cp*)request->cparam)->bdaddr) != 0) )
+		continue;
+
+	    memcpy(request->rparam, params, (len < request->rlen) ? len: request->rlen);
+	    return NO_ERR;
+	}
+}
+
+/**
+ * Send the request to the local adapter and wait for its reply, like hci_send_req() does,
+ * but the waiting is interrupted by stopping the resolver
+ * @param adapterHandler The handler of the local adapter
+ * @param request The request
+ * @return ERR or NO_ERR, errno is ECANCELED if the resolver has been stopped
+ */
+static const int sendHciRequest(const int adapterHandler, struct hci_request *request)
+{
+    struct hci_filter oldFilter, filter;
+    socklen_t filterLen = sizeof(oldFilter);
+    if(getsockopt(adapterHandler, SOL_HCI, HCI_FILTER, &oldFilter, &filterLen) < 0)
+	return ERR;
+
+    const uint16_t opcode = htobs(cmd_opcode_pack(request->ogf, request->ocf));
+    hci_filter_clear(&filter);
+    hci_filter_set_ptype(HCI_EVENT_PKT, &filter);
+    hci_filter_set_event(EVT_CMD_STATUS, &filter);
+    hci_filter_set_event(EVT_CMD_COMPLETE, &filter);
+    if(request->event != 0)
+	hci_filter_set_event(request->event, &filter);
+    hci_filter_set_opcode(opcode, &filter);
+    if(setsockopt(adapterHandler, SOL_HCI, HCI_FILTER, &filter, sizeof(filter)) < 0)
+	return ERR;
+
+    int res = ERR;
+    if(hci_send_cmd(adapterHandler, request->ogf, request->ocf, request->clen, request->cparam) == 0)
+	res = waitForHciReply(adapterHandler, opcode, request);
+
+    const int error = errno;
+    setsockopt(adapterHandler, SOL_HCI, HCI_FILTER, &oldFilter, sizeof(oldFilter));
+    errno = error;
+    return res;
+}
+
+/**
+ * Read the name of the adapter with the given address from the local adapter
+ * @param addr The address of the remote adapter or BDADDR_ANY for the local one
+ * @param name The buffer of the name, its length is MAX_BT_DEV_NAME_LEN
+ * @return ERR or NO_ERR
+ */
+static const int readBtName(const bdaddr_t *addr, char *name)
+{
+    const int adapterHandler = hci_open_dev(hci_get_route(NULL));
+    if(adapterHandler < 0)
+	{
+	    writeToLog2("ERROR: Can't open the local adapter:", strerror(errno), TAG);
+	    return ERR;
+	}
+
+    const bool isLocal = (bacmp(addr, BDADDR_ANY) == 0);
+    read_local_name_rp localReply;
+    remote_name_req_cp remoteParams;
+    evt_remote_name_req_complete remoteReply;
+    struct hci_request request;
+    memset(&request, 0, sizeof(request));
+    if(isLocal)
+	{
+	    request.ogf    = OGF_HOST_CTL;
+	    request.ocf    = OCF_READ_LOCAL_NAME;
+	    request.rparam = &localReply;
+	    request.rlen   = READ_LOCAL_NAME_RP_SIZE;
+	}
+    else
+	{
+	    memset(&remoteParams, 0, sizeof(remoteParams));
+	    bacpy(&remoteParams.bdaddr, addr);
+	    remoteParams.pscan_rep_mode = 0x02;
+	    request.ogf    = OGF_LINK_CTL;
+	    request.ocf    = OCF_REMOTE_NAME_REQ;
+	    request.event  = EVT_REMOTE_NAME_REQ_COMPLETE;
+	    request.cparam = &remoteParams;
+	    request.clen   = REMOTE_NAME_REQ_CP_SIZE;
+	    request.rparam = &remoteReply;
+	    request.rlen   = EVT_REMOTE_NAME_REQ_COMPLETE_SIZE;
+	}
+
+    int res = sendHciRequest(adapterHandler, &request);
+    if( (res == NO_ERR) && ((isLocal ? localReply.status: remoteReply.status) != 0) )
+	{
+	    errno = EIO;
+	    res = ERR;
+	}
+    if(res == NO_ERR)
+	memcpy(name, isLocal ? localReply.name: remoteReply.name, MAX_BT_DEV_NAME_LEN - 1);
+    else if(errno != ECANCELED)
+	writeToLog2(isLocal ? "ERROR: Can't get the local adapter's name: ": "ERROR: Can't get the remote adapter's name: ",
+		    strerror(errno), TAG);
+    close(adapterHandler);
+
+    name[MAX_BT_DEV_NAME_LEN - 1] = '\0';
+    return res;
+}
+
+/**
+ * The function of the resolver thread. Reads the names of the pending addresses until the resolver is stopped
+ * @param arg Not used
+ * @return NULL
+ */
+static void* runBtNamesResolver(void *arg)
+{
+    pthread_mutex_lock(&namesMutex);
+    while(!isResolverStopped)
+	{
+	    if(pendingAddrsNum == 0)
+		{
+		    pthread_cond_wait(&hasPendingAddrs, &namesMutex);
+		    continue;
+		}
+	    bdaddr_t addr;
+	    bacpy(&addr, &pendingAddrs[0]);
+	    pthread_mutex_unlock(&namesMutex);
+
+	    char name[MAX_BT_DEV_NAME_LEN] = { 0 };
+	    const int res = readBtName(&addr, name);
+
+	    pthread_mutex_lock(&namesMutex);
+	    if(res == NO_ERR)
+		{
+		    if(bacmp(&addr, BDADDR_ANY) == 0)
+			{
+			    strcpy(localName, name);
+			    isLocalNameResolved = true;
+			}
+		    else
+			cacheBtName(&addr, name);
+		}
+	    --pendingAddrsNum;
+	    memmove(pendingAddrs, pendingAddrs + 1, pendingAddrsNum * sizeof(bdaddr_t));
+	}
+    pthread_mutex_unlock(&namesMutex);
+    return NULL;
+}
+
+/**
+ * Start the thread resolving the names of the adapters.
+ * The reading of the local adapter's name is requested
+ * @return ERR or NO_ERR
+ */
+const int startBtNamesResolver()
+{
+    pthread_mutex_lock(&namesMutex);
+    if( (resolverStopEvent == ERR) && ((resolverStopEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == ERR) )
+	writeToLog2("ERROR: Can't create the event stopping the resolver, its stopping waits for the reading of a name: ",
+		    strerror(errno), TAG);
+    if(!isResolverRunning)
+	{
+	    uint64_t counter;
+	    if( (resolverStopEvent != ERR) && (read(resolverStopEvent, &counter, sizeof(counter)) < 0) && (errno != EAGAIN) )
+		writeToLog2("ERROR: Can't reset the event stopping the resolver: ", strerror(errno), TAG);
+	    isResolverStopped = false;
+	    isResolverRunning = (pthread_create(&resolverThread, NULL, runBtNamesResolver, NULL) == 0);
+	    if(!isResolverRunning)
+		writeToLog("ERROR: Can't start the thread resolving the adapters' names\n", TAG);
+	}
+    const bool isRunning = isResolverRunning;
+    const bool isLocalResolved = isLocalNameResolved;
+    pthread_mutex_unlock(&namesMutex);
+
+    if(!isRunning)
+	return ERR;
+    if(!isLocalResolved)
+	pushPendingBtAddr(BDADDR_ANY);
+    return NO_ERR;
+}
+
+/**
+ * Stop the thread resolving the names of the adapters.
+ * The reading of a name in progress is interrupted. The resolved names are kept in the cache
+ */
+void stopBtNamesResolver()
+{
+    pthread_mutex_lock(&namesMutex);
+    const bool isRunning = isResolverRunning;
+    isResolverStopped = true;
+    isResolverRunning = false;
+    pthread_cond_signal(&hasPendingAddrs);
+    const uint64_t one = 1;
+    if( isRunning && (resolverStopEvent != ERR) && (write(resolverStopEvent, &one, sizeof(one)) != sizeof(one)) )
+	writeToLog2("ERROR: Can't signal the event stopping the resolver: ", strerror(errno), TAG);
+    pthread_mutex_unlock(&namesMutex);
+
+    if(isRunning)
+	pthread_join(resolverThread, NULL);
+
+    pthread_mutex_lock(&namesMutex);
+    pendingAddrsNum = 0;
+    pthread_mutex_unlock(&namesMutex);
+}
+
+/**
+ * Request resolving the name of the remote adapter with the given address.
+ * Nothing is requested if the name is already in the cache
+ * @param addr The address of the adapter
+ */
+void resolveBtName(const bdaddr_t *addr)
+{
+    pthread_mutex_lock(&namesMutex);
+    const bool isCached = (findCachedBtName(addr) != NULL);
+    pthread_mutex_unlock(&namesMutex);
+
+    if(!isCached)
+	pushPendingBtAddr(addr);
+}
+
+/**
+ * Get the name of the remote adapter with the given address
+ * @param addr The address of the adapter
+ * @param name The buffer of the name
+ * @param len The length of the buffer
+ * @return true The cached name is got, false the address string is got because the name isn't resolved yet
+ */
+bool getBtName(const bdaddr_t *addr, char *name, const size_t len)
+{
+    if(len == 0)
+	return false;
+
+    pthread_mutex_lock(&namesMutex);
+    const struct CachedBtName *cached = findCachedBtName(addr);
+    if(cached != NULL)
+	{
+	    strncpy(name, cached->name, len - 1);
+	    name[len - 1] = '\0';
+	}
+    pthread_mutex_unlock(&namesMutex);
+
+    if(cached != NULL)
+	return true;
+
+    char addrStr[18] = { 0 };
+    ba2str(addr, addrStr);
+    strncpy(name, addrStr, len - 1);
+    name[len - 1] = '\0';
+    return false;
+}
+
+/**
+ * Get the name of the local adapter.
+ * While the name isn't resolved its reading is requested again, e.g. after a failed reading
+ * @param name The buffer of the name
+ * @param len The length of the buffer
+ * @return true The name is got, false the address string of the local adapter is got because the name isn't resolved yet
+ */
+bool getLocalBtName(char *name, const size_t len)
+{
+    if(len == 0)
+	return false;
+
+    pthread_mutex_lock(&namesMutex);
+    const bool isResolved = isLocalNameResolved;
+    const bool isRunning = isResolverRunning;
+    if(isResolved)
+	{
+	    strncpy(name, localName, len - 1);
+	    name[len - 1] = '\0';
+	}
+    pthread_mutex_unlock(&namesMutex);
+    if(isResolved)
+	return true;
+
+    if(isRunning)
+	pushPendingBtAddr(BDADDR_ANY);
+
+    bdaddr_t addr;
+    char addrStr[18] = { 0 };
+    if(hci_devba(hci_get_route(NULL), &addr) < 0)
+	writeToLog2("ERROR: Can't get the local adapter's address: ", strerror(errno), TAG);
+    else
+	ba2str(&addr, addrStr);
+    strncpy(name, addrStr, len - 1);
+    name[len - 1] = '\0';
+    return false;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file
+ * The cache of the names of the bluetooth adapters.
+ * The names are read by the resolver thread, so the connections aren't blocked by the reading
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __BT_NAMES_H
+#define __BT_NAMES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <bluetooth/bluetooth.h>
+
+#define MAX_BT_DEV_NAME_LEN 50                               /**< The maximal length of bluetooth device */
+
+/**
+ * Start the thread resolving the names of the adapters.
+ * The reading of the local adapter's name is requested
+ * @return ERR or NO_ERR
+ */
+const int startBtNamesResolver();
+
+/**
+ * Stop the thread resolving the names of the adapters.
+ * The reading of a name in progress is interrupted. The resolved names are kept in the cache
+ */
+void stopBtNamesResolver();
+
+/**
+ * Request resolving the name of the remote adapter with the given address.
+ * Nothing is requested if the name is already in the cache
+ * @param addr The address of the adapter
+ */
+void resolveBtName(const bdaddr_t *addr);
+
+/**
+ * Get the name of the remote adapter with the given address
+ * @param addr The address of the adapter
+ * @param name The buffer of the name
+ * @param len The length of the buffer
+ * @return true The cached name is got, false the address string is got because the name isn't resolved yet
+ */
+bool getBtName(const bdaddr_t *addr, char *name, const size_t len);
+
+/**
+ * Get the name of the local adapter.
+ * While the name isn't resolved its reading is requested again, e.g. after a failed reading
+ * @param name The buffer of the name
+ * @param len The length of the buffer
+ * @return true The name is got, false the address string of the local adapter is got because the name isn't resolved yet
+ */
+bool getLocalBtName(char *name, const size_t len);
+
+#endif
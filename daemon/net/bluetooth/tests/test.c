@@ -20,13 +20,15 @@
 void *printReceivedData()
 {
     char *receivedData = NULL;
+    int connId = NO_CONNECTION;
+    int reqId  = NO_REQUEST;
     const char* datas[] = {"hello", "false", "75", "end", "hello", "false", "50", "end"};
 
     printf ("Start receiving data run\n");
     int i;
     for(i = 0; i < 8; ++i)
 	{
-	    while(receivedData = getReceivedData())
+	    while(receivedData = getReceivedData(&connId, &reqId))
 		{
 		    const size_t len = strlen(receivedData);
 		    if(len != 0)
@@ -45,7 +47,7 @@ void *printReceivedData()
 			}
 		}
 		
-	    setSentData(datas[i]);
+	    setSentData(connId, reqId, datas[i]);
 	    if(i == 7)
 		setRunStatus(STOP);
 	}
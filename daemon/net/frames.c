@@ -0,0 +1,355 @@
+/**
+ * @file
+ * Messages of the network protocol: text lines and binary frames
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "synchronise.h"
+#include "frames.h"
+#include "CommandsNames.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+const char* commandsNames[] = COMMANDS_NAMES_BY_OPCODES;      /**< The names of the commands indexed by their opcodes */
+#define OPCODES_NUM (sizeof(commandsNames) / sizeof(commandsNames[0]))   /**< The number of the opcodes */
+
+/**
+ * Extract the text line ended by '\n' from the given data.
+ * The legacy client sends a command by a packet without EOL, then its unterminated data is taken as a whole command
+ * @param data The received data
+ * @param len The length of the data
+ * @param isLegacyClient Does the client send the commands without EOL
+ * @param command The buffer of DATA_LEN length for the line without its EOL
+ * @param isValid Is the line not too long
+ * @return The number of bytes of the line, 0 if the line hasn't arrived completely or INVALID_MESSAGE if it's too long
+ *         and its end hasn't arrived
+ */
+static const int parseLine(const char *data, const size_t len, const bool isLegacyClient, char *command, bool *isValid)
+{
+    const char *eol = memchr(data, '\n', len);
+    if( (eol == NULL) && isLegacyClient )
+	{
+	    *isValid = (len < DATA_LEN);
+	    const size_t commandLen = *isValid ? len: 0;
+	    memcpy(command, data, commandLen);
+	    command[commandLen] = '\0';
+	    return len;
+	}
+    if(eol == NULL)
+	return (len < DATA_LEN) ? 0: INVALID_MESSAGE;
+
+    size_t lineLen = eol - data;
+    if( (lineLen != 0) && (data[lineLen - 1] == '\r') )   // remove EOL
+	--lineLen;
+
+    *isValid = (lineLen < DATA_LEN);
+    if(!*isValid)
+	lineLen = 0;
+    memcpy(command, data, lineLen);
+    command[lineLen] = '\0';
+    return eol - data + 1;
+}
+
+/**
+ * Extract the binary frame from the given data and translate it into the text of its command
+ * @param data The received data
+ * @param len The length of the data
+ * @param command The buffer of DATA_LEN length for the text of the command
+ * @param reqId The request ID of the frame
+ * @param isValid Are the parameters of the frame valid
+ * @return The number of bytes of the frame, 0 if the frame hasn't arrived completely or INVALID_MESSAGE if its length is invalid
+ */
+static const int parseFrame(const char *data, const size_t len, char *command, int *reqId, bool *isValid)
+{
+    const uint8_t *bytes = (const uint8_t*) data;
+    if(len < 3)
+	return 0;
+
+    const size_t frameLen = 3 + ((bytes[1] << 8) | bytes[2]);
+    if( (frameLen < FRAME_HEADER_LEN) || (frameLen > MAX_FRAME_LEN) )
+	return INVALID_MESSAGE;
+    if(len < frameLen)
+	return 0;
+
+    *reqId = (bytes[3] << 8) | bytes[4];
+    *isValid = false;
+    command[0] = '\0';
+
+    const uint8_t opcode = bytes[5];
+    size_t commandLen = 0;
+    if( (opcode < OPCODES_NUM) && (commandsNames[opcode] != NULL) )
+	commandLen = snprintf(command, DATA_LEN, "%s", commandsNames[opcode]);
+    else
+	commandLen = snprintf(command, DATA_LEN, "%u", opcode);   // the dispatcher answers ERR to the unknown command
+
+    size_t pos = FRAME_HEADER_LEN;
+    while(pos < frameLen)
+	{
+	    const size_t paramLen = bytes[pos++];
+	    if( (pos + paramLen > frameLen) || (commandLen + 1 + paramLen >= DATA_LEN) )
+		{
+		    command[0] = '\0';
+		    return frameLen;
+		}
+	    command[commandLen++] = ' ';
+	    memcpy(command + commandLen, bytes + pos, paramLen);
+	    commandLen += paramLen;
+	    pos += paramLen;
+	}
+    command[commandLen] = '\0';
+
+    *isValid = true;
+    return frameLen;
+}
+
+/**
+ * Extract the next message from the given received data: a text line or a binary frame.
+ * The frame is translated into the text of its command
+ * @param data The received data
+ * @param len The length of the data
+ * @param isLegacyClient Does the client send the text commands without EOL, a command by a packet
+ * @param command The buffer of DATA_LEN length for the text of the command
+ * @param reqId The request ID of the frame or NO_REQUEST for a text line
+ * @param isValid Is the extracted message valid
+ * @return The number of bytes of the message, 0 if the message hasn't arrived completely or INVALID_MESSAGE
+ */
+const int parseMessage(const char *data, const size_t len, const bool isLegacyClient, char *command, int *reqId, bool *isValid)
+{
+    if(len == 0)
+	return 0;
+
+    if((uint8_t)data[0] == FRAME_MAGIC)
+	return parseFrame(data, len, command, reqId, isValid);
+
+    *reqId = NO_REQUEST;
+    return parseLine(data, len, isLegacyClient, command, isValid);
+}
+
+/**
+ * Is the given text the command of the volume's change
+ * @param txt The text
+ * @param name The name of the command
+ * @return true The text is the command with the given name followed by its parameter
+ */
+static bool isVolCommand(const char *txt, const char *name)
+{
+    const size_t len = strlen(name);
+    return (strncmp(txt, name, len) == 0) && (txt[len] == ' ');
+}
+
+/**
+ * Parse the value of the volume's command, it's the whole rest of the text
+ * @param txt The text of the value
+ * @param min The minimal value
+ * @param max The maximal value
+ * @param value The parsed value
+ * @return true The text is an integer between the minimal and the maximal values
+ */
+static bool parseVolValue(const char *txt, const long min, const long max, int *value)
+{
+    const char *digits = (txt[0] == '-') ? txt + 1: txt;
+    if( (*digits < '0') || (*digits > '9') )
+	return false;
+
+    char *end = NULL;
+    errno = 0;
+    const long num = strtol(txt, &end, 10);
+    if( (*end != '\0') || (errno != 0) || (num < min) || (num > max) )
+	return false;
+    *value = num;
+    return true;
+}
+
+/**
+ * Parse the datagram of the volume's change.
+ * Only the command of the volume's change with one integer value is accepted, nothing can follow it
+ * @param data The received datagram
+ * @param len The length of the datagram
+ * @param seq The sequence number of the datagram
+ * @param isSetVol Is the command SET_VOL, otherwise it's CHG_VOL
+ * @param value The value of the command
+ * @return true The datagram is valid
+ */
+bool parseVolDatagram(const char *data, const size_t len, uint32_t *seq, bool *isSetVol, int *value)
+{
+    if( (len == 0) || (len >= MAX_DATAGRAM_LEN) )
+	return false;
+
+    char txt[MAX_DATAGRAM_LEN] = {'\0'};
+    memcpy(txt, data, len);
+    txt[strcspn(txt, "\r\n")] = '\0';
+
+    char *end = NULL;
+    const unsigned long num = strtoul(txt, &end, 10);
+    if( (end == txt) || (*end != ' ') || (num > UINT32_MAX) )
+	return false;
+
+    const char *cmd = end + 1;
+    if(isVolCommand(cmd, SET_VOL))
+	{
+	    if(!parseVolValue(cmd + strlen(SET_VOL) + 1, 0, MAX_DATAGRAM_VOL, value))
+		return false;
+	    *isSetVol = true;
+	}
+    else if(isVolCommand(cmd, CHG_VOL))
+	{
+	    if(!parseVolValue(cmd + strlen(CHG_VOL) + 1, -MAX_DATAGRAM_VOL, MAX_DATAGRAM_VOL, value))
+		return false;
+	    *isSetVol = false;
+	}
+    else
+	return false;
+
+    *seq = num;
+    return true;
+}
+
+/**
+ * Limit the given volume's value
+ * @param value The value
+ * @param min The minimal value
+ * @param max The maximal value
+ * @return The limited value
+ */
+static int limitVolValue(const int value, const int min, const int max)
+{
+    return (value < min) ? min: ((value > max) ? max: value);
+}
+
+/**
+ * Add the command of the volume's datagram to the waiting command.
+ * SET_VOL replaces the waiting command, the values of CHG_VOL are summed
+ * @param command The waiting command
+ * @param isSetVol Is the added command SET_VOL, otherwise it's CHG_VOL
+ * @param value The value of the added command
+ */
+void addVolCommand(struct VolCommand *command, const bool isSetVol, const int value)
+{
+    if(!command->isWaiting || isSetVol)
+	{
+	    command->hasSetVol = false;
+	    command->volChange = 0;
+	}
+    if(isSetVol)
+	{
+	    command->hasSetVol = true;
+	    command->setVol    = value;
+	}
+    else
+	command->volChange = limitVolValue(command->volChange + value, -MAX_DATAGRAM_VOL, MAX_DATAGRAM_VOL);
+    command->isWaiting = true;
+}
+
+/**
+ * Take the text of the waiting command: the latest SET_VOL changed by the sum of the following CHG_VOL values
+ * or CHG_VOL by the sum of the values
+ * @param command The waiting command, it isn't waiting any more
+ * @param txt The buffer of DATA_LEN length for the text of the command
+ * @return false There is no command to pass, nothing is waiting or the values of CHG_VOL are summed to 0
+ */
+bool takeVolCommand(struct VolCommand *command, char *txt)
+{
+    if(!command->isWaiting)
+	return false;
+    command->isWaiting = false;
+
+    if(command->hasSetVol)
+	snprintf(txt, DATA_LEN, "%s %d", SET_VOL, limitVolValue(command->setVol + command->volChange, 0, MAX_DATAGRAM_VOL));
+    else if(command->volChange != 0)
+	snprintf(txt, DATA_LEN, "%s %d", CHG_VOL, command->volChange);
+    else
+	return false;
+    return true;
+}
+
+/**
+ * Build the frame of the given reply or notification
+ * @param buff The buffer for the frame
+ * @param buffLen The length of the buffer
+ * @param reqId The ID of the request the reply belongs to
+ * @param opcode REPLY_OPCODE or NOTIFICATION_OPCODE
+ * @param dataStr The text of the reply, its words are the parameters of the frame
+ * @return The length of the frame or 0 if it can't be built
+ */
+static const size_t buildFrame(char *buff, const size_t buffLen, const int reqId, const int opcode, const char *dataStr)
+{
+    if(buffLen < FRAME_HEADER_LEN)
+	return 0;
+
+    uint8_t *bytes = (uint8_t*) buff;
+    size_t len = FRAME_HEADER_LEN;
+    const char *word = dataStr;
+    while(*word != '\0')
+	{
+	    const size_t wordLen = strcspn(word, " \r\n");
+	    if(wordLen != 0)
+		{
+		    if( (wordLen > UINT8_MAX) || (len + 1 + wordLen > buffLen) )
+			return 0;
+		    bytes[len++] = wordLen;
+		    memcpy(bytes + len, word, wordLen);
+		    len += wordLen;
+		}
+	    word += wordLen;
+	    word += strspn(word, " \r\n");
+	}
+
+    bytes[0] = FRAME_MAGIC;
+    bytes[1] = (len - 3) >> 8;
+    bytes[2] = (len - 3) & 0xFF;
+    bytes[3] = (reqId >> 8) & 0xFF;
+    bytes[4] = reqId & 0xFF;
+    bytes[5] = opcode;
+    return len;
+}
+
+/**
+ * Build the frame of the given reply
+ * @param buff The buffer for the frame
+ * @param buffLen The length of the buffer
+ * @param reqId The ID of the request the reply belongs to
+ * @param dataStr The text of the reply, its words are the parameters of the frame
+ * @return The length of the frame or 0 if it can't be built
+ */
+const size_t buildReplyFrame(char *buff, const size_t buffLen, const int reqId, const char *dataStr)
+{
+    return buildFrame(buff, buffLen, reqId, REPLY_OPCODE, dataStr);
+}
+
+/**
+ * Build the frame of the given notification
+ * @param buff The buffer for the frame
+ * @param buffLen The length of the buffer
+ * @param dataStr The text of the notification, its words are the parameters of the frame
+ * @return The length of the frame or 0 if it can't be built
+ */
+const size_t buildNotificationFrame(char *buff, const size_t buffLen, const char *dataStr)
+{
+    return buildFrame(buff, buffLen, 0, NOTIFICATION_OPCODE, dataStr);
+}
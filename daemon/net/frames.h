@@ -0,0 +1,142 @@
+/**
+ * @file
+ * Messages of the network protocol: text lines and binary frames
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __FRAMES_H
+#define __FRAMES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * The binary frame:
+ *   byte 0      FRAME_MAGIC
+ *   bytes 1-2   The length of the rest of the frame, big endian
+ *   bytes 3-4   The request ID, big endian. The reply has the ID of its request
+ *   byte 5      The opcode of the command(see CommandsNames.h), REPLY_OPCODE or NOTIFICATION_OPCODE
+ *   bytes 6-    The parameters, every one is its length byte followed by its bytes
+ * The text line is the command's name and parameters separated by spaces and ended by '\n'.
+ * The clients may send both of them, many messages can arrive by one packet.
+ * The legacy clients send a text command by a packet without '\n', a client is taken as legacy until
+ * it sends its first '\n' or frame
+ */
+#define FRAME_MAGIC 0xA5                                      /**< The first byte of a frame, it can't start a text line */
+#define FRAME_HEADER_LEN 6                                    /**< The length of the frame's header */
+#define MAX_FRAME_LEN (FRAME_HEADER_LEN + DATA_LEN)           /**< The maximal length of a frame */
+
+#define INVALID_MESSAGE -1                                    /**< The result of parsing the data which can't be split into messages any more */
+#define INVALID_MESSAGE_REPLY "ERR"                           /**< The reply to the invalid frame, the same as the dispatcher's reply to an invalid command */
+
+/**
+ * Extract the next message from the given received data: a text line or a binary frame.
+ * The frame is translated into the text of its command.
+ * The complete message which can't be translated(a too long line, a frame with invalid parameters) is
+ * not valid, it should be skipped by its length. If the length of the message can't be known(a too long
+ * line without its end, a frame's header with an invalid length) the data can't be parsed any more
+ * @param data The received data
+ * @param len The length of the data
+ * @param isLegacyClient Does the client send the text commands without EOL, a command by a packet.
+ *        Then the unterminated text at the end of the data is taken as a whole command
+ * @param command The buffer of DATA_LEN length for the text of the command
+ * @param reqId The request ID of the frame or NO_REQUEST for a text line
+ * @param isValid Is the extracted message valid
+ * @return The number of bytes of the message, 0 if the message hasn't arrived completely or INVALID_MESSAGE
+ */
+const int parseMessage(const char *data, const size_t len, const bool isLegacyClient, char *command, int *reqId, bool *isValid);
+
+/**
+ * The datagram of the volume's change is the text: "SEQUENCE_NUMBER COMMAND VALUE",
+ * where the command is SET_VOL or CHG_VOL, the value is an integer and the sequence number is increased
+ * by the client for every datagram. Nothing can follow the value, the datagram can't carry other commands.
+ * The datagrams are sent without replies, the stale ones are dropped
+ */
+#define MAX_DATAGRAM_LEN (DATA_LEN + 11)                      /**< The maximal length of a datagram, the sequence number and the command */
+#define MAX_DATAGRAM_VOL 100                                  /**< The maximal value of SET_VOL and the maximal absolute value of CHG_VOL */
+
+/**
+ * Parse the datagram of the volume's change.
+ * Only the command of the volume's change with one integer value is accepted, nothing can follow it
+ * @param data The received datagram
+ * @param len The length of the datagram
+ * @param seq The sequence number of the datagram
+ * @param isSetVol Is the command SET_VOL, otherwise it's CHG_VOL
+ * @param value The value of the command
+ * @return true The datagram is valid
+ */
+bool parseVolDatagram(const char *data, const size_t len, uint32_t *seq, bool *isSetVol, int *value);
+
+/**
+ * \struct VolCommand
+ * \brief The command of the volume's datagrams arrived from a sender, it's waiting for passing to the dispatcher
+ */
+struct VolCommand
+{
+    bool isWaiting;                                           /**< Is the command waiting */
+    bool hasSetVol;                                           /**< Has a SET_VOL arrived */
+    int setVol;                                               /**< The value of the latest SET_VOL */
+    int volChange;                                            /**< The sum of the CHG_VOL values arrived after the latest SET_VOL */
+};
+
+/**
+ * Add the command of the volume's datagram to the waiting command.
+ * SET_VOL replaces the waiting command, the values of CHG_VOL are summed
+ * @param command The waiting command
+ * @param isSetVol Is the added command SET_VOL, otherwise it's CHG_VOL
+ * @param value The value of the added command
+ */
+void addVolCommand(struct VolCommand *command, const bool isSetVol, const int value);
+
+/**
+ * Take the text of the waiting command: the latest SET_VOL changed by the sum of the following CHG_VOL values
+ * or CHG_VOL by the sum of the values
+ * @param command The waiting command, it isn't waiting any more
+ * @param txt The buffer of DATA_LEN length for the text of the command
+ * @return false There is no command to pass, nothing is waiting or the values of CHG_VOL are summed to 0
+ */
+bool takeVolCommand(struct VolCommand *command, char *txt);
+
+/**
+ * Build the frame of the given reply
+ * @param buff The buffer for the frame
+ * @param buffLen The length of the buffer
+ * @param reqId The ID of the request the reply belongs to
+ * @param dataStr The text of the reply, its words are the parameters of the frame
+ * @return The length of the frame or 0 if it can't be built
+ */
+const size_t buildReplyFrame(char *buff, const size_t buffLen, const int reqId, const char *dataStr);
+
+/**
+ * Build the frame of the given notification
+ * @param buff The buffer for the frame
+ * @param buffLen The length of the buffer
+ * @param dataStr The text of the notification, its words are the parameters of the frame
+ * @return The length of the frame or 0 if it can't be built
+ */
+const size_t buildNotificationFrame(char *buff, const size_t buffLen, const char *dataStr);
+
+#endif
@@ -28,98 +28,323 @@
 
 
 #include "synchronise.h"
+#include "frames.h"
+#include "Log.h"
+#include "Trace.h"
 
 #include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+#define ERR -1                             /**< The code of an error */
+#define SENT_SPACE_WAIT_MS 100             /**< The timeout of waiting for the space in the ring of the sent data, the run status is checked after it */
+
+/**
+ * \struct DataRecord
+ * \brief The data string passed between the connection's thread and the dispatcher
+ */
+struct DataRecord
+{
+    int connId;                            /**< The ID of the connection the data belongs to */
+    int reqId;                             /**< The ID of the request the data belongs to or NO_REQUEST */
+    char data[DATA_LEN];                   /**< The string of the data */
+};
+
+/**
+ * \struct DataRing
+ * \brief The lock free ring of the data records with a single producer and a single consumer.
+ * Only the producer moves the tail and only the consumer moves the head
+ */
+struct DataRing
+{
+    struct DataRecord records[MAX_DATA_RECORDS_NUM];   /**< The records */
+    atomic_size_t head;                                /**< The counter of the records popped by the consumer */
+    atomic_size_t tail;                                /**< The counter of the records pushed by the producer */
+};
 
 int runStatus = RUN;                       /**< The run status: running or stopped */
 
-int  receivedDataStatus = NO_NEW_DATA;     /**< The status of receiving data */
+struct DataRing receivedData;              /**< The ring of the received data strings. Used when there is no callback */
+char receivedDataStr[DATA_LEN] = {'\0'};   /**< The buffer of the last popped received data */
 
-char sentData[DATA_LEN] = {'\0'};          /**< The buffer for the sent data */
+struct DataRing sentData;                  /**< The ring of the data strings waiting for sending */
 
-char receivedData[DATA_LEN] = {'\0'};      /**< The buffer for the received data */
+int sentDataEvent = ERR;                   /**< The event signaled when there is a data for sending */
+int sentSpaceEvent = ERR;                  /**< The event signaled when the full ring of the sent data has got a free record */
+atomic_bool isWaitingForSentSpace = false; /**< Is the producer of the sent data waiting for the space in the full ring */
+int stopEvent = ERR;                       /**< The event signaled when the connection should be stopped */
 
-pthread_mutex_t mutexData;                 /**< The mutex for synchronising data */
-pthread_mutex_t mutexStop;                 /**< The mutex for synchronising running */
+pthread_mutex_t mutexStop = PTHREAD_MUTEX_INITIALIZER;   /**< The mutex for synchronising running */
+
+DataArrivedCallback dataArrivedCallback = NULL;   /**< The function called when a new data has arrived */
+void *dataArrivedContext = NULL;                  /**< The context of the function called when a new data has arrived */
 
 #define TAG "synchronise"                  /**< The tag for logs */
 
 /**
- * Destroy mutexes
+ * Empty the given ring
+ * @param ring The ring
+ */
+static void clearRing(struct DataRing *ring)
+{
+    atomic_store(&ring->head, 0);
+    atomic_store(&ring->tail, 0);
+}
+
+/**
+ * Push the data record into the given ring. Should be called by the ring's producer only
+ * @param ring The ring
+ * @param connId The ID of the connection the data belongs to
+ * @param reqId The ID of the request the data belongs to
+ * @param dataStr The string of the data
+ * @return false The ring is full, the data hasn't been pushed
+ */
+static bool pushRecord(struct DataRing *ring, const int connId, const int reqId, const char *dataStr)
+{
+    const size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if(tail - atomic_load_explicit(&ring->head, memory_order_acquire) == MAX_DATA_RECORDS_NUM)
+	return false;
+
+    struct DataRecord *record = &ring->records[tail % MAX_DATA_RECORDS_NUM];
+    record->connId = connId;
+    record->reqId  = reqId;
+    strncpy(record->data, dataStr, DATA_LEN - 1);
+    record->data[DATA_LEN - 1] = '\0';
+
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Pop the data record from the given ring. Should be called by the ring's consumer only
+ * @param ring The ring
+ * @param connId The ID of the connection the data belongs to
+ * @param reqId The ID of the request the data belongs to
+ * @param dataStr The buffer of DATA_LEN length for the data string
+ * @return false The ring is empty
+ */
+static bool popRecord(struct DataRing *ring, int *connId, int *reqId, char *dataStr)
+{
+    const size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if(head == atomic_load_explicit(&ring->tail, memory_order_acquire))
+	return false;
+
+    const struct DataRecord *record = &ring->records[head % MAX_DATA_RECORDS_NUM];
+    *connId = record->connId;
+    *reqId  = record->reqId;
+    strcpy(dataStr, record->data);
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Is the given ring full
+ * @param ring The ring
+ * @return true There is no free record
  */
-void destroyMutexes()
+static bool isRingFull(struct DataRing *ring)
 {
-    pthread_mutex_destroy(&mutexStop);
-    pthread_mutex_destroy(&mutexData);
+    return atomic_load(&ring->tail) - atomic_load(&ring->head) == MAX_DATA_RECORDS_NUM;
+}
+
+/**
+ * Prepare the synchronisation of a new connection's thread: empty the data rings, create
+ * the event of the space in the ring of the sent data and set the status of running to RUN.
+ * Should be called before the connection's thread starts, while no thread produces or consumes the rings' data,
+ * so stopping the connection before its thread has started isn't overridden
+ */
+void initSynchronisation()
+{
+    clearRing(&sentData);
+    clearRing(&receivedData);
+
+    if( (sentSpaceEvent == ERR) && ((sentSpaceEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == ERR) )
+	writeToLog2("ERROR initSynchronisation(): Can't create the event of the space for sending: ", strerror(errno), TAG);
+
+    setRunStatus(RUN);
 }
 
 /**
- * Initialize mutexes
+ * Initialize the event signaled when there is a data for sending
+ * @return The descriptor of the event or ERR
  */
-void initMutexes()
+const int initSentDataEvent()
 {
-    pthread_mutex_init(&mutexStop, NULL);
-    pthread_mutex_init(&mutexData, NULL);    
+    sentDataEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return sentDataEvent;
 }
 
 /**
- * Get pointer to the sent data string
- * @return The string of the sent data
+ * Close the event signaled when there is a data for sending
  */
-char* getSentData()
+void closeSentDataEvent()
 {
-    return sentData;
+    if(sentDataEvent != ERR)
+	close(sentDataEvent);
+    sentDataEvent = ERR;
 }
 
 /**
- * Set data string for sending
+ * Initialize the event signaled when the status of running is set to STOP
+ * @return The descriptor of the event or ERR
+ */
+const int initStopEvent()
+{
+    pthread_mutex_lock (&mutexStop);
+    stopEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    pthread_mutex_unlock(&mutexStop);
+    return stopEvent;
+}
+
+/**
+ * Close the event signaled when the status of running is set to STOP
+ */
+void closeStopEvent()
+{
+    pthread_mutex_lock (&mutexStop);
+    if(stopEvent != ERR)
+	close(stopEvent);
+    stopEvent = ERR;
+    pthread_mutex_unlock(&mutexStop);
+}
+
+/**
+ * Pop the next data string waiting for sending.
+ * Should be called by the connection's thread only
+ * @param connId The ID of the connection the data should be sent to
+ * @param reqId The ID of the request the data is the reply to or NO_REQUEST
+ * @param dataStr The buffer of DATA_LEN length for the data string
+ * @return true There was a data for sending
+ */
+bool getSentData(int *connId, int *reqId, char *dataStr)
+{
+    if(!popRecord(&sentData, connId, reqId, dataStr))
+	return false;
+
+    // the pop is ordered before checking the flag, so the producer setting the flag
+    // either sees the free record or is signaled
+    atomic_thread_fence(memory_order_seq_cst);
+    const uint64_t one = 1;
+    if( atomic_load(&isWaitingForSentSpace) && (sentSpaceEvent != ERR) &&
+	(write(sentSpaceEvent, &one, sizeof(one)) != sizeof(one)) )
+	writeToLog2("ERROR getSentData(): Can't signal the event of the space for sending: ", strerror(errno), TAG);
+    return true;
+}
+
+/**
+ * Wait until the connection's thread pops a record from the full ring of the sent data.
+ * The flag of waiting is set before checking the ring, so every pop while the producer waits signals it.
+ * The waiting is finished without the space if the connection is stopped
+ * @return false The connection is stopped and the ring is still full
+ */
+static bool waitForSentSpace()
+{
+    if(!isRingFull(&sentData))
+	return true;
+
+    struct pollfd descr;
+    descr.fd     = sentSpaceEvent;
+    descr.events = POLLIN;
+    atomic_store(&isWaitingForSentSpace, true);
+    while(isRingFull(&sentData))
+	{
+	    if( (getRunStatus() == STOP) || (sentSpaceEvent == ERR) )
+		{
+		    atomic_store(&isWaitingForSentSpace, false);
+		    return false;
+		}
+	    if( (poll(&descr, 1, SENT_SPACE_WAIT_MS) > 0) && (descr.revents & POLLIN) )
+		{
+		    uint64_t counter;
+		    if(read(sentSpaceEvent, &counter, sizeof(counter)) != sizeof(counter))
+			continue;
+		}
+	}
+    atomic_store(&isWaitingForSentSpace, false);
+    return true;
+}
+
+/**
+ * Set data string for sending to the given connection.
+ * Should be called by a single thread. If there are MAX_DATA_RECORDS_NUM strings waiting already,
+ * the thread waits until the connection's thread sends one of them. The data is dropped only if the connection is stopped.
+ * The data string not shorter than DATA_LEN is replaced by INVALID_MESSAGE_REPLY, it's never truncated
+ * @param connId The ID of the connection the data should be sent to
+ * @param reqId The ID of the request the data is the reply to or NO_REQUEST
  * @param dataStr data string
  */
-void setSentData(const char *dataStr)
+void setSentData(const int connId, const int reqId, const char *dataStr)
 {
-    pthread_mutex_lock(&mutexData);
-    if(strlen(sentData) != 0)
-	bzero(sentData, DATA_LEN);
-    strcpy(sentData, dataStr);
-    pthread_mutex_unlock(&mutexData);
+    if(strlen(dataStr) >= DATA_LEN)
+	{
+	    writeToLog2("ERROR setSentData(): The data string is too long, it's replaced by the error reply: ", dataStr, TAG);
+	    dataStr = INVALID_MESSAGE_REPLY;
+	}
+    if( !waitForSentSpace() || !pushRecord(&sentData, connId, reqId, dataStr) )
+	{
+	    writeToLog2("ERROR setSentData(): The connection is stopped, the data string is dropped: ", dataStr, TAG);
+	    return;
+	}
+    traceInstant("reply_queued", connId, reqId);
+
+    if(sentDataEvent != ERR)
+	{
+	    const uint64_t one = 1;
+	    if(write(sentDataEvent, &one, sizeof(one)) != sizeof(one))
+		return;
+	}
 }
 
 /**
- * Set received data string by the given string
+ * Set received data string by the given string.
+ * The data is passed to the callback if it has been set, otherwise it waits for getReceivedData()
+ * @param connId The ID of the connection the data arrived from
+ * @param reqId The ID of the request the data arrived by or NO_REQUEST
  * @param dataStr The string for setting received data
  */
-void setReceivedData(const char *dataStr)
+void setReceivedData(const int connId, const int reqId, const char *dataStr)
 {
-    pthread_mutex_lock(&mutexData);
-    strcpy(receivedData, dataStr);
-    pthread_mutex_unlock(&mutexData);
+    const uint64_t start = TRACE_START();
+    if(dataArrivedCallback != NULL)
+	dataArrivedCallback(connId, reqId, dataStr, dataArrivedContext);
+    else if(!pushRecord(&receivedData, connId, reqId, dataStr))
+	writeToLog2("ERROR setReceivedData(): There is no space for the received data string: ", dataStr, TAG);
+    traceSpan("received", connId, reqId, start);
 }
 
 /**
- * Get the deceived data string
- * @return The received data string
+ * Get the received data string. Should be called by a single thread
+ * @param connId The ID of the connection the data arrived from
+ * @param reqId The ID of the request the data arrived by or NO_REQUEST
+ * @return The received data string or "" if there is no new data
  */
-char* getReceivedData() 
+char* getReceivedData(int *connId, int *reqId) 
 {
-    pthread_mutex_lock(&mutexData);
-    if(receivedDataStatus == HAS_NEW_DATA)
+    if(!popRecord(&receivedData, connId, reqId, receivedDataStr))
 	{
-	    receivedDataStatus = NO_NEW_DATA;
-	    pthread_mutex_unlock(&mutexData);
-	    return receivedData;
+	    *connId = NO_CONNECTION;
+	    *reqId  = NO_REQUEST;
+	    receivedDataStr[0] = '\0';
 	}
-    pthread_mutex_unlock(&mutexData);
-    return "";
+    return receivedDataStr;
 }
 
 /**
- * Set the status of running
+ * Set the status of running. Setting STOP signals the stop event
  * @param status The status: RUN or STOP
  */
 void setRunStatus(const int status)
 {
+    const uint64_t one = 1;
     pthread_mutex_lock (&mutexStop);
     runStatus = status;
+    if( (status == STOP) && (stopEvent != ERR) && (write(stopEvent, &one, sizeof(one)) == ERR) )
+	writeToLog2("ERROR: Can't signal the stop event: ", strerror(errno), TAG);
     pthread_mutex_unlock(&mutexStop);
 }
 
@@ -137,12 +362,13 @@ const int getRunStatus()
 }
 
 /**
- * Set the status of the recieved data
- * @param status HAS_NEW_DATA or NO_NEW_DATA
+ * Set the function which should be called when a new data has arrived.
+ * Should be called before running the connection
+ * @param callback The function or NULL
+ * @param context The context which the function should be called with
  */
-void setReceivedDataStatus(const int status) 
+void setDataArrivedCallback(DataArrivedCallback callback, void *context)
 {
-    pthread_mutex_lock (&mutexData);
-    receivedDataStatus = status;
-    pthread_mutex_unlock(&mutexData);
+    dataArrivedCallback = callback;
+    dataArrivedContext  = context;
 }
@@ -31,53 +31,108 @@
 #define __SYNCHRONISE_H
 
 #include <pthread.h>
+#include <stdbool.h>
 
 #define RUN  2                             /**< The connection is running */
 #define STOP 3                             /**< The connection is stopped */
 
-#define NO_NEW_DATA  0                     /**< No new data received */
-#define HAS_NEW_DATA 1                     /**< The new data arrived */
+#define DATA_LEN 256                       /**< The length of the data string with its terminating null, the longest message: a command, a batch of commands or a reply */
 
-#define DATA_LEN 50                        /**< The data length */                        
+#define NO_CONNECTION -1                   /**< The ID of a not existing connection */
+#define ALL_CONNECTIONS -2                 /**< The ID addressing the data to all the connections */
+#define DATAGRAM_CONNECTION -3             /**< The ID of the datagrams' channel, the replies to the datagrams aren't sent */
 
-#define MILLISECONDS_SLEEP_TIME 500        /**< The sleep time in milli seconds */
+#define NO_REQUEST -1                      /**< The request ID of the data not belonging to a request of the binary protocol */
+
+#define MAX_DATA_RECORDS_NUM 32            /**< The maximal number of the data strings waiting for sending or for receiving */
+
+/**
+ * The function called when a new data has arrived
+ * @param connId The ID of the connection the data arrived from
+ * @param reqId The ID of the request the data arrived by or NO_REQUEST
+ * @param dataStr The string of the arrived data
+ * @param context The context given while setting the callback
+ */
+typedef void (*DataArrivedCallback)(const int connId, const int reqId, const char *dataStr, void *context);
+
+/**
+ * Set the function which should be called when a new data has arrived.
+ * Should be called before running the connection
+ * @param callback The function or NULL
+ * @param context The context which the function should be called with
+ */
+void setDataArrivedCallback(DataArrivedCallback callback, void *context);
+
+/**
+ * Prepare the synchronisation of a new connection's thread: empty the data rings, create
+ * the event of the space in the ring of the sent data and set the status of running to RUN.
+ * Should be called before the connection's thread starts, while no thread produces or consumes the rings' data,
+ * so stopping the connection before its thread has started isn't overridden
+ */
+void initSynchronisation();
 
 /**
- * Destroy mutexes
+ * Initialize the event signaled when there is a data for sending
+ * @return The descriptor of the event or ERR
  */
-void destroyMutexes();
+const int initSentDataEvent();
 
 /**
- * Initialize mutexes
+ * Close the event signaled when there is a data for sending
  */
-void initMutexes();
+void closeSentDataEvent();
 
 /**
- * Get pointer to the sent data string
- * @return The string of the sent data
+ * Initialize the event signaled when the status of running is set to STOP
+ * @return The descriptor of the event or ERR
  */
-char* getSentData();
+const int initStopEvent();
 
 /**
- * Set data string for sending
+ * Close the event signaled when the status of running is set to STOP
+ */
+void closeStopEvent();
+
+/**
+ * Pop the next data string waiting for sending.
+ * Should be called by the connection's thread only
+ * @param connId The ID of the connection the data should be sent to
+ * @param reqId The ID of the request the data is the reply to or NO_REQUEST
+ * @param dataStr The buffer of DATA_LEN length for the data string
+ * @return true There was a data for sending
+ */
+bool getSentData(int *connId, int *reqId, char *dataStr);
+
+/**
+ * Set data string for sending to the given connection.
+ * Should be called by a single thread. If there are MAX_DATA_RECORDS_NUM strings waiting already,
+ * the thread waits until the connection's thread sends one of them. The data is dropped only if the connection is stopped.
+ * The data string not shorter than DATA_LEN is replaced by INVALID_MESSAGE_REPLY, it's never truncated
+ * @param connId The ID of the connection the data should be sent to
+ * @param reqId The ID of the request the data is the reply to or NO_REQUEST
  * @param dataStr data string
  */
-void setSentData(const char *dataStr);
+void setSentData(const int connId, const int reqId, const char *dataStr);
 
 /**
- * Get the received data string
- * @return The received data string
+ * Get the received data string. Should be called by a single thread
+ * @param connId The ID of the connection the data arrived from
+ * @param reqId The ID of the request the data arrived by or NO_REQUEST
+ * @return The received data string or "" if there is no new data
  */
-char* getReceivedData();
+char* getReceivedData(int *connId, int *reqId);
 
 /**
- * Set received data string by the given string
+ * Set received data string by the given string.
+ * The data is passed to the callback if it has been set, otherwise it waits for getReceivedData()
+ * @param connId The ID of the connection the data arrived from
+ * @param reqId The ID of the request the data arrived by or NO_REQUEST
  * @param dataStr The string for setting received data
  */
-void setReceivedData(const char *dataStr);
+void setReceivedData(const int connId, const int reqId, const char *dataStr);
 
 /**
- * Set the status of running
+ * Set the status of running. Setting STOP signals the stop event
  * @param status The status: RUN or STOP
  */
 void setRunStatus(const int status);
@@ -88,10 +143,4 @@ void setRunStatus(const int status);
  */
 const int getRunStatus();
 
-/**
- * Set the status of the recieved data
- * @param status HAS_NEW_DATA or NO_NEW_DATA
- */
-void setReceivedDataStatus(const int status);
-
 #endif
@@ -0,0 +1,286 @@
+#include "CUnit/Basic.h"
+#include "../synchronise.h"
+#include "../frames.h"
+
+#include <string.h>
+#include <stdint.h>
+
+#define HELLO_OPCODE   1
+#define CHG_VOL_OPCODE 10
+
+char command[DATA_LEN] = {'\0'};
+int reqId = NO_REQUEST;
+bool isValid = false;
+
+int initSuite(void)
+{
+    return 0;
+}
+
+int cleanSuite(void)
+{
+    return 0;
+}
+
+/**
+ * Write the header of a frame to the given buffer
+ * @param buff The buffer
+ * @param restLen The length of the frame after the length's bytes
+ * @param id The request ID
+ * @param opcode The opcode
+ * @return The length of the header
+ */
+size_t writeHeader(uint8_t *buff, const size_t restLen, const int id, const uint8_t opcode)
+{
+    buff[0] = FRAME_MAGIC;
+    buff[1] = restLen >> 8;
+    buff[2] = restLen & 0xFF;
+    buff[3] = id >> 8;
+    buff[4] = id & 0xFF;
+    buff[5] = opcode;
+    return FRAME_HEADER_LEN;
+}
+
+void testTextLines()
+{
+    const char data[] = "hello\r\nget_vol\n";
+    int len = parseMessage(data, strlen(data), false, command, &reqId, &isValid);
+    CU_ASSERT_EQUAL(len, 7);
+    CU_ASSERT_TRUE(isValid);
+    CU_ASSERT_EQUAL(reqId, NO_REQUEST);
+    CU_ASSERT_STRING_EQUAL(command, "hello");
+
+    len = parseMessage(data + 7, strlen(data) - 7, false, command, &reqId, &isValid);
+    CU_ASSERT_EQUAL(len, 8);
+    CU_ASSERT_STRING_EQUAL(command, "get_vol");
+
+    CU_ASSERT_EQUAL(parseMessage("mute", 4, false, command, &reqId, &isValid), 0);
+}
+
+void testTwoFramesInBuffer()
+{
+    uint8_t data[2 * MAX_FRAME_LEN];
+    size_t len = writeHeader(data, 3, 7, HELLO_OPCODE);
+    len += writeHeader(data + len, 5, 8, CHG_VOL_OPCODE);
+    data[len++] = 1;
+    data[len++] = '5';
+
+    int parsed = parseMessage((char*)data, len, false, command, &reqId, &isValid);
+    CU_ASSERT_EQUAL(parsed, FRAME_HEADER_LEN);
+    CU_ASSERT_TRUE(isValid);
+    CU_ASSERT_EQUAL(reqId, 7);
+    CU_ASSERT_STRING_EQUAL(command, "hello");
+
+    parsed = parseMessage((char*)data + FRAME_HEADER_LEN, len - FRAME_HEADER_LEN, false, command, &reqId, &isValid);
+    CU_ASSERT_EQUAL(parsed, FRAME_HEADER_LEN + 2);
+    CU_ASSERT_TRUE(isValid);
+    CU_ASSERT_EQUAL(reqId, 8);
+    CU_ASSERT_STRING_EQUAL(command, "chg_vol 5");
+}
+
+void testTruncatedFrame()
+{
+    uint8_t data[MAX_FRAME_LEN];
+    size_t len = writeHeader(data, 5, 9, CHG_VOL_OPCODE);
+    data[len++] = 1;
+    data[len++] = '5';
+
+    CU_ASSERT_EQUAL(parseMessage((char*)data, 2, false, command, &reqId, &isValid), 0);
+    CU_ASSERT_EQUAL(parseMessage((char*)data, FRAME_HEADER_LEN, false, command, &reqId, &isValid), 0);
+    CU_ASSERT_EQUAL(parseMessage((char*)data, len - 1, false, command, &reqId, &isValid), 0);
+    CU_ASSERT_EQUAL(parseMessage((char*)data, len, false, command, &reqId, &isValid), len);
+}
+
+void testBadMagic()
+{
+    uint8_t data[DATA_LEN + 10];
+    memset(data, 'x', sizeof(data));
+    writeHeader(data, 3, 7, HELLO_OPCODE);
+    data[0] = FRAME_MAGIC - 1;
+
+    CU_ASSERT_EQUAL(parseMessage((char*)data, FRAME_HEADER_LEN, false, command, &reqId, &isValid), 0);
+    CU_ASSERT_EQUAL(parseMessage((char*)data, sizeof(data), false, command, &reqId, &isValid), INVALID_MESSAGE);
+}
+
+void testOversizedLength()
+{
+    uint8_t data[MAX_FRAME_LEN];
+    writeHeader(data, 0xFFFF, 7, HELLO_OPCODE);
+    CU_ASSERT_EQUAL(parseMessage((char*)data, sizeof(data), false, command, &reqId, &isValid), INVALID_MESSAGE);
+
+    writeHeader(data, MAX_FRAME_LEN - 2, 7, HELLO_OPCODE);
+    CU_ASSERT_EQUAL(parseMessage((char*)data, sizeof(data), false, command, &reqId, &isValid), INVALID_MESSAGE);
+
+    writeHeader(data, 2, 7, HELLO_OPCODE);
+    CU_ASSERT_EQUAL(parseMessage((char*)data, sizeof(data), false, command, &reqId, &isValid), INVALID_MESSAGE);
+}
+
+void testInvalidParamsSkipped()
+{
+    uint8_t data[2 * MAX_FRAME_LEN];
+    size_t len = writeHeader(data, 5, 10, CHG_VOL_OPCODE);
+    data[len++] = 5;                                  // the parameter is longer than the frame
+    data[len++] = '5';
+    const size_t invalidLen = len;
+    len += writeHeader(data + len, 3, 11, HELLO_OPCODE);
+
+    int parsed = parseMessage((char*)data, len, false, command, &reqId, &isValid);
+    CU_ASSERT_EQUAL(parsed, invalidLen);
+    CU_ASSERT_FALSE(isValid);
+    CU_ASSERT_EQUAL(reqId, 10);
+    CU_ASSERT_STRING_EQUAL(command, "");
+
+    parsed = parseMessage((char*)data + invalidLen, len - invalidLen, false, command, &reqId, &isValid);
+    CU_ASSERT_EQUAL(parsed, FRAME_HEADER_LEN);
+    CU_ASSERT_TRUE(isValid);
+    CU_ASSERT_EQUAL(reqId, 11);
+    CU_ASSERT_STRING_EQUAL(command, "hello");
+}
+
+void testTooLongLineSkipped()
+{
+    char data[2 * DATA_LEN];
+    memset(data, 'x', DATA_LEN + 5);
+    data[DATA_LEN + 5] = '\n';
+    strcpy(data + DATA_LEN + 6, "mute\n");
+
+    int parsed = parseMessage(data, strlen(data), false, command, &reqId, &isValid);
+    CU_ASSERT_EQUAL(parsed, DATA_LEN + 6);
+    CU_ASSERT_FALSE(isValid);
+
+    parsed = parseMessage(data + parsed, strlen(data) - parsed, false, command, &reqId, &isValid);
+    CU_ASSERT_EQUAL(parsed, 5);
+    CU_ASSERT_TRUE(isValid);
+    CU_ASSERT_STRING_EQUAL(command, "mute");
+}
+
+void testUnterminatedLegacyLine()
+{
+    const char data[] = "chg_vol 5";
+    CU_ASSERT_EQUAL(parseMessage(data, strlen(data), true, command, &reqId, &isValid), strlen(data));
+    CU_ASSERT_TRUE(isValid);
+    CU_ASSERT_EQUAL(reqId, NO_REQUEST);
+    CU_ASSERT_STRING_EQUAL(command, "chg_vol 5");
+
+    const char lines[] = "hello\nget_vol";
+    CU_ASSERT_EQUAL(parseMessage(lines, strlen(lines), true, command, &reqId, &isValid), 6);
+    CU_ASSERT_STRING_EQUAL(command, "hello");
+    CU_ASSERT_EQUAL(parseMessage(lines + 6, strlen(lines) - 6, false, command, &reqId, &isValid), 0);
+
+    char tooLong[DATA_LEN + 5];
+    memset(tooLong, 'x', sizeof(tooLong));
+    CU_ASSERT_EQUAL(parseMessage(tooLong, sizeof(tooLong), true, command, &reqId, &isValid), sizeof(tooLong));
+    CU_ASSERT_FALSE(isValid);
+}
+
+void testVolDatagrams()
+{
+    uint32_t seq = 0;
+    bool isSetVol = false;
+    int value = 0;
+    const char setVol[] = "7 set_vol 55\n";
+    CU_ASSERT_TRUE(parseVolDatagram(setVol, strlen(setVol), &seq, &isSetVol, &value));
+    CU_ASSERT_EQUAL(seq, 7);
+    CU_ASSERT_TRUE(isSetVol);
+    CU_ASSERT_EQUAL(value, 55);
+
+    const char chgVol[] = "8 chg_vol -3";
+    CU_ASSERT_TRUE(parseVolDatagram(chgVol, strlen(chgVol), &seq, &isSetVol, &value));
+    CU_ASSERT_FALSE(isSetVol);
+    CU_ASSERT_EQUAL(value, -3);
+}
+
+void testInvalidVolDatagrams()
+{
+    const char *datagrams[] = { "7 chg_vol 1;quit", "7 set_vol 5;change_port 1", "7 chg_vol 1 2", "7 chg_vol  1",
+				"7 chg_vol x", "7 set_vol 101", "7 set_vol -1", "7 chg_vol 99999999999", "7 mute", "chg_vol 1" };
+    uint32_t seq = 0;
+    bool isSetVol = false;
+    int value = 0;
+    size_t i;
+    for(i = 0; i < sizeof(datagrams) / sizeof(datagrams[0]); i++)
+	CU_ASSERT_FALSE(parseVolDatagram(datagrams[i], strlen(datagrams[i]), &seq, &isSetVol, &value));
+}
+
+void testSummedVolChanges()
+{
+    struct VolCommand volCommand;
+    memset(&volCommand, 0, sizeof(volCommand));
+    CU_ASSERT_FALSE(takeVolCommand(&volCommand, command));
+
+    addVolCommand(&volCommand, false, 5);
+    addVolCommand(&volCommand, false, 5);
+    CU_ASSERT_TRUE(takeVolCommand(&volCommand, command));
+    CU_ASSERT_STRING_EQUAL(command, "chg_vol 10");
+    CU_ASSERT_FALSE(takeVolCommand(&volCommand, command));
+
+    addVolCommand(&volCommand, false, 5);
+    addVolCommand(&volCommand, true, 40);
+    addVolCommand(&volCommand, false, -3);
+    CU_ASSERT_TRUE(takeVolCommand(&volCommand, command));
+    CU_ASSERT_STRING_EQUAL(command, "set_vol 37");
+
+    addVolCommand(&volCommand, false, 5);
+    addVolCommand(&volCommand, false, -5);
+    CU_ASSERT_FALSE(takeVolCommand(&volCommand, command));
+}
+
+void testBuildFrames()
+{
+    char frame[MAX_FRAME_LEN];
+    const uint8_t *bytes = (const uint8_t*) frame;
+
+    size_t len = buildReplyFrame(frame, sizeof(frame), 300, "OK 55");
+    CU_ASSERT_EQUAL(len, FRAME_HEADER_LEN + 3 + 3);
+    CU_ASSERT_EQUAL(bytes[0], FRAME_MAGIC);
+    CU_ASSERT_EQUAL((bytes[1] << 8) | bytes[2], len - 3);
+    CU_ASSERT_EQUAL((bytes[3] << 8) | bytes[4], 300);
+    CU_ASSERT_EQUAL(bytes[5], 0);
+    CU_ASSERT_EQUAL(bytes[6], 2);
+    CU_ASSERT_EQUAL(memcmp(frame + 7, "OK", 2), 0);
+    CU_ASSERT_EQUAL(bytes[9], 2);
+    CU_ASSERT_EQUAL(memcmp(frame + 10, "55", 2), 0);
+
+    len = buildNotificationFrame(frame, sizeof(frame), "vol 40");
+    CU_ASSERT_EQUAL(len, FRAME_HEADER_LEN + 4 + 3);
+    CU_ASSERT_EQUAL(bytes[5], 255);
+
+    CU_ASSERT_EQUAL(buildReplyFrame(frame, FRAME_HEADER_LEN + 3, 1, "OK 55"), 0);
+    CU_ASSERT_EQUAL(buildReplyFrame(frame, FRAME_HEADER_LEN - 1, 1, ""), 0);
+}
+
+int main()
+{
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   CU_pSuite pSuite = CU_add_suite("Frames", initSuite, cleanSuite);
+   if (NULL == pSuite)
+       {
+	   CU_cleanup_registry();
+	   return CU_get_error();
+       }
+
+   if (NULL == CU_add_test(pSuite, "text lines                ", testTextLines)            ||
+       NULL == CU_add_test(pSuite, "two frames in one buffer  ", testTwoFramesInBuffer)    ||
+       NULL == CU_add_test(pSuite, "truncated frame           ", testTruncatedFrame)       ||
+       NULL == CU_add_test(pSuite, "bad magic                 ", testBadMagic)             ||
+       NULL == CU_add_test(pSuite, "oversized length          ", testOversizedLength)      ||
+       NULL == CU_add_test(pSuite, "invalid parameters skipped", testInvalidParamsSkipped) ||
+       NULL == CU_add_test(pSuite, "too long line skipped     ", testTooLongLineSkipped)   ||
+       NULL == CU_add_test(pSuite, "unterminated legacy line  ", testUnterminatedLegacyLine) ||
+       NULL == CU_add_test(pSuite, "volume's datagrams        ", testVolDatagrams)         ||
+       NULL == CU_add_test(pSuite, "invalid volume's datagrams", testInvalidVolDatagrams)  ||
+       NULL == CU_add_test(pSuite, "summed volume's changes   ", testSummedVolChanges)     ||
+       NULL == CU_add_test(pSuite, "building frames           ", testBuildFrames))
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   CU_basic_set_mode(CU_BRM_VERBOSE);
+   CU_basic_run_tests();
+
+   CU_cleanup_registry();
+   return CU_get_error();
+}
@@ -31,77 +31,349 @@
 #include "SocketsLib.h"
 
 #include <stdlib.h>
+#include <stdbool.h>
 #include <strings.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include <sys/socket.h> 
 #include <sys/types.h>
+#include <sys/ioctl.h>
 #include <netdb.h>
+#include <net/if.h>
 #include <arpa/inet.h>
 #include <ifaddrs.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 
 
-#define ETH  "eth" 
-#define WLAN "wlan"
-
 #define TAG "IP_OPS"      /**< tag for writing to the log file */
 
 #define UNKNOWN "UNKNOWN"
 
+#define MAX_LOCAL_ADDRS_NUM 16                  /**< The maximal number of the kept local addresses */
+#define NETLINK_BUFF_LEN 8192                   /**< The length of the buffer of the received netlink messages */
+
 /**
- * Copy the local IP to the given string
- * @param str String for copying IP to
+ * \struct LocalAddr
+ * \brief The usable address of a local interface
  */
-void copyLocalIp2Str(char *str)
+struct LocalAddr
+{
+    int ifIndex;                                /**< The index of the interface */
+    int family;                                 /**< AF_INET or AF_INET6 */
+    char ip[LOCAL_IP_STR_LEN];                  /**< The string of the address */
+};
+
+struct LocalAddr localAddrs[MAX_LOCAL_ADDRS_NUM];                 /**< The usable addresses of all the local interfaces */
+size_t localAddrsNum = 0;                                         /**< The number of the kept local addresses */
+bool areLocalAddrsLoaded = false;                                 /**< Have the local addresses been loaded */
+pthread_mutex_t mutexLocalAddrs = PTHREAD_MUTEX_INITIALIZER;      /**< The mutex of the local addresses */
+
+/**
+ * Find the kept local address. Should be called with the locked mutex
+ * @param ifIndex The index of the interface
+ * @param family The family of the address
+ * @param ip The string of the address
+ * @return The index of the address in the table or ERR
+ */
+static const int findLocalAddr(const int ifIndex, const int family, const char *ip)
+{
+    size_t i;
+    for(i = 0; i < localAddrsNum; i++)
+	{
+	    if( (localAddrs[i].ifIndex == ifIndex) && (localAddrs[i].family == family) && (strcmp(localAddrs[i].ip, ip) == 0) )
+		return i;
+	}
+    return ERR;
+}
+
+/**
+ * Add the local address to the table. Should be called with the locked mutex
+ * @param ifIndex The index of the interface
+ * @param family The family of the address
+ * @param ip The string of the address
+ * @return true The table has been changed
+ */
+static bool addLocalAddr(const int ifIndex, const int family, const char *ip)
+{
+    if(findLocalAddr(ifIndex, family, ip) != ERR)
+	return false;
+    if(localAddrsNum == MAX_LOCAL_ADDRS_NUM)
+	{
+	    writeToLog2("WARNING: The table of the local addresses is full, the address is ignored: ", ip, TAG);
+	    return false;
+	}
+    localAddrs[localAddrsNum].ifIndex = ifIndex;
+    localAddrs[localAddrsNum].family  = family;
+    strncpy(localAddrs[localAddrsNum].ip, ip, LOCAL_IP_STR_LEN - 1);
+    localAddrs[localAddrsNum].ip[LOCAL_IP_STR_LEN - 1] = '\0';
+    ++localAddrsNum;
+    return true;
+}
+
+/**
+ * Remove the local address from the table. Should be called with the locked mutex
+ * @param ifIndex The index of the interface
+ * @param family The family of the address
+ * @param ip The string of the address
+ * @return true The table has been changed
+ */
+static bool removeLocalAddr(const int ifIndex, const int family, const char *ip)
+{
+    const int idx = findLocalAddr(ifIndex, family, ip);
+    if(idx == ERR)
+	return false;
+    --localAddrsNum;
+    memmove(localAddrs + idx, localAddrs + idx + 1, (localAddrsNum - idx) * sizeof(struct LocalAddr));
+    return true;
+}
+
+/**
+ * Is the local interface with the given flags usable: it's up and isn't the loopback
+ * @param flags The flags of the interface
+ * @return true The interface is usable
+ */
+static bool isUsableInterface(const unsigned int flags)
+{
+    return (flags & IFF_UP) && !(flags & IFF_LOOPBACK);
+}
+
+/**
+ * Is the local interface with the given index usable
+ * @param ifIndex The index of the interface
+ * @return true The interface is usable
+ */
+static bool isUsableInterfaceIndex(const int ifIndex)
+{
+    struct ifreq req;
+    memset(&req, 0, sizeof(req));
+    if(if_indextoname(ifIndex, req.ifr_name) == NULL)
+	return false;
+
+    const int descr = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if(descr == ERR)
+	{
+	    writeToLog2("ERROR in isUsableInterfaceIndex(): ", strerror(errno), TAG);
+	    return false;
+	}
+    const bool isUsable = (ioctl(descr, SIOCGIFFLAGS, &req) != ERR) && isUsableInterface(req.ifr_flags);
+    close(descr);
+    return isUsable;
+}
+
+/**
+ * Is the local address usable: the loopback and the link-local(169.254.0.0/16, fe80::/10) addresses aren't usable
+ * @param family AF_INET or AF_INET6
+ * @param addr The pointer to struct in_addr or struct in6_addr
+ * @return true The address is usable
+ */
+static bool isUsableAddr(const int family, const void *addr)
+{
+    if(family == AF_INET)
+	{
+	    const unsigned char *bytes = (const unsigned char*) addr;
+	    return (bytes[0] != 127) && !((bytes[0] == 169) && (bytes[1] == 254));
+	}
+    const struct in6_addr *addr6 = (const struct in6_addr*) addr;
+    return !IN6_IS_ADDR_LOOPBACK(addr6) && !IN6_IS_ADDR_LINKLOCAL(addr6);
+}
+
+/**
+ * Load the usable addresses of all the usable local interfaces
+ * @return true The table of the local addresses has been changed
+ */
+static bool loadLocalAddrs()
 {
     struct ifaddrs *ifaddr, *ifa;
-    
-    if (getifaddrs(&ifaddr) == ERR) {
-	writeToLog2("ERROR in copyLocalIp2Str(): ", strerror(errno), TAG);
-	strcpy(str, UNKNOWN);
-	return;
-    }
-
-    int family, s;
-    char host[NI_MAXHOST] = {'\0'};
-    size_t sock_addr_size;
-    
+    if (getifaddrs(&ifaddr) == ERR)
+	{
+	    writeToLog2("ERROR in loadLocalAddrs(): ", strerror(errno), TAG);
+	    return false;
+	}
+
+    pthread_mutex_lock(&mutexLocalAddrs);
+    struct LocalAddr oldAddrs[MAX_LOCAL_ADDRS_NUM];
+    const size_t oldAddrsNum = localAddrsNum;
+    memcpy(oldAddrs, localAddrs, localAddrsNum * sizeof(struct LocalAddr));
+
+    localAddrsNum = 0;
     for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next)
 	{
-	    if (ifa->ifa_addr == NULL)
+	    if( (ifa->ifa_addr == NULL) || !isUsableInterface(ifa->ifa_flags) )
 		continue;
-	    
-	    family = ifa->ifa_addr->sa_family;
-	    if( (strstr(ifa->ifa_name, ETH) != NULL) || (strstr(ifa->ifa_name, WLAN) != NULL) )
+
+	    const int family = ifa->ifa_addr->sa_family;
+	    if( (family != AF_INET) && (family != AF_INET6) )
+		continue;
+
+	    const void *addr = (family == AF_INET) ? (const void*)&((struct sockaddr_in*)ifa->ifa_addr)->sin_addr:
+		                                     (const void*)&((struct sockaddr_in6*)ifa->ifa_addr)->sin6_addr;
+	    if(!isUsableAddr(family, addr))
+		continue;
+	    char ip[LOCAL_IP_STR_LEN] = {'\0'};
+	    if(inet_ntop(family, addr, ip, LOCAL_IP_STR_LEN) != NULL)
+		addLocalAddr(if_nametoindex(ifa->ifa_name), family, ip);
+	}
+    areLocalAddrsLoaded = true;
+    const bool isChanged = (oldAddrsNum != localAddrsNum) ||
+	                   (memcmp(oldAddrs, localAddrs, localAddrsNum * sizeof(struct LocalAddr)) != 0);
+    pthread_mutex_unlock(&mutexLocalAddrs);
+
+    freeifaddrs(ifaddr);
+    return isChanged;
+}
+
+/**
+ * Copy the local IP to the given string.
+ * The first IPv4 address is preferred, the addresses are loaded at the first call
+ * and kept up to date by the addresses monitor
+ * @param str String of LOCAL_IP_STR_LEN length for copying IP to
+ */
+void copyLocalIp2Str(char *str)
+{
+    pthread_mutex_lock(&mutexLocalAddrs);
+    const bool isLoaded = areLocalAddrsLoaded;
+    pthread_mutex_unlock(&mutexLocalAddrs);
+    if(!isLoaded)
+	loadLocalAddrs();
+
+    pthread_mutex_lock(&mutexLocalAddrs);
+    const struct LocalAddr *found = NULL;
+    size_t i;
+    for(i = 0; i < localAddrsNum; i++)
+	{
+	    if( (found == NULL) || ((found->family != AF_INET) && (localAddrs[i].family == AF_INET)) )
+		found = &localAddrs[i];
+	}
+    strcpy(str, (found == NULL) ? UNKNOWN: found->ip);
+    pthread_mutex_unlock(&mutexLocalAddrs);
+}
+
+/**
+ * Open the monitor of the local addresses.
+ * The netlink socket subscribed to the changes of the addresses and of the interfaces is opened and the addresses are reloaded
+ * @return The descriptor of the monitor or ERR
+ */
+const int openAddrsMonitor()
+{
+    const int descr = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if(descr == ERR)
+	{
+	    writeToLog2("ERROR in openAddrsMonitor(): ", strerror(errno), TAG);
+	    return ERR;
+	}
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if(bind(descr, (struct sockaddr*) &addr, sizeof(addr)) == ERR)
+	{
+	    writeToLog2("ERROR in openAddrsMonitor(): ", strerror(errno), TAG);
+	    close(descr);
+	    return ERR;
+	}
+
+    loadLocalAddrs();   // after subscribing, so no change is missed
+    return descr;
+}
+
+/**
+ * Apply the netlink message of the added or removed address to the table of the local addresses.
+ * The added address is kept by the same rules as the loaded ones: it's usable and its interface is usable
+ * @param msg The netlink message
+ * @return true The table has been changed
+ */
+static bool applyAddrMsg(const struct nlmsghdr *msg)
+{
+    const struct ifaddrmsg *ifa = (const struct ifaddrmsg*) NLMSG_DATA(msg);
+    if( (ifa->ifa_family != AF_INET) && (ifa->ifa_family != AF_INET6) )
+	return false;
+
+    const void *addr = NULL;
+    int attrsLen = IFA_PAYLOAD(msg);
+    const struct rtattr *attr;
+    for(attr = IFA_RTA(ifa); RTA_OK(attr, attrsLen); attr = RTA_NEXT(attr, attrsLen))
+	{
+	    if(attr->rta_type == IFA_LOCAL)          // the local address of a point-to-point interface
+		addr = RTA_DATA(attr);
+	    else if( (attr->rta_type == IFA_ADDRESS) && (addr == NULL) )
+		addr = RTA_DATA(attr);
+	}
+    if( (addr == NULL) || !isUsableAddr(ifa->ifa_family, addr) )
+	return false;
+    if( (msg->nlmsg_type == RTM_NEWADDR) && !isUsableInterfaceIndex(ifa->ifa_index) )
+	return false;
+
+    char ip[LOCAL_IP_STR_LEN] = {'\0'};
+    if(inet_ntop(ifa->ifa_family, addr, ip, LOCAL_IP_STR_LEN) == NULL)
+	return false;
+
+    pthread_mutex_lock(&mutexLocalAddrs);
+    const bool isChanged = (msg->nlmsg_type == RTM_NEWADDR) ? addLocalAddr(ifa->ifa_index, ifa->ifa_family, ip):
+	                                                      removeLocalAddr(ifa->ifa_index, ifa->ifa_family, ip);
+    pthread_mutex_unlock(&mutexLocalAddrs);
+
+    if(isChanged)
+	LOG_INFO2((msg->nlmsg_type == RTM_NEWADDR) ? "The local address added: ": "The local address removed: ", ip, TAG);
+    return isChanged;
+}
+
+/**
+ * Handle the messages arrived to the monitor of the local addresses.
+ * Should be called when the monitor's descriptor is ready for reading
+ * @param descr The descriptor of the monitor
+ * @return true The local addresses have been changed
+ */
+bool handleAddrsMonitor(const int descr)
+{
+    bool isChanged = false;
+    char buff[NETLINK_BUFF_LEN] __attribute__((aligned(__alignof__(struct nlmsghdr))));
+    ssize_t len;
+    while( (len = recv(descr, buff, sizeof(buff), 0)) > 0 )
+	{
+	    const struct nlmsghdr *msg;
+	    for(msg = (const struct nlmsghdr*) buff; NLMSG_OK(msg, len); msg = NLMSG_NEXT(msg, len))
 		{
-		    if (family == AF_INET || family == AF_INET6)
-			{
-			    sock_addr_size = (family == AF_INET) ? sizeof(struct sockaddr_in): sizeof(struct sockaddr_in6); 
-			    s = getnameinfo(ifa->ifa_addr, sock_addr_size, host, NI_MAXHOST, NULL, 0, NI_NUMERICHOST);
-			    if (s != NO_ERR)
-				{
-				    writeToLog2("ERROR in copyLocalIp2Str(): ", gai_strerror(s), TAG);
-				    break;
-				}
-			    strcpy(str, host);
-			    freeifaddrs(ifaddr);
-			    return;
-			}
+		    if( (msg->nlmsg_type == RTM_NEWADDR) || (msg->nlmsg_type == RTM_DELADDR) )
+			isChanged |= applyAddrMsg(msg);
+		    else if( (msg->nlmsg_type == RTM_NEWLINK) || (msg->nlmsg_type == RTM_DELLINK) )   // an interface is up or down
+			isChanged |= loadLocalAddrs();
 		}
 	}
-    strcpy(str, UNKNOWN);
-    freeifaddrs(ifaddr);
+
+    if( (len == ERR) && (errno == ENOBUFS) )   // some messages have been lost
+	{
+	    writeToLog("WARNING: The messages of the local addresses' changes are lost, the addresses are reloaded\n", TAG);
+	    loadLocalAddrs();
+	    isChanged = true;
+	}
+    return isChanged;
 }
 
 /**
- * Copy the IP of the connected client to the given string 
+ * Close the monitor of the local addresses. The addresses are kept
+ * @param descr The descriptor of the monitor
+ */
+void closeAddrsMonitor(const int descr)
+{
+    if(descr != ERR)
+	close(descr);
+}
+
+/**
+ * Copy the IP of the connected client to the given string.
+ * The IPv4 client connected to the dual-stack socket is copied as the IPv4 address
  * @param sockDescr Socket descriptor
- * @param str String for copying IP to
+ * @param str String of LOCAL_IP_STR_LEN length for copying IP to
  */
 void copyConnectedIp2Str(const int sockDescr, char *str)
 {
-    struct sockaddr_in name = {0};
+    struct sockaddr_storage name;
+    memset(&name, 0, sizeof(name));
     socklen_t namelen = sizeof(name);
     if(getpeername(sockDescr, (struct sockaddr*) &name, &namelen) == ERR)
 	{
@@ -109,9 +381,21 @@ void copyConnectedIp2Str(const int sockDescr, char *str)
 	    strcpy(str, UNKNOWN);
 	    return;
 	}
-         
-    char buffer[INET_ADDRSTRLEN];
-    const char *ip = inet_ntop(AF_INET, &name.sin_addr, buffer, INET_ADDRSTRLEN);
+
+    int family = name.ss_family;
+    const void *addr = &((struct sockaddr_in*) &name)->sin_addr;
+    if(family == AF_INET6)
+	{
+	    const struct in6_addr *addr6 = &((struct sockaddr_in6*) &name)->sin6_addr;
+	    if(IN6_IS_ADDR_V4MAPPED(addr6))
+		addr = &addr6->s6_addr[12];   // the IPv4 address is the last 4 bytes
+	    else
+		addr = addr6;
+	    family = IN6_IS_ADDR_V4MAPPED(addr6) ? AF_INET: AF_INET6;
+	}
+
+    char buffer[LOCAL_IP_STR_LEN];
+    const char *ip = inet_ntop(family, addr, buffer, LOCAL_IP_STR_LEN);
     if(ip == NULL)
 	{
 	    writeToLog2("ERROR setConnectedIP(): ", strerror(errno), TAG);
@@ -122,3 +406,78 @@ void copyConnectedIp2Str(const int sockDescr, char *str)
     strcpy(str, ip);
 }
 
+
+/**
+ * Is the given address in the subnet of a local interface?
+ * @param family The family of the address: AF_INET or AF_INET6
+ * @param addr The bytes of the address in the network order: 4 for IPv4, 16 for IPv6
+ * @return true The address is in the subnet of a local interface
+ */
+static bool isLocalSubnetAddr(const int family, const unsigned char *addr)
+{
+    struct ifaddrs *ifaddr, *ifa;
+    if (getifaddrs(&ifaddr) == ERR)
+	{
+	    writeToLog2("ERROR in isLocalSubnetAddr(): ", strerror(errno), TAG);
+	    return false;
+	}
+
+    const size_t len = (family == AF_INET) ? sizeof(struct in_addr): sizeof(struct in6_addr);
+    bool isFound = false;
+    for (ifa = ifaddr; (ifa != NULL) && !isFound; ifa = ifa->ifa_next)
+	{
+	    if( (ifa->ifa_addr == NULL) || (ifa->ifa_netmask == NULL) || (ifa->ifa_addr->sa_family != family) ||
+		!(ifa->ifa_flags & IFF_UP) || (ifa->ifa_flags & IFF_LOOPBACK) )
+		continue;
+
+	    const unsigned char *local = (family == AF_INET) ? (const unsigned char*)&((struct sockaddr_in*)ifa->ifa_addr)->sin_addr:
+		                                               (const unsigned char*)&((struct sockaddr_in6*)ifa->ifa_addr)->sin6_addr;
+	    const unsigned char *mask  = (family == AF_INET) ? (const unsigned char*)&((struct sockaddr_in*)ifa->ifa_netmask)->sin_addr:
+		                                               (const unsigned char*)&((struct sockaddr_in6*)ifa->ifa_netmask)->sin6_addr;
+	    size_t i;
+	    for(i = 0; (i < len) && ((addr[i] & mask[i]) == (local[i] & mask[i])); i++);
+	    isFound = (i == len);
+	}
+    freeifaddrs(ifaddr);
+    return isFound;
+}
+
+/**
+ * Is the given address of a host in the LAN: a private(RFC 1918) or a link-local IPv4 address,
+ * a unique local or a link-local IPv6 address, or an address of a local interface's subnet
+ * @param addr The address, the IPv4 address mapped to IPv6 is checked as the IPv4 one
+ * @return true The address is in the LAN
+ */
+bool isLanAddr(const struct sockaddr *addr)
+{
+    const unsigned char *bytes = NULL;
+    int family = addr->sa_family;
+    if(family == AF_INET)
+	bytes = (const unsigned char*)&((const struct sockaddr_in*)addr)->sin_addr;
+    else if(family == AF_INET6)
+	{
+	    const struct in6_addr *addr6 = &((const struct sockaddr_in6*)addr)->sin6_addr;
+	    bytes = addr6->s6_addr;
+	    if(IN6_IS_ADDR_V4MAPPED(addr6))
+		{
+		    family = AF_INET;
+		    bytes += 12;
+		}
+	}
+    else
+	return false;
+
+    if(family == AF_INET)
+	{
+	    if( (bytes[0] == 10) ||                                  // 10.0.0.0/8
+		((bytes[0] == 172) && ((bytes[1] & 0xF0) == 16)) ||  // 172.16.0.0/12
+		((bytes[0] == 192) && (bytes[1] == 168)) ||          // 192.168.0.0/16
+		((bytes[0] == 169) && (bytes[1] == 254)) )           // 169.254.0.0/16, link-local
+		return true;
+	}
+    else if( ((bytes[0] & 0xFE) == 0xFC) ||                          // fc00::/7, unique local
+	     ((bytes[0] == 0xFE) && ((bytes[1] & 0xC0) == 0x80)) )   // fe80::/10, link-local
+	return true;
+
+    return isLocalSubnetAddr(family, bytes);
+}
@@ -29,17 +29,56 @@
 #ifndef IP_OPERATIONS_H
 #define IP_OPERATIONS_H
 
+#include <stdbool.h>
+#include <sys/socket.h>
+
+#define LOCAL_IP_STR_LEN 46                /**< The length of the local IP string, INET6_ADDRSTRLEN */
+
+#define LOCAL_IP_CHANGED "local_ip"        /**< The notification of the changed local IP, followed by the IP */
+
 /**
- * Copy the local IP to the given string
- * @param str String for copying IP to
+ * Copy the local IP to the given string.
+ * The first IPv4 address is preferred, the addresses are loaded at the first call
+ * and kept up to date by the addresses monitor
+ * @param str String of LOCAL_IP_STR_LEN length for copying IP to
  */
 void copyLocalIp2Str    (char *str);
 
 /**
- * Copy the IP of the connected client to the given string 
+ * Open the monitor of the local addresses.
+ * The netlink socket subscribed to the changes of the addresses and of the interfaces is opened and the addresses are reloaded
+ * @return The descriptor of the monitor or ERR
+ */
+const int openAddrsMonitor();
+
+/**
+ * Handle the messages arrived to the monitor of the local addresses.
+ * Should be called when the monitor's descriptor is ready for reading
+ * @param descr The descriptor of the monitor
+ * @return true The local addresses have been changed
+ */
+bool handleAddrsMonitor(const int descr);
+
+/**
+ * Close the monitor of the local addresses. The addresses are kept
+ * @param descr The descriptor of the monitor
+ */
+void closeAddrsMonitor(const int descr);
+
+/**
+ * Copy the IP of the connected client to the given string.
+ * The IPv4 client connected to the dual-stack socket is copied as the IPv4 address
  * @param sockDescr Socket descriptor
- * @param str String for copying IP to
+ * @param str String of LOCAL_IP_STR_LEN length for copying IP to
  */
 void copyConnectedIp2Str(const int sockDescr, char *str);
 
+/**
+ * Is the given address of a host in the LAN: a private(RFC 1918) or a link-local IPv4 address,
+ * a unique local or a link-local IPv6 address, or an address of a local interface's subnet
+ * @param addr The address, the IPv4 address mapped to IPv6 is checked as the IPv4 one
+ * @return true The address is in the LAN
+ */
+bool isLanAddr(const struct sockaddr *addr);
+
 #endif
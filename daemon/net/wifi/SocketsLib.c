@@ -34,7 +34,9 @@
 
 #include "SocketsLib.h"
 #include "synchronise.h"
+#include "frames.h"
 #include "Log.h"
+#include "Trace.h"
 #include "addr.h"
 
 #include <errno.h>
@@ -50,8 +52,14 @@
 #include <sys/types.h>
 #include <netdb.h>
 #include <net/if.h>
+#include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
 
 #include "IpOps.h"
 
@@ -61,17 +69,95 @@
 
 #define TAG "SOCKETS_LIB"                       /**< The tag for writing to the log file */
 
-#define IP_ADDR_STR_LEN 20                      /**< The length of the IP string */
-char connectedIP[IP_ADDR_STR_LEN] = {'\0'};     /**< The buffer for a connected IP addres string */
-char localIP    [IP_ADDR_STR_LEN] = {'\0'};     /**< The buffer for the local IP addres string */
+#define IP_ADDR_STR_LEN 46                      /**< The length of the IP string, INET6_ADDRSTRLEN */
+char connectedIP[IP_ADDR_STR_LEN] = {'\0'};     /**< The IP address string of the last connected client */
+__thread char copiedConnectedIP[IP_ADDR_STR_LEN] = {'\0'};   /**< The copy of the last connected client's IP returned to the calling thread */
+pthread_mutex_t mutexConnectedIPs = PTHREAD_MUTEX_INITIALIZER;   /**< The mutex of the connected IP and of the connections' IDs and IPs read by other threads */
+char localIP    [LOCAL_IP_STR_LEN] = {'\0'};    /**< The buffer for the local IP addres string */
+char notifiedLocalIP[LOCAL_IP_STR_LEN] = {'\0'}; /**< The local IP sent to the clients the last time */
 
 #define PORT_NUM_LEN 10                         /**< The length of the port number string */
 char portNum[PORT_NUM_LEN] = {'\0'};            /**< The buffer for the port number string */
+char volPortNum[PORT_NUM_LEN] = {'\0'};         /**< The buffer for the port number string of the volume's datagrams, "" if they aren't received */
+char discoveryPortNum[PORT_NUM_LEN] = {'\0'};   /**< The buffer for the port number string of the discovery probes, "" if they aren't answered */
 
 
-fd_set master;    // master file descriptor list
-fd_set read_fds;  // temp file descriptor list for select()
-int fdmax;        // maximum file descriptor number
+#define MAX_CONNECTIONS_NUM 16                  /**< The maximal number of simultaneously connected clients */
+#define MAX_EVENTS_NUM (MAX_CONNECTIONS_NUM + 6)  /**< The maximal number of events handled by one wait */
+#define IN_BUFF_LEN (MAX_FRAME_LEN * 2)         /**< The length of the buffer of the received data */
+#define OUT_BUFF_LEN (MAX_FRAME_LEN * 4)        /**< The length of the buffer of replies waiting for sending */
+
+#define LISTENER_EVENT  MAX_CONNECTIONS_NUM       /**< The event data of the listening socket */
+#define SENT_DATA_EVENT (MAX_CONNECTIONS_NUM + 1) /**< The event data of the event of the data for sending */
+#define ADDRS_EVENT     (MAX_CONNECTIONS_NUM + 2) /**< The event data of the monitor of the local addresses */
+#define DATAGRAM_EVENT  (MAX_CONNECTIONS_NUM + 3) /**< The event data of the socket of the volume's datagrams */
+#define DISCOVERY_EVENT (MAX_CONNECTIONS_NUM + 4) /**< The event data of the socket of the discovery probes */
+#define STOP_EVENT      (MAX_CONNECTIONS_NUM + 5) /**< The event data of the event signaled when the status of running is set to STOP */
+
+#define DISCOVERY_REPLY_LEN 256                 /**< The maximal length of the reply to the discovery probe */
+#define DISCOVERY_CAPS "text,frames,batch"      /**< The capabilities of the daemon sent in the reply to the discovery probe */
+
+#define MAX_DATAGRAM_SENDERS_NUM 8              /**< The maximal number of the tracked senders of the datagrams */
+#define DATAGRAM_SENDER_TIMEOUT 10              /**< The seconds after which the sequence of a silent sender is forgotten */
+
+#define MAX_DISCOVERY_SENDERS_NUM 16            /**< The maximal number of the senders of the discovery probes answered in one interval */
+#define DISCOVERY_REPLY_INTERVAL 1              /**< The minimal seconds between the replies to the probes of one address */
+
+/**
+ * \struct Connection
+ * \brief The context of a connected client
+ */
+struct Connection
+{
+    int id;                                 /**< The ID of the connection or NO_CONNECTION if the slot is free */
+    int sockDescr;                          /**< The socket descriptor of the connection */
+    char peerIP[IP_ADDR_STR_LEN];           /**< The IP address string of the client */
+    char inBuff[IN_BUFF_LEN];               /**< The buffer of the received and not yet processed data */
+    size_t inLen;                           /**< The length of the data in the input buffer */
+    bool usesFrames;                        /**< Has the client sent the binary frames */
+    bool isLegacyClient;                    /**< Does the client send the text commands without EOL, until its first EOL or frame */
+    char outBuff[OUT_BUFF_LEN];             /**< The buffer of the replies waiting for sending */
+    size_t outLen;                          /**< The length of the data in the output buffer */
+    bool waitsForWriting;                   /**< Is the socket watched for writing */
+};
+
+struct Connection connections[MAX_CONNECTIONS_NUM];   /**< The table of the connected clients */
+
+/**
+ * \struct DatagramSender
+ * \brief The sender of the volume's datagrams
+ */
+struct DatagramSender
+{
+    struct sockaddr_storage addr;           /**< The address of the sender */
+    socklen_t addrLen;                      /**< The length of the address, 0 if the slot is free */
+    uint32_t lastSeq;                       /**< The sequence number of the last accepted datagram */
+    bool hasSeq;                            /**< Has a datagram of the sender been accepted */
+    time_t lastTime;                        /**< The time of the last accepted datagram */
+    struct VolCommand command;              /**< The command waiting for passing as a received data */
+};
+
+struct DatagramSender datagramSenders[MAX_DATAGRAM_SENDERS_NUM];   /**< The senders of the volume's datagrams */
+
+/**
+ * \struct DiscoverySender
+ * \brief The sender of the discovery probes which has been answered
+ */
+struct DiscoverySender
+{
+    struct sockaddr_storage addr;           /**< The address of the sender without the port */
+    socklen_t addrLen;                      /**< The length of the address, 0 if the slot is free */
+    time_t lastTime;                        /**< The time of the last reply */
+};
+
+struct DiscoverySender discoverySenders[MAX_DISCOVERY_SENDERS_NUM];   /**< The answered senders of the discovery probes */
+
+DiscoveryInfoCallback discoveryInfoCallback = NULL;  /**< The function adding the daemon's info to the reply to the discovery probe */
+void *discoveryInfoContext = NULL;                   /**< The context of the function adding the daemon's info */
+
+int lastConnId = 0;                         /**< The ID of the last accepted connection */
+
+int epollDescr = ERR;                       /**< The descriptor of the epoll instance */
 
 /*
 void writeToLog2(const char* txt1, const char* txt2)
@@ -98,21 +184,53 @@ const char* getErrStr()
 }
 
 /**
- * Get local IP
- * @return The string of the local IP or ""
+ * Get local IP. The IP is got from the kept local addresses, so it's up to date after a network change
+ * @return The string of the local IP or "UNKNOWN"
  */
 const char* getLocalAddr()
 {
+    copyLocalIp2Str(localIP);
     return localIP;
 }
 
 /**
- * Get connected IP
+ * Get the IP of the last connected client.
+ * The string is copied for the calling thread, so it isn't changed by the next connections
  * @return The string of the connected IP or ""
  */
 const char* getConnectedAddr()
 {
-    return connectedIP;
+    pthread_mutex_lock(&mutexConnectedIPs);
+    strcpy(copiedConnectedIP, connectedIP);
+    pthread_mutex_unlock(&mutexConnectedIPs);
+    return copiedConnectedIP;
+}
+
+/**
+ * Copy the IP of the client of the given connection
+ * @param connId The ID of the connection
+ * @param ip The buffer for the IP string
+ * @param len The length of the buffer
+ * @return false There is no connection with the given ID
+ */
+bool copyConnectionAddr(const int connId, char *ip, const size_t len)
+{
+    if( (connId == NO_CONNECTION) || (len == 0) )
+	return false;
+
+    bool isFound = false;
+    pthread_mutex_lock(&mutexConnectedIPs);
+    int i;
+    for(i = 0; (i < MAX_CONNECTIONS_NUM) && !isFound; ++i)
+	{
+	    if(connections[i].id != connId)
+		continue;
+	    strncpy(ip, connections[i].peerIP, len - 1);
+	    ip[len - 1] = '\0';
+	    isFound = true;
+	}
+    pthread_mutex_unlock(&mutexConnectedIPs);
+    return isFound;
 }
 
 /**
@@ -154,6 +272,60 @@ const int setPort(const char* port)
     return NO_ERR;
 }
 
+/**
+ * Copy the given port number of the datagrams to the given buffer
+ * @param buff The buffer of PORT_NUM_LEN length
+ * @param port The port number string, NULL or "" if the datagrams shouldn't be received
+ * @return ERR or NO_ERR
+ */
+static const int copyDatagramPort(char *buff, const char* port)
+{
+    if( (port == NULL) || (port[0] == '\0') )
+	{
+	    bzero(buff, PORT_NUM_LEN);
+	    return NO_ERR;
+	}
+    if(strlen(port) >= PORT_NUM_LEN)
+	{
+	    writeToLog2("ERROR: the given port number of the datagrams is too long: ", port, TAG);
+	    return ERR;
+	}
+    strcpy(buff, port);
+    return NO_ERR;
+}
+
+/**
+ * Set the port number of the volume's datagrams
+ * @param port The port number string, NULL or "" if the datagrams shouldn't be received
+ * @return ERR or NO_ERR
+ */
+const int setVolPort(const char* port)
+{
+    return copyDatagramPort(volPortNum, port);
+}
+
+/**
+ * Set the UDP port number of the discovery probes
+ * @param port The port number string, NULL or "" if the probes shouldn't be answered
+ * @return ERR or NO_ERR
+ */
+const int setDiscoveryPort(const char* port)
+{
+    return copyDatagramPort(discoveryPortNum, port);
+}
+
+/**
+ * Set the function adding the daemon's info to the reply to the discovery probe.
+ * Should be called before running the connection
+ * @param callback The function or NULL
+ * @param context The context which the function should be called with
+ */
+void setDiscoveryInfoCallback(DiscoveryInfoCallback callback, void *context)
+{
+    discoveryInfoCallback = callback;
+    discoveryInfoContext  = context;
+}
+
 /**
  * Get the currently used port
  * @return the string of the currently used port number
@@ -197,20 +369,22 @@ bool isStrNum(const char *str)
  * Fill the structures of a host info
  * @param host_info The host info structure, which should be filled up
  * @param host_info_list The list of the host info structs
+ * @param port The port number string
+ * @param sockType SOCK_STREAM or SOCK_DGRAM
  * @return The result: ERR or NO_ERR
  */
-const int fillHostInfoStructs(struct addrinfo *host_info, struct addrinfo **host_info_list)
+const int fillHostInfoStructs(struct addrinfo *host_info, struct addrinfo **host_info_list, const char *port, const int sockType)
 {
     writeToLog("Setting up the structs...\n", TAG);
 
     host_info->ai_family   = AF_UNSPEC;     // IP version not specified. Can be both.
-    host_info->ai_socktype = SOCK_STREAM;   // Use SOCK_STREAM for TCP or SOCK_DGRAM for UDP.
+    host_info->ai_socktype = sockType;      // Use SOCK_STREAM for TCP or SOCK_DGRAM for UDP.
     host_info->ai_flags    = AI_PASSIVE;    // IP Wildcard
 
-    if(!isStrNum(portNum))
+    if(!isStrNum(port))
 	return ERR;
 	
-    const int status = getaddrinfo(NULL, portNum, host_info, host_info_list);
+    const int status = getaddrinfo(NULL, port, host_info, host_info_list);
 
     if (status != NO_ERR)
 	writeToLog2("\tERROR fillHostInfoStructs(): ", gai_strerror(status), TAG);
@@ -219,8 +393,8 @@ const int fillHostInfoStructs(struct addrinfo *host_info, struct addrinfo **host
 }
 
 /**
- * Create socket from the given list of the host info structs
- * @param host_info_list The list of the host info structs
+ * Create socket by the given host info struct
+ * @param host_info_list The host info struct
  * @return The socket descriptor
  */
 const int createSocket(struct addrinfo *host_info_list)
@@ -235,8 +409,9 @@ const int createSocket(struct addrinfo *host_info_list)
 }
 
 /**
- * Bind the socket with the given descriptor
- * @param host_info_list The list of the host info structs
+ * Bind the socket with the given descriptor.
+ * The IPv6 socket accepts the IPv4 connections too
+ * @param host_info_list The host info struct
  * @param sockDescr The socket descriptor
  * @return The status of binding
  */
@@ -252,6 +427,17 @@ const int bindSocket(const int sockDescr, struct addrinfo *host_info_list)
 	    return status;
 	}
 
+    if(host_info_list->ai_family == AF_INET6)
+	{
+	    int no = 0;
+	    status = setsockopt(sockDescr, IPPROTO_IPV6, IPV6_V6ONLY, &no, sizeof(int));
+	    if (status == ERR)
+		{
+		    writeToLog2("\tERROR bindSocket(): ", strerror(errno), TAG);
+		    return status;
+		}
+	}
+
     //    struct timeval timeout;      
     //    timeout.tv_sec = SOCKET_TIME_OUT;
     //    timeout.tv_usec = 0;
@@ -281,224 +467,703 @@ const int listenConns(const int sockDescr)
     const int status =  listen(sockDescr, MAX_SOCKETS_NUM_WAITED_FOR_ACCEPT);
     writeToLogIfError(status, "listenConns(): ", strerror(errno), TAG);
 
-   // add the listener to the master set
-    FD_SET(sockDescr, &master);
+    return status;
+}
+
+/**
+ * Make the given socket non-blocking
+ * @param sockDescr A socket's descriptor
+ * @return ERR or NO_ERR
+ */
+static const int setNonBlocking(const int sockDescr)
+{
+    const int flags = fcntl(sockDescr, F_GETFL, 0);
+    if( (flags == ERR) || (fcntl(sockDescr, F_SETFL, flags | O_NONBLOCK) == ERR) )
+	{
+	    writeToLog2("\tERROR setNonBlocking(): ", strerror(errno), TAG);
+	    return ERR;
+	}
+    return NO_ERR;
+}
 
-    // keep track of the biggest file descriptor
-    fdmax = sockDescr; // so far, it's this one
+/**
+ * Add the given descriptor to the epoll instance
+ * @param descr The descriptor
+ * @param events The watched events
+ * @param data The data identifying the descriptor in the arrived events
+ * @return ERR or NO_ERR
+ */
+static const int watchDescr(const int descr, const uint32_t events, const uint32_t data)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = events;
+    event.data.u32 = data;
 
+    const int status = epoll_ctl(epollDescr, EPOLL_CTL_ADD, descr, &event);
+    writeToLogIfError(status, "watchDescr(): ", strerror(errno), TAG);
     return status;
 }
 
+/**
+ * Find the connection with the given ID
+ * @param connId The ID of the connection
+ * @return The connection or NULL if there is no such one
+ */
+static struct Connection* findConnection(const int connId)
+{
+    int i;
+    for(i = 0; i < MAX_CONNECTIONS_NUM; ++i)
+	{
+	    if(connections[i].id == connId)
+		return &connections[i];
+	}
+    return NULL;
+}
+
+/**
+ * Close the socket connection
+ * @param sockDescr The socket descriptor of the connection
+ * @return The result integer of closing
+ */
+const int closeSocketConn(const int sockDescr)
+{
+    if(sockDescr <= 0)
+	return ERR;
+	
+    LOG_INFO("\tClosing socket connection\n", TAG);
+
+    const int res = close(sockDescr);
+    if(res == ERR)
+	writeToLog2("\tERROR closeSocketConn(): ", strerror(errno), TAG);
+
+    return res;
+}
+
+/**
+ * Close the given client's connection and free its slot
+ * @param conn The connection
+ */
+static void closeClientConn(struct Connection *conn)
+{
+    if(conn->id == NO_CONNECTION)
+	return;
+    closeSocketConn(conn->sockDescr);   // closing removes the descriptor from the epoll instance
+    pthread_mutex_lock(&mutexConnectedIPs);
+    conn->id        = NO_CONNECTION;
+    pthread_mutex_unlock(&mutexConnectedIPs);
+    conn->sockDescr = ERR;
+}
+
 /**
  * Accept a connection
  * @param sockDescr A socket's descriptor
- * @return ERR if there is an error. Any other number if there is no error
  */
-const int acceptConn(const int sockDescr)
+void acceptConn(const int sockDescr)
 {
     struct sockaddr_storage their_addr;
     
     socklen_t addr_size = sizeof(their_addr);
     const int newSockDescr = accept(sockDescr, (struct sockaddr *)&their_addr, &addr_size);
+    if(newSockDescr == ERR)
+	{
+	    if( (errno != EAGAIN) && (errno != EWOULDBLOCK) )
+		writeToLog2("acceptConn(): ", strerror(errno), TAG);
+	    return;
+	}
 
-    writeToLogIfError(newSockDescr, "acceptConn(): ", strerror(errno), TAG);
-    
-    return newSockDescr;
+    struct Connection *conn = findConnection(NO_CONNECTION);
+    if(conn == NULL)
+	{
+	    writeToLog("\tERROR acceptConn(): Too many connected clients. The connection is refused\n", TAG);
+	    closeSocketConn(newSockDescr);
+	    return;
+	}
+
+    const int slot = conn - connections;
+    if( (setNonBlocking(newSockDescr) == ERR) || (watchDescr(newSockDescr, EPOLLIN, slot) == ERR) )
+	{
+	    closeSocketConn(newSockDescr);
+	    return;
+	}
+
+    char peerIP[IP_ADDR_STR_LEN] = {'\0'};
+    copyConnectedIp2Str(newSockDescr, peerIP);
+
+    lastConnId = (lastConnId == INT_MAX) ? 1: lastConnId + 1;
+    conn->sockDescr       = newSockDescr;
+    conn->inLen           = 0;
+    conn->outLen          = 0;
+    conn->waitsForWriting = false;
+    conn->usesFrames      = false;
+    conn->isLegacyClient  = true;
+
+    pthread_mutex_lock(&mutexConnectedIPs);
+    conn->id = lastConnId;
+    strcpy(conn->peerIP, peerIP);
+    strcpy(connectedIP, peerIP);
+    pthread_mutex_unlock(&mutexConnectedIPs);
+
+    LOG_INFO2("\tAccepted connection from ", conn->peerIP, TAG);
 }
 
 /**
- * Receive a data from a client
- * @param newSockDescr A socket's descriptor
- * @param incoming_data_buffer The buffer for incoming data
- * @param buff_len The length of the buffer
- * @return The buffer of the incoming data or NULL if there is an error
+ * Watch or stop watching the connection's socket for writing
+ * @param conn The connection
+ * @param watch Should the socket be watched for writing
  */
-const char* receiveData(const int newSockDescr, char* incoming_data_buffer, const size_t buff_len)
+static void watchForWriting(struct Connection *conn, const bool watch)
 {
-    if(incoming_data_buffer == NULL)
-      {
-	  writeToLog("ERROR receiveData(): The given pointer to buffer for incoming data is NULL\n", TAG);
-	  return NULL;
-      }
-    if(buff_len == 0)
-      {
-	  writeToLog("ERROR receiveData(): The length of the given buffer is 0\n", TAG);
-	return NULL;
-      }
+    if(conn->waitsForWriting == watch)
+	return;
 
-    if(buff_len != 0)
-	bzero(incoming_data_buffer, buff_len);
-    
-    writeToLog("Waiting to receive data...\n", TAG);
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = watch ? (EPOLLIN | EPOLLOUT): EPOLLIN;
+    event.data.u32 = conn - connections;
+    if(epoll_ctl(epollDescr, EPOLL_CTL_MOD, conn->sockDescr, &event) == ERR)
+	{
+	    writeToLog2("\tERROR watchForWriting(): ", strerror(errno), TAG);
+	    return;
+	}
+    conn->waitsForWriting = watch;
+}
 
-    ssize_t bytes_recieved = recv(newSockDescr, incoming_data_buffer, buff_len, 0);
-    
-    if (bytes_recieved == 0)
+/**
+ * Send the replies waiting in the output buffer of the connection.
+ * If the socket can't take all of them, the rest is sent when the socket becomes writable
+ * @param conn The connection
+ * @return ERR or NO_ERR
+ */
+const int sendData(struct Connection *conn)
+{
+    const ssize_t bytes_sent = send(conn->sockDescr, conn->outBuff, conn->outLen, MSG_NOSIGNAL);
+    if(bytes_sent == ERR)
 	{
-	    writeToLog("\tHost shut down.\n", TAG);
-	    return STR_END;
+	    if( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+		{
+		    watchForWriting(conn, true);
+		    return NO_ERR;
+		}
+	    writeToLog2("\tERROR sendData(): ", strerror(errno), TAG);
+	    return ERR;
 	}
-    if (bytes_recieved == ERR) 
-      {
-	  writeToLog2("\tERROR receiveData(): ", strerror(errno), TAG);
-	  return NULL;
-      }
-    
-    incoming_data_buffer[bytes_recieved - 2] = '\0';    // remove EOL
 
-    return incoming_data_buffer;
+    conn->outLen -= bytes_sent;
+    memmove(conn->outBuff, conn->outBuff + bytes_sent, conn->outLen);
+    watchForWriting(conn, conn->outLen != 0);
+
+    return NO_ERR;
+}   
+
+/**
+ * Put the given data into the output buffer of the connection and send it
+ * @param conn The connection
+ * @param data The data
+ * @param len The length of the data
+ */
+static void sendConnData(struct Connection *conn, const char *data, const size_t len)
+{
+    if(conn->outLen + len > OUT_BUFF_LEN)
+	{
+	    writeToLog("\tERROR sendConnData(): The client doesn't read the answers. The connection is closed\n", TAG);
+	    closeClientConn(conn);
+	    return;
+	}
+    memcpy(conn->outBuff + conn->outLen, data, len);
+    conn->outLen += len;
+
+    if(!conn->waitsForWriting && (sendData(conn) == ERR))
+	closeClientConn(conn);
 }
 
 /**
- * Send data by sockets.
- * @param socketDescr The socket descriptor
- * @return ERR or NO_ERR
+ * Send the given reply or notification to the connection by the protocol the connection uses.
+ * The reply to a request of the binary protocol is sent as a frame, a notification is sent as
+ * a frame if the client has sent frames before
+ * @param conn The connection
+ * @param reqId The ID of the request the data is the reply to or NO_REQUEST
+ * @param data The string of the data
  */
-const int sendData(const int socketDescr)
+static void sendConnMessage(struct Connection *conn, const int reqId, const char *data)
 {
-    char* sentData = getSentData();
-    writeToLog2("Sending the answer: ", sentData, TAG);
+    if( (reqId == NO_REQUEST) && !conn->usesFrames )
+	{
+	    sendConnData(conn, data, strlen(data));
+	    return;
+	}
+
+    char frame[MAX_FRAME_LEN];
+    const size_t len = (reqId == NO_REQUEST) ? buildNotificationFrame(frame, MAX_FRAME_LEN, data):
+                                               buildReplyFrame(frame, MAX_FRAME_LEN, reqId, data);
+    if(len == 0)
+	{
+	    writeToLog2("\tERROR sendConnMessage(): Can't build the frame of the data: ", data, TAG);
+	    return;
+	}
+    sendConnData(conn, frame, len);
+}
 
-    const size_t sentDataLen = strlen(sentData);
-    const ssize_t bytes_sent = send(socketDescr, sentData, sentDataLen, 0);
+/**
+ * Move the data set for sending into the output buffers of their connections
+ */
+static void sendWaitingData()
+{
+    char data[DATA_LEN] = {'\0'};
+    int connId = NO_CONNECTION;
+    int reqId  = NO_REQUEST;
+    while(getSentData(&connId, &reqId, data))
+	{
+	    if(connId == ALL_CONNECTIONS)
+		{
+		    LOG_DEBUG2("Sending the notification: ", data, TAG);
+		    int i;
+		    for(i = 0; i < MAX_CONNECTIONS_NUM; ++i)
+			{
+			    if(connections[i].id != NO_CONNECTION)
+				sendConnMessage(&connections[i], NO_REQUEST, data);
+			}
+		    continue;
+		}
 
-    bzero(sentData, sentDataLen);
+	    if(connId == DATAGRAM_CONNECTION)
+		continue;
 
-     if(bytes_sent == ERR)
+	    struct Connection *conn = findConnection(connId);
+	    if( (connId == NO_CONNECTION) || (conn == NULL) )
+		{
+		    LOG_WARN2("WARNING: The client has disconnected, the answer is dropped: ", data, TAG);
+		    continue;
+		}
+
+	    LOG_DEBUG2("Sending the answer: ", data, TAG);
+	    const uint64_t start = TRACE_START();
+	    sendConnMessage(conn, reqId, data);
+	    traceSpan("net:send", connId, reqId, start);
+	}
+}
+
+/**
+ * Receive a data from the client and pass every complete message of it as a received data.
+ * The messages are text lines or binary frames, a packet may contain many of them or a part of one.
+ * The legacy client sends a text command by a packet without EOL, then its packet is a message.
+ * An invalid message is skipped, the invalid frame is answered by INVALID_MESSAGE_REPLY
+ * @param conn The connection of the client
+ * @return ERR(e.g. the data can't be split into messages), NO_ERR or STOP if the client has closed the connection
+ */
+const int receiveData(struct Connection *conn)
+{
+    const uint64_t start = TRACE_START();
+    const ssize_t bytes_recieved = recv(conn->sockDescr, conn->inBuff + conn->inLen, IN_BUFF_LEN - conn->inLen, 0);
+    if (bytes_recieved == 0)
 	{
-	    writeToLog2("\tERROR sendData(): ", strerror(errno), TAG);
+	    LOG_INFO("\tHost shut down.\n", TAG);
+	    return STOP;
+	}
+    if (bytes_recieved == ERR) 
+	{
+	    if( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+		return NO_ERR;
+	    writeToLog2("\tERROR receiveData(): ", strerror(errno), TAG);
 	    return ERR;
 	}
+    conn->inLen += bytes_recieved;
+
+    char command[DATA_LEN] = {'\0'};
+    int reqId = NO_REQUEST;
+    bool isValid = true;
+    size_t pos = 0;
+    int len = 0;
+    while( (len = parseMessage(conn->inBuff + pos, conn->inLen - pos, conn->isLegacyClient, command, &reqId, &isValid)) > 0 )
+	{
+	    pos += len;
+	    if( (reqId != NO_REQUEST) || (conn->inBuff[pos - 1] == '\n') )
+		conn->isLegacyClient = false;
+	    if(!isValid)
+		{
+		    writeToLog("\tERROR receiveData(): The received message is invalid, it's skipped\n", TAG);
+		    if(reqId != NO_REQUEST)
+			sendConnMessage(conn, reqId, INVALID_MESSAGE_REPLY);
+		    if(conn->id == NO_CONNECTION)
+			return ERR;
+		    continue;
+		}
+	    if(reqId != NO_REQUEST)
+		conn->usesFrames = true;
+	    else if(strcmp(command, STR_END) == 0)
+		return STOP;
 
-    if(bytes_sent != sentDataLen)
+	    if(strlen(command) != 0)
+		{
+		    LOG_DEBUG2("\tReceived string: ", command, TAG);
+		    traceSpan("net:recv", conn->id, reqId, start);
+		    setReceivedData(conn->id, reqId, command);
+		}
+	}
+
+    if(len == INVALID_MESSAGE)
 	{
-	    writeToLog("\tERROR sendData(): The data hasn't sent successfully. The size of the sent data doesn't equal the actual data's size\n", TAG);
+	    writeToLog("\tERROR receiveData(): The received data can't be split into messages, the connection is closed\n", TAG);
 	    return ERR;
 	}
 
+    conn->inLen -= pos;
+    memmove(conn->inBuff, conn->inBuff + pos, conn->inLen);
     return NO_ERR;
-}   
+}
 
 /**
- * Close the socket connection
- * @param sockDescr The socket descriptor of the connection
- * @return The result integer of closing
+ * Create and bind the socket by the first host info struct of the given family which can be bound
+ * @param host_info_list The list of the host info structs
+ * @param family The family of the socket: AF_INET6 or AF_INET
+ * @return socket descriptor or ERR
  */
-const int closeSocketConn(const int sockDescr)
+static const int bindSocketOfFamily(struct addrinfo *host_info_list, const int family)
 {
-    if(sockDescr <= 0)
+    struct addrinfo *info;
+    for(info = host_info_list; info != NULL; info = info->ai_next)
+	{
+	    if(info->ai_family != family)
+		continue;
+
+	    const int sockDescr = createSocket(info);
+	    if(sockDescr == ERR)
+		continue;
+	    if(bindSocket(sockDescr, info) != ERR)
+		return sockDescr;
+	    closeSocketConn(sockDescr);
+	}
+    return ERR;
+}
+
+/**
+ * Initial connection before listening.
+ * The dual-stack IPv6 socket is bound, so the clients of both IPv4 and IPv6 networks are served.
+ * The IPv4 socket is bound if the IPv6 one can't be.
+ * Should be called before the connection's thread starts, the data rings are emptied
+ * @return socket descriptor or ERR
+ */
+const int initConnectionBeforeListen()
+{
+    struct addrinfo host_info;              // The struct that getaddrinfo() fills up with data.
+    struct addrinfo *host_info_list = NULL; // Pointer to the to the linked list of host_info's.
+    memset(&host_info, 0, sizeof host_info);
+
+    initSynchronisation();
+    if(fillHostInfoStructs(&host_info, &host_info_list, portNum, SOCK_STREAM) != NO_ERR)
 	return ERR;
-	
-    writeToLog("\tClosing socket connection\n", TAG);
 
-    const int res = close(sockDescr);
-    if(res == ERR)
-	writeToLog2("\tERROR closeSocketConn(): ", strerror(errno), TAG);
+    int sockDescr = bindSocketOfFamily(host_info_list, AF_INET6);
+    if(sockDescr == ERR)
+	{
+	    LOG_WARN("\tWARNING: Can't bind the IPv6 socket, only the IPv4 clients will be served\n", TAG);
+	    sockDescr = bindSocketOfFamily(host_info_list, AF_INET);
+	}
 
-    FD_CLR(sockDescr, &master);
-    
-    return res;
+    freeaddrinfo(host_info_list);
+    return sockDescr;
 }
 
 /**
- * Initial connection before listening
+ * Initialize the non-blocking dual-stack UDP socket bound to the given port
+ * @param port The port number string
  * @return socket descriptor or ERR
  */
-const int initConnectionBeforeListen()
+static const int initDatagramSocket(const char *port)
 {
-    struct addrinfo host_info;       // The struct that getaddrinfo() fills up with data.
-    struct addrinfo *host_info_list; // Pointer to the to the linked list of host_info's.
+    struct addrinfo host_info;
+    struct addrinfo *host_info_list = NULL;
     memset(&host_info, 0, sizeof host_info);
 
-    FD_ZERO(&master);    // clear the master and temp sets
-    FD_ZERO(&read_fds);
-    
-    int sockDescr = ERR;
-    if(fillHostInfoStructs(&host_info, &host_info_list) != ERR)
+    if(fillHostInfoStructs(&host_info, &host_info_list, port, SOCK_DGRAM) != NO_ERR)
+	return ERR;
+
+    int sockDescr = bindSocketOfFamily(host_info_list, AF_INET6);
+    if(sockDescr == ERR)
+	sockDescr = bindSocketOfFamily(host_info_list, AF_INET);
+    freeaddrinfo(host_info_list);
+
+    if( (sockDescr != ERR) && (setNonBlocking(sockDescr) == ERR) )
 	{
-	    sockDescr = createSocket(host_info_list);
-	    if(sockDescr != ERR)
-		{
-		    if (bindSocket(sockDescr, host_info_list) != ERR)
-		    {
-			    bzero(localIP, IP_ADDR_STR_LEN);
-			    copyLocalIp2Str(localIP);
-		    }
-		    else
-		    {
-		    	closeSocketConn(sockDescr);
-		    	sockDescr = ERR;
-		    }
-		}
+	    closeSocketConn(sockDescr);
+	    return ERR;
 	}
+    return sockDescr;
+}
 
-    freeaddrinfo(host_info_list);
+/**
+ * Initialize the socket of the volume's datagrams, if their port is set
+ * @return socket descriptor or ERR
+ */
+static const int initVolDatagramSocket()
+{
+    if(volPortNum[0] == '\0')
+	return ERR;
+
+    const int sockDescr = initDatagramSocket(volPortNum);
+    if(sockDescr == ERR)
+	return ERR;
+
+    memset(datagramSenders, 0, sizeof(datagramSenders));
+    LOG_INFO2("\tReceiving the volume's datagrams on the port ", volPortNum, TAG);
     return sockDescr;
 }
 
 /**
- * Client-server conversation
- * @param incoming_data_buffer The string buffer for the incoming from the client data
- * @param buff_len The length of the buffer
- * @param listenSocketDescr The descriptor of the listening socket
- * @param curSocketDescr Currently used socket descriptor 
- * @return The integer status of the conversation: ERR, NO_ERR or STOP if received the connection
- *                                                                     end message
+ * Initialize the socket of the discovery probes, if their port is set
+ * @return socket descriptor or ERR
  */
-const int conversation(char *incoming_data_buffer, const size_t buff_len, const int listenSocketDescr, const int curSocketDescr)
+static const int initDiscoverySocket()
 {
-    if(incoming_data_buffer == NULL)
-      {
-	  FD_CLR(curSocketDescr, &master);
-	  writeToLog("ERROR conversation(): The given pointer to buffer for incoming data is NULL\n", TAG);
-	  return ERR;
-      }
-    if(buff_len == 0)
-      {
-	  FD_CLR(curSocketDescr, &master);
-	  writeToLog("ERROR conversation(): The length of the given buffer is 0\n", TAG);
-	  return ERR;
-      }
+    if(discoveryPortNum[0] == '\0')
+	return ERR;
 
-    const char* str = receiveData(curSocketDescr, incoming_data_buffer, buff_len);
-    if(str == NULL)
+    const int sockDescr = initDatagramSocket(discoveryPortNum);
+    if(sockDescr == ERR)
 	{
-	    FD_CLR(curSocketDescr, &master);
-	    writeToLog2(__func__, "ERROR: The received string is NULL\n", TAG);
+	    writeToLog2("\tWARNING: The discovery probes won't be answered: ", strerror(errno), TAG);
 	    return ERR;
 	}
-    if(strcmp(str, STR_END) == 0)
+
+    memset(discoverySenders, 0, sizeof(discoverySenders));
+    LOG_INFO2("\tAnswering the discovery probes on the port ", discoveryPortNum, TAG);
+    return sockDescr;
+}
+
+/**
+ * Find the sender of the datagram, the sender is added if it's new.
+ * The sender silent for a long time is replaced, so its sequence can start again
+ * @param addr The address of the sender
+ * @param addrLen The length of the address
+ * @param now The current time
+ * @return The sender or NULL if there are too many senders
+ */
+static struct DatagramSender* findDatagramSender(const struct sockaddr_storage *addr, const socklen_t addrLen, const time_t now)
+{
+    struct DatagramSender *freeSender = NULL;
+    int i;
+    for(i = 0; i < MAX_DATAGRAM_SENDERS_NUM; ++i)
+	{
+	    struct DatagramSender *sender = &datagramSenders[i];
+	    const bool isExpired = (sender->addrLen == 0) || ((now - sender->lastTime) > DATAGRAM_SENDER_TIMEOUT);
+	    if(!isExpired && (sender->addrLen == addrLen) && (memcmp(&sender->addr, addr, addrLen) == 0))
+		return sender;
+	    if(isExpired && !sender->command.isWaiting && (freeSender == NULL))
+		freeSender = sender;
+	}
+    if(freeSender != NULL)
 	{
-	    FD_CLR(curSocketDescr, &master);
-	    writeToLog2(__func__, ": The received string is EMPTY\n", TAG);
-	    return STOP;
+	    memset(freeSender, 0, sizeof(struct DatagramSender));
+	    memcpy(&freeSender->addr, addr, addrLen);
+	    freeSender->addrLen  = addrLen;
+	    freeSender->lastTime = now;
 	}
+    return freeSender;
+}
 
-    writeToLog2("\tReceived string: ", incoming_data_buffer, TAG);
- 
-    setReceivedData(incoming_data_buffer);
-    setReceivedDataStatus(HAS_NEW_DATA);
+/**
+ * Receive all the arrived volume's datagrams and pass the command of every sender as a received data:
+ * its latest set volume changed by the sum of the following volume's changes.
+ * The datagrams with the sequence numbers not greater than the last accepted one are dropped
+ * @param sockDescr The socket descriptor of the datagrams
+ */
+static void receiveVolDatagrams(const int sockDescr)
+{
+    const time_t now = time(NULL);
+    char data[MAX_DATAGRAM_LEN];
+    struct sockaddr_storage addr;
+    socklen_t addrLen = sizeof(addr);
+    ssize_t len;
+    while( (len = recvfrom(sockDescr, data, sizeof(data), 0, (struct sockaddr*) &addr, &addrLen)) != ERR )
+	{
+	    uint32_t seq = 0;
+	    bool isSetVol = false;
+	    int value = 0;
+	    struct DatagramSender *sender = NULL;
+	    if(!parseVolDatagram(data, len, &seq, &isSetVol, &value))
+		LOG_WARN("\tWARNING receiveVolDatagrams(): The received datagram is invalid\n", TAG);
+	    else if( (sender = findDatagramSender(&addr, addrLen, now)) == NULL )
+		LOG_WARN("\tWARNING receiveVolDatagrams(): Too many senders of the datagrams, the datagram is dropped\n", TAG);
+	    else if(sender->hasSeq && ((int32_t)(seq - sender->lastSeq) <= 0))
+		LOG_TRACE("\tThe stale datagram is dropped\n", TAG);
+	    else
+		{
+		    sender->lastSeq  = seq;
+		    sender->hasSeq   = true;
+		    sender->lastTime = now;
+		    addVolCommand(&sender->command, isSetVol, value);
+		}
+	    addrLen = sizeof(addr);
+	}
+    if( (errno != EAGAIN) && (errno != EWOULDBLOCK) )
+	writeToLog2("\tERROR receiveVolDatagrams(): ", strerror(errno), TAG);
 
-    while(strlen(getSentData()) == 0);   // waiting for the input of the data for sending
+    int i;
+    for(i = 0; i < MAX_DATAGRAM_SENDERS_NUM; ++i)
+	{
+	    char command[DATA_LEN] = {'\0'};
+	    if(takeVolCommand(&datagramSenders[i].command, command))
+		{
+		    LOG_DEBUG2("\tReceived datagram: ", command, TAG);
+		    setReceivedData(DATAGRAM_CONNECTION, NO_REQUEST, command);
+		}
+	}
+}
 
-    int result = ERR;
-    int j;
-    for(j = 0; j <= fdmax; ++j)
+/**
+ * Build the reply to the discovery probe
+ * @param reply The buffer of DISCOVERY_REPLY_LEN length for the reply
+ */
+static void buildDiscoveryReply(char *reply)
+{
+    char host[HOST_NAME_MAX + 1] = {'\0'};
+    if(gethostname(host, sizeof(host) - 1) == ERR)
+	strcpy(host, "UNKNOWN");
+
+    int len = snprintf(reply, DISCOVERY_REPLY_LEN, "%s host=%s port=%s", DISCOVERY_REPLY, host, portNum);
+    if( (len < DISCOVERY_REPLY_LEN) && (volPortNum[0] != '\0') )
+	len += snprintf(reply + len, DISCOVERY_REPLY_LEN - len, " vol_port=%s caps=%s,udp_vol", volPortNum, DISCOVERY_CAPS);
+    else if(len < DISCOVERY_REPLY_LEN)
+	len += snprintf(reply + len, DISCOVERY_REPLY_LEN - len, " caps=%s", DISCOVERY_CAPS);
+
+    if( (len < DISCOVERY_REPLY_LEN - 1) && (discoveryInfoCallback != NULL) )
+	{
+	    char info[DISCOVERY_REPLY_LEN] = {'\0'};
+	    discoveryInfoCallback(info, DISCOVERY_REPLY_LEN - len - 1, discoveryInfoContext);
+	    if(info[0] != '\0')
+		len += snprintf(reply + len, DISCOVERY_REPLY_LEN - len, " %s", info);
+	}
+    if(len < DISCOVERY_REPLY_LEN - 1)
+	strcat(reply, "\n");
+}
+
+/**
+ * Should the discovery probe of the given sender be answered?
+ * The sender should be in the LAN and shouldn't have been answered during the last DISCOVERY_REPLY_INTERVAL.
+ * At most MAX_DISCOVERY_SENDERS_NUM senders are answered during the interval, the answered sender is recorded
+ * @param addr The address of the sender
+ * @param addrLen The length of the address
+ * @param now The current time
+ * @return true The probe should be answered
+ */
+static bool shouldAnswerDiscoverySender(const struct sockaddr_storage *addr, const socklen_t addrLen, const time_t now)
+{
+    struct sockaddr_storage key;
+    memset(&key, 0, sizeof(key));
+    memcpy(&key, addr, addrLen);
+    if(key.ss_family == AF_INET)
+	((struct sockaddr_in*) &key)->sin_port = 0;
+    else if(key.ss_family == AF_INET6)
+	((struct sockaddr_in6*) &key)->sin6_port = 0;
+
+    struct DiscoverySender *freeSender = NULL;
+    int i;
+    for(i = 0; i < MAX_DISCOVERY_SENDERS_NUM; ++i)
+	{
+	    struct DiscoverySender *sender = &discoverySenders[i];
+	    const bool isExpired = (sender->addrLen == 0) || ((now - sender->lastTime) >= DISCOVERY_REPLY_INTERVAL);
+	    if(!isExpired && (sender->addrLen == addrLen) && (memcmp(&sender->addr, &key, addrLen) == 0))
+		return false;
+	    if(isExpired && (freeSender == NULL))
+		freeSender = sender;
+	}
+    if( (freeSender == NULL) || !isLanAddr((const struct sockaddr*) addr) )
+	return false;
+
+    memcpy(&freeSender->addr, &key, sizeof(key));
+    freeSender->addrLen  = addrLen;
+    freeSender->lastTime = now;
+    return true;
+}
+
+/**
+ * Answer all the arrived discovery probes. The reply is sent to the address of the probe's sender.
+ * The probes from outside of the LAN and the too frequent ones are ignored
+ * @param sockDescr The socket descriptor of the discovery probes
+ */
+static void answerDiscoveryProbes(const int sockDescr)
+{
+    const time_t now = time(NULL);
+    char reply[DISCOVERY_REPLY_LEN] = {'\0'};
+    char data[sizeof(DISCOVERY_PROBE) + 2];
+    struct sockaddr_storage addr;
+    socklen_t addrLen = sizeof(addr);
+    ssize_t len;
+    while( (len = recvfrom(sockDescr, data, sizeof(data) - 1, 0, (struct sockaddr*) &addr, &addrLen)) != ERR )
 	{
-	    if(FD_ISSET(j, &master))
+	    data[len] = '\0';
+	    data[strcspn(data, "\r\n")] = '\0';
+	    if( (strcmp(data, DISCOVERY_PROBE) == 0) && shouldAnswerDiscoverySender(&addr, addrLen, now) )
 		{
-		    if( (j != listenSocketDescr) )
-			result = sendData(j);
+		    if(reply[0] == '\0')
+			buildDiscoveryReply(reply);
+		    LOG_DEBUG2("\tAnswering the discovery probe: ", reply, TAG);
+		    if(sendto(sockDescr, reply, strlen(reply), MSG_DONTWAIT, (struct sockaddr*) &addr, addrLen) == ERR)
+			writeToLog2("\tERROR answerDiscoveryProbes(): ", strerror(errno), TAG);
 		}
+	    addrLen = sizeof(addr);
 	}
-    return result;
+    if( (errno != EAGAIN) && (errno != EWOULDBLOCK) )
+	writeToLog2("\tERROR answerDiscoveryProbes(): ", strerror(errno), TAG);
 }
 
+/**
+ * Handle the event of the given client's connection
+ * @param conn The connection
+ * @param events The arrived events
+ */
+static void handleConnEvent(struct Connection *conn, const uint32_t events)
+{
+    if(conn->id == NO_CONNECTION)
+	return;
+
+    if(events & (EPOLLERR | EPOLLHUP))
+	{
+	    closeClientConn(conn);
+	    return;
+	}
+
+    if(events & EPOLLIN)
+	{
+	    const int result = receiveData(conn);
+	    if( (result == ERR) || (result == STOP) )
+		{
+		    closeClientConn(conn);
+		    return;
+		}
+	}
+
+    if( (events & EPOLLOUT) && (sendData(conn) == ERR) )
+	closeClientConn(conn);
+}
+
+/**
+ * Send the notification of the changed local IP to all the connected clients
+ * if the IP differs from the notified one
+ */
+static void notifyLocalIpChange()
+{
+    char ip[LOCAL_IP_STR_LEN] = {'\0'};
+    copyLocalIp2Str(ip);
+    if(strcmp(ip, notifiedLocalIP) == 0)
+	return;
+    strcpy(notifiedLocalIP, ip);
 
+    char data[LOCAL_IP_STR_LEN + sizeof(LOCAL_IP_CHANGED) + 2] = {'\0'};
+    snprintf(data, sizeof(data), "%s %s\n", LOCAL_IP_CHANGED, ip);
+    LOG_INFO2("The local IP has changed: ", ip, TAG);
+
+    int i;
+    for(i = 0; i < MAX_CONNECTIONS_NUM; ++i)
+	{
+	    if(connections[i].id != NO_CONNECTION)
+		sendConnMessage(&connections[i], NO_REQUEST, data);
+	}
+}
 
 /**
- * Run client-server connection
+ * Run client-server connection.
+ * The connection runs until the status of running is set to STOP, which signals the stop event
  * @param sockDescr An initialized socket descriptor
  */
 void runConnection(const int sockDescr)
@@ -506,55 +1171,107 @@ void runConnection(const int sockDescr)
     if(sockDescr == ERR)
 	return;
 
-    if (listenConns(sockDescr) == ERR)
+    if ( (listenConns(sockDescr) == ERR) || (setNonBlocking(sockDescr) == ERR) )
 	{
 	    closeSocketConn(sockDescr);
 	    return;
 	}
     
-    initMutexes();
-    
-    int newSockDescr = ERR;
+    setTraceThreadName("net");
+
+    int i;
+    for(i = 0; i < MAX_CONNECTIONS_NUM; ++i)
+	{
+	    pthread_mutex_lock(&mutexConnectedIPs);
+	    connections[i].id        = NO_CONNECTION;
+	    pthread_mutex_unlock(&mutexConnectedIPs);
+	    connections[i].sockDescr = ERR;
+	}
+
+    epollDescr = epoll_create1(EPOLL_CLOEXEC);
+    const int sentDataEvent = initSentDataEvent();
+    const int stopEvent     = initStopEvent();
+
+    const int datagramSock = initVolDatagramSocket();
+    if( (datagramSock != ERR) && (epollDescr != ERR) && (watchDescr(datagramSock, EPOLLIN, DATAGRAM_EVENT) == ERR) )
+	writeToLog2("\tERROR runConnection(): The volume's datagrams won't be received: ", strerror(errno), TAG);
+
+    const int discoverySock = initDiscoverySocket();
+    if( (discoverySock != ERR) && (epollDescr != ERR) && (watchDescr(discoverySock, EPOLLIN, DISCOVERY_EVENT) == ERR) )
+	writeToLog2("\tWARNING runConnection(): The discovery probes won't be answered: ", strerror(errno), TAG);
+
+    const int addrsMonitor = openAddrsMonitor();
+    copyLocalIp2Str(notifiedLocalIP);
+    if( (addrsMonitor != ERR) && (epollDescr != ERR) && (watchDescr(addrsMonitor, EPOLLIN, ADDRS_EVENT) == ERR) )
+	writeToLog2("\tWARNING runConnection(): The local addresses won't be updated: ", strerror(errno), TAG);
+
+    if( (epollDescr == ERR) || (sentDataEvent == ERR) || (stopEvent == ERR) ||
+	(watchDescr(sockDescr, EPOLLIN, LISTENER_EVENT) == ERR) ||
+	(watchDescr(sentDataEvent, EPOLLIN, SENT_DATA_EVENT) == ERR) ||
+	(watchDescr(stopEvent, EPOLLIN, STOP_EVENT) == ERR) )
+	{
+	    writeToLog2("\tERROR runConnection(): ", strerror(errno), TAG);
+	    setRunStatus(STOP);
+	}
+
+    struct epoll_event events[MAX_EVENTS_NUM];
     while( (getRunStatus() != STOP))
     {
-	read_fds = master;
-	if (select(fdmax+1, &read_fds, NULL, NULL, NULL) == ERR)
-	    break;
+	const int eventsNum = epoll_wait(epollDescr, events, MAX_EVENTS_NUM, -1);
+	if (eventsNum == ERR)
+	    {
+		if(errno == EINTR)
+		    continue;
+		writeToLog2("\tERROR runConnection(): ", strerror(errno), TAG);
+		break;
+	    }
 
-	int i;
-	for(i = 0; i <= fdmax; i++)
+	for(i = 0; i < eventsNum; i++)
 	    {
-		if (FD_ISSET(i, &read_fds))
+		const uint32_t data = events[i].data.u32;
+		if(data == STOP_EVENT)
+		    {
+			sendWaitingData();
+			break;
+		    }
+		else if(data == LISTENER_EVENT)
+		    acceptConn(sockDescr);
+		else if(data == SENT_DATA_EVENT)
 		    {
-			if(i == sockDescr)
-			    {
-				newSockDescr = acceptConn(sockDescr);
-				if(newSockDescr != ERR)
-				    {
-					FD_SET(newSockDescr, &master); // add to master set
-					if (newSockDescr > fdmax)
-					    fdmax = newSockDescr;
-					
-					bzero(connectedIP, IP_ADDR_STR_LEN);
-					copyConnectedIp2Str(newSockDescr, connectedIP);		
-				    }
-			    }
-			else
-			    {
-				char receivedDataArr[DATA_LEN] = {'\0'};
-				int result = conversation(receivedDataArr, DATA_LEN, sockDescr, i);
-				if( (result == ERR) || (result == STOP) )
-				    {
-					closeSocketConn(newSockDescr);
-					break;
-				    }
-			    }
+			uint64_t counter;
+			if(read(sentDataEvent, &counter, sizeof(counter)) == sizeof(counter))
+			    sendWaitingData();
 		    }
+		else if(data == DATAGRAM_EVENT)
+		    receiveVolDatagrams(datagramSock);
+		else if(data == DISCOVERY_EVENT)
+		    answerDiscoveryProbes(discoverySock);
+		else if(data == ADDRS_EVENT)
+		    {
+			if(handleAddrsMonitor(addrsMonitor))
+			    notifyLocalIpChange();
+		    }
+		else
+		    handleConnEvent(&connections[data], events[i].events);
 	    }
-	usleep(MILLISECONDS_SLEEP_TIME * 1000); 
     }
 
+    for(i = 0; i < MAX_CONNECTIONS_NUM; ++i)
+	{
+	    if(connections[i].id != NO_CONNECTION)
+		closeClientConn(&connections[i]);
+	}
+
     closeSocketConn(sockDescr);
 
-    destroyMutexes();
+    closeAddrsMonitor(addrsMonitor);
+    if(datagramSock != ERR)
+	closeSocketConn(datagramSock);
+    if(discoverySock != ERR)
+	closeSocketConn(discoverySock);
+    closeSentDataEvent();
+    closeStopEvent();
+    if(epollDescr != ERR)
+	close(epollDescr);
+    epollDescr = ERR;
 }
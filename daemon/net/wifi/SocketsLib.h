@@ -34,8 +34,29 @@
 #define ERR   -1             /**< an error's code */
 #define NO_ERR 0             /**< no errors code  */
 
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * The discovery of the daemon in the LAN, it's enabled by setting the discovery port.
+ * The client broadcasts(IPv4) or multicasts to ff02::1(IPv6) the probe datagram to the discovery port,
+ * the daemon answers by one datagram: "soundroid host=HOST_NAME port=PORT [vol_port=PORT] caps=CAPABILITIES [INFO]".
+ * Only the probes from the private, link-local or local subnets' addresses are answered, once a second per address
+ */
+#define DISCOVERY_PROBE "soundroid?"         /**< The discovery probe */
+#define DISCOVERY_REPLY "soundroid"          /**< The first word of the reply to the discovery probe */
+
 /**
- * Initial connection before listening
+ * The function adding the daemon's info to the reply to the discovery probe
+ * @param info The buffer for the info's text: space separated "NAME=VALUE" pairs
+ * @param len The length of the buffer
+ * @param context The context given while setting the callback
+ */
+typedef void (*DiscoveryInfoCallback)(char *info, const size_t len, void *context);
+
+/**
+ * Initial connection before listening.
+ * Should be called before the connection's thread starts, the data rings are emptied
  * @return socket descriptor or ERR
  */
 const int initConnectionBeforeListen();
@@ -53,6 +74,38 @@ void runConnection(const int sockDescr);
  */
 const int setPort(const char* port);
 
+/**
+ * Set the port number of the volume's datagrams.
+ * The datagrams are received by UDP while the connection runs, the replies to them aren't sent
+ * @param port The port number string, NULL or "" if the datagrams shouldn't be received
+ * @return ERR or NO_ERR
+ */
+const int setVolPort(const char* port);
+
+/**
+ * Set the UDP port number of the discovery probes
+ * @param port The port number string, NULL or "" if the probes shouldn't be answered
+ * @return ERR or NO_ERR
+ */
+const int setDiscoveryPort(const char* port);
+
+/**
+ * Set the function adding the daemon's info to the reply to the discovery probe.
+ * Should be called before running the connection
+ * @param callback The function or NULL
+ * @param context The context which the function should be called with
+ */
+void setDiscoveryInfoCallback(DiscoveryInfoCallback callback, void *context);
+
+/**
+ * Copy the IP of the client of the given connection
+ * @param connId The ID of the connection
+ * @param ip The buffer for the IP string
+ * @param len The length of the buffer
+ * @return false There is no connection with the given ID
+ */
+bool copyConnectionAddr(const int connId, char *ip, const size_t len);
+
 /**
  * Get the string of the last error
  * @return The string of the last error
@@ -1,5 +1,4 @@
 #include "SocketsLib.h"
-#include "ClosingClient.h"
 #include "synchronise.h"
 #include "addr.h"
 
@@ -24,6 +23,8 @@ char *port = NULL;
 void *printReceivedData()
 {
     char *receivedData = NULL;
+    int connId = NO_CONNECTION;
+    int reqId  = NO_REQUEST;
     const char* datas[] = {"test\n", "test\n", "test\n", "test\n", "test\n", "test\n", "test\n"};
     
     int i;
@@ -31,7 +32,7 @@ void *printReceivedData()
 	{
 	    while(true)
 		{
-		    receivedData = getReceivedData();
+		    receivedData = getReceivedData(&connId, &reqId);
 		    if(strlen(receivedData)!= 0)
 			{
 			    if(strcmp(receivedData, "quit") == 0)
@@ -42,7 +43,7 @@ void *printReceivedData()
 			}
 		    usleep(500000);
 		}
-	    setSentData(datas[i]);	    
+	    setSentData(connId, reqId, datas[i]);	    
 	}
 
     printf("Local IP: %s\n", getLocalAddr());    
@@ -52,9 +53,6 @@ void *printReceivedData()
     setRunStatus(STOP);
     printf("Set stop\n");
     
-    runClosingClient(port);
-    printf("Run closing client\n");
-    
     pthread_exit(NULL);
 
 }
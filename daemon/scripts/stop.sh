@@ -21,12 +21,12 @@ if [ -e $FILE ]; then
     PID=`cat $FILE`
     echo "Killing the daemon by sending signal..."
     kill -s $SIGNAL $PID
-    sleep 1
 fi
 
-for i in `seq 1 60`; do
+# The daemon stops in milliseconds, so wait for it by short steps: up to 5 seconds
+for i in `seq 1 100`; do
     PID=`pgrep $PROG_NAME`;
-    [ -z "$PID" ] && break || sleep 1; 
+    [ -z "$PID" ] && break || sleep 0.05; 
 done
 
 PID=`pgrep $PROG_NAME | awk '{print $1}'`
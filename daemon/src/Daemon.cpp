@@ -30,9 +30,14 @@
 extern "C" {
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/signalfd.h>
+#include <sys/eventfd.h>
+#include <poll.h>
 #include <signal.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdlib.h>
+#include "Log.h"
 }
 
 #include <cstdio>
@@ -46,6 +51,7 @@ extern "C" {
 #include "CommandsDispatcherWiFi.h"
 #include "CommandsDispatcherBT.h"
 #include "ConnectionTypes.h"
+#include "SoundBackend.h"
 
 /**<
    \def FILE_NAME
@@ -53,18 +59,60 @@ extern "C" {
 */
 #define FILE_NAME "pid.txt"   
 
-bool stop = false;            /**< Is the process stopped */
-
 //#define SIGNAL SIGUSR1
 #define ERROR -1              /**< an error code */
 
+#define MAX_LOG_FILES_NUM 99  /**< The maximal number of the rotated log files given by the option --log-files= */
+
 /**
- * The handler function of the given signal
- * @param signo The signal number
+ * Block the signals stopping the daemon(SIGTERM, SIGINT) and get the descriptor they are read from.
+ * Should be called before starting any thread, so every thread inherits the blocked signals
+ * @return The descriptor of the signals or ERROR
  */
-void sig_handler(int signo)
+int initSignalDescr()
 {
-    stop = (signo == SIGTERM);
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    if(pthread_sigmask(SIG_BLOCK, &signals, NULL) != 0)
+	return ERROR;
+    return signalfd(-1, &signals, SFD_CLOEXEC);
+}
+
+/**
+ * Run the given commands dispatcher and signal the given event when it has stopped,
+ * e.g. by the command quit
+ * @param dispatcher The instance of the dispatcher
+ * @param stoppedEvent The event
+ */
+void runDispatching(CommandsDispatcher *dispatcher, const int stoppedEvent)
+{
+    dispatcher->start();
+
+    const uint64_t one = 1;
+    if(write(stoppedEvent, &one, sizeof(one)) == ERROR)
+	cerr << "ERROR: can't signal the stop of the dispatcher: " << strerror(errno) << endl;
+}
+
+/**
+ * Wait until a stopping signal arrives or the dispatcher stops by itself
+ * @param signalDescr The descriptor of the stopping signals
+ * @param stoppedEvent The event signaled when the dispatcher has stopped
+ */
+void waitForStop(const int signalDescr, const int stoppedEvent)
+{
+    struct pollfd descrs[2];
+    descrs[0].fd     = signalDescr;
+    descrs[0].events = POLLIN;
+    descrs[1].fd     = stoppedEvent;
+    descrs[1].events = POLLIN;
+
+    while( (poll(descrs, 2, -1) == ERROR) && (errno == EINTR) );
+
+    struct signalfd_siginfo info;
+    if( (descrs[0].revents & POLLIN) && (read(signalDescr, &info, sizeof(info)) != sizeof(info)) )
+	cerr << "ERROR: can't read the arrived signal: " << strerror(errno) << endl;
 }
 
 /**
@@ -147,26 +195,30 @@ void spawn()
 }
 
 /**
- * Run the given commands dispatcher instance
+ * Run the given commands dispatcher instance until a stopping signal arrives
  * @param dispatcher The instance of the dispatcher
+ * @param signalDescr The descriptor of the stopping signals
  */
-int runDispatcher(CommandsDispatcher *dispatcher)
+int runDispatcher(CommandsDispatcher *dispatcher, const int signalDescr)
 {
     int exit_status = EXIT_FAILURE;
+    const int stoppedEvent = eventfd(0, EFD_CLOEXEC);
+    if( (signalDescr == ERROR) || (stoppedEvent == ERROR) )
+	{
+	    cerr << "ERROR: can't initialise the stop events: " << strerror(errno) << endl;
+	    if(stoppedEvent != ERROR)
+		close(stoppedEvent);
+	    delete dispatcher;
+	    return exit_status;
+	}
+
     try
     {
 	savePidToFile();
-	
-        if(signal(SIGTERM, sig_handler) == SIG_ERR)
-	    {
-		delete dispatcher;
-		return exit_status;
-	    }    	    
 
-        thread dispatchingThread(&CommandsDispatcher::start, dispatcher);
+        thread dispatchingThread(runDispatching, dispatcher, stoppedEvent);
 
-        while(!stop)
-	    sleep(1);
+        waitForStop(signalDescr, stoppedEvent);
 
         dispatcher->stop();
         dispatchingThread.join();
@@ -178,6 +230,7 @@ int runDispatcher(CommandsDispatcher *dispatcher)
     	cerr << string("ERROR: ") + string(e.what()) << endl;
     }
     
+    close(stoppedEvent);
     delete dispatcher;
     return exit_status;
 }
@@ -193,7 +246,12 @@ void printHelp(std::ostream &out, const char* progName, const string &firstLine
     if(firstLine != string(""))
 	out << firstLine;
     out << "\tFor running with Bluetooth connection: '" << progName << " bt'\n";
-    out << "\tFor running with WiFi      connection: '" << progName << " wifi PORT_NUMBER'\n";
+    out << "\tFor running with WiFi      connection: '" << progName << " wifi PORT_NUMBER [VOLUME_UDP_PORT_NUMBER [DISCOVERY_UDP_PORT_NUMBER]]'\n";
+    out << "\tThe volume's datagrams aren't received if VOLUME_UDP_PORT_NUMBER is '', the discovery probes are answered only if DISCOVERY_UDP_PORT_NUMBER is given\n";
+    out << "\tThe sound backend may be selected by the first parameter: '" << progName << " --sound=alsa|mem[:LATENCY_US] ...'\n";
+    out << "\tThe rotation of the log file may be set by the first parameters: '" << progName
+	<< " --log-size=MAX_BYTES --log-files=0.." << MAX_LOG_FILES_NUM << " ...', by default "
+	<< MAX_LOG_FILE_LEN << " bytes and " << LOG_GENERATIONS_NUM << " files\n";
 }
 
 /**
@@ -232,7 +290,9 @@ CommandsDispatcherWiFi* getCommandsDispatcherWiFi(char* paramsArr[])
 	    if(paramsArr[1] == string("wifi"))
 		{
 		    string port = paramsArr[2];
-		    return new CommandsDispatcherWiFi(port);
+		    const string volPort = (paramsArr[3] != NULL) ? paramsArr[3]: "";
+		    const string discoveryPort = ( (paramsArr[3] != NULL) && (paramsArr[4] != NULL) ) ? paramsArr[4]: "";
+		    return new CommandsDispatcherWiFi(port, volPort, discoveryPort);
 		}
 	    else
 		printHelp(cerr, paramsArr[0], "ERROR: Unknown parameter\n");	    
@@ -286,6 +346,8 @@ CommandsDispatcher* getDispatcher(const int paramsNum, char* paramsArr[])
 	      saveConnectionType(BLUETOOTH);
 	      return getCommandsDispatcherBT(paramsArr);
 	  case 3:
+	  case 4:
+	  case 5:
 	      saveConnectionType(WIFI);
 	      return getCommandsDispatcherWiFi(paramsArr);
 	  default:
@@ -295,6 +357,68 @@ CommandsDispatcher* getDispatcher(const int paramsNum, char* paramsArr[])
 	return NULL;    
 }
 
+/**
+ * Convert the given value of an option to a number
+ * @param value The string of the value
+ * @param num The number
+ * @return false The value isn't a number
+ */
+bool convertOptionValue(const char *value, long &num)
+{
+    char *end = NULL;
+    errno = 0;
+    num = strtol(value, &end, 10);
+    return (*value != '\0') && (*end == '\0') && (errno == 0);
+}
+
+/**
+ * Process the options given by the first parameters of the command line:
+ * --sound=BACKEND selects the sound backend,
+ * --log-size=MAX_BYTES and --log-files=NUMBER set the rotation of the log file.
+ * The options are removed from the parameters.
+ * Should be called before spawning, while the errors can be printed to the user's terminal
+ * @param paramsNum The number of parameters from the command line
+ * @param paramsArr The parameters from the command line
+ * @return false An option is unknown or its value is invalid
+ */
+bool processOptions(int &paramsNum, char** &paramsArr)
+{
+    const string soundOption    = "--sound=";
+    const string logSizeOption  = "--log-size=";
+    const string logFilesOption = "--log-files=";
+
+    long logSize  = MAX_LOG_FILE_LEN;
+    long logFiles = LOG_GENERATIONS_NUM;
+    while( (paramsNum >= 2) && (string(paramsArr[1]).compare(0, 2, "--") == 0) )
+	{
+	    const string option = paramsArr[1];
+	    bool isValid = true;
+	    if(option.compare(0, soundOption.size(), soundOption) == 0)
+		isValid = SoundBackend::select(option.substr(soundOption.size()));
+	    else if(option.compare(0, logSizeOption.size(), logSizeOption) == 0)
+		isValid = convertOptionValue(paramsArr[1] + logSizeOption.size(), logSize) && (logSize > 0);
+	    else if(option.compare(0, logFilesOption.size(), logFilesOption) == 0)
+		isValid = convertOptionValue(paramsArr[1] + logFilesOption.size(), logFiles) &&
+		          (logFiles >= 0) && (logFiles <= MAX_LOG_FILES_NUM);
+	    else
+		{
+		    printHelp(cerr, paramsArr[0], "ERROR: Unknown option " + option + "\n");
+		    return false;
+		}
+	    if(!isValid)
+		{
+		    printHelp(cerr, paramsArr[0], "ERROR: Invalid value of the option " + option + "\n");
+		    return false;
+		}
+	    paramsArr[1] = paramsArr[0];
+	    ++paramsArr;
+	    --paramsNum;
+	}
+
+    setLogRotation(logSize, logFiles);
+    return true;
+}
+
 /**
  * The main function of the daemon
  * @param argc There is parameter - port number
@@ -305,16 +429,23 @@ int main(int argc, char* argv[])
 //	killOtherProcess();
 
     int exit_status = EXIT_FAILURE;
+
+    // the invalid options are reported to the terminal before detaching from it
+    if(!processOptions(argc, argv))
+	exit(exit_status);
        
     spawn();
     closeStandardStreams();
 
+    const int signalDescr = initSignalDescr();
     CommandsDispatcher *dispatcher = getDispatcher(argc, argv);
     if(dispatcher != NULL)
 	{	    
-	    exit_status = runDispatcher(dispatcher);
+	    exit_status = runDispatcher(dispatcher, signalDescr);
 	    remove(FILE_NAME);
 	}    
+    if(signalDescr != ERROR)
+	close(signalDescr);
     
     exit(exit_status);
 }
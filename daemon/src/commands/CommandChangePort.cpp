@@ -41,20 +41,19 @@ const char* CommandChangePort::TAG = "COMMAND_CHG_PORT";   /**< The tag for writ
  * @param params The parameters of the command
  * @return The string of the commands result: ERR or OK
  */
-string CommandChangePort::execute(const list<string> &params) const
+string CommandChangePort::execute(const CommandParams &params) const
 {
-    if(params.size() == 0)
+    if(params.num == 0)
 	{
-	    writeToLog(string("ERROR: execute(): The given list of parameters is empty").c_str(), TAG);
+	    writeToLog(string("ERROR: execute(): The given parameters are empty").c_str(), TAG);
 	    return ERR;
 	}
-    string param = params.front();
-    if(param.empty())
+    const string portStr = params.strs[0];
+    if(portStr.empty())
 	{
 	    writeToLog(string("ERROR: execute(): The given parameter is empty").c_str(), TAG);
 	    return ERR;
 	}
-    const string portStr = params.front();
     
     return (dispatcher_.restartNetConnector(portStr)) ? OK: ERR;
 }
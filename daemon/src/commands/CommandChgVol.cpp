@@ -29,10 +29,11 @@
 #include "CommandChgVol.h"
 extern "C" {
 #include "Log.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
 }
 
-#include <exception>
-
 using namespace std;
 
 const char* CommandChgVol::TAG = "COMMAND_CHG_VOL";    /**< The tag for writing to log file */
@@ -42,30 +43,31 @@ const char* CommandChgVol::TAG = "COMMAND_CHG_VOL";    /**< The tag for writing
  * @param params The parameters of the command
  * @return The string of the commands result: ERR or OK
  */
-string CommandChgVol::execute(const list<string> &params) const
+string CommandChgVol::execute(const CommandParams &params) const
 {
-    if(params.size() == 0)
+    if(params.num == 0)
 	{
-	    writeToLog(string("ERROR: execute(): The given list of parameters is empty").c_str(), TAG);
+	    writeToLog(string("ERROR: execute(): The given parameters are empty").c_str(), TAG);
 	    return ERR;
 	}
-    string param = params.front();
-    if(param.empty())
+    const char *param = params.strs[0];
+    if(param[0] == '\0')
 	{
 	    writeToLog(string("ERROR: execute(): The given parameter is empty").c_str(), TAG);
 	    return ERR;
 	}
-    try
+    char *end = NULL;
+    errno = 0;
+    const long value = strtol(param, &end, 10);
+    if(*end != '\0')
 	{
-	    const int value = stoi(param);
-	    sndConnector_.doChgVol(value);
-	    std::string answerStr = "";
-	    while( (answerStr = sndConnector_.receive()).length() == 0);
-	    return answerStr;
+	    writeToLog2("ERROR: execute(): Can't convert the given parameter string to int: ", param, TAG);
+	    return ERR;
 	}
-    catch (exception &e)
+    if( (errno == ERANGE) || (value < INT_MIN) || (value > INT_MAX) )
 	{
-	    writeToLog(string("ERROR: execute(): Can't convert the given parameter string " + param + " to int: " + e.what() + "\n").c_str(), TAG);
+	    writeToLog2("ERROR: execute(): The given parameter is out of the range of int: ", param, TAG);
 	    return ERR;
 	}
+    return sndConnector_.doChgVol(value) ? OK: ERR;
 }
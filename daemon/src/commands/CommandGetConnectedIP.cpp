@@ -29,12 +29,12 @@
 #include "CommandGetConnectedIP.h"
 
 /**
- * Execute the command for giving the connected IP
+ * Execute the command for giving the connected IP of the client which has sent the command
  * @return The string of the connected IP
  */
 std::string CommandGetConnectedIP::execute()
 {
-	return netConnector_.getConnectedAddrStr();
+	return netConnector_.getConnectedAddrStr(clientID_);
 }
 
 
@@ -0,0 +1,68 @@
+/**
+ * Command to get or change the level of the daemon's log
+ * @file
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "CommandLogLevel.h"
+extern "C" {
+#include "Log.h"
+}
+
+using namespace std;
+
+const char* CommandLogLevel::TAG = "COMMAND_LOG_LEVEL";    /**< The tag for writing to log file */
+
+/**
+ * Get the name of the current level of the log
+ * @return The name of the level: trace, debug, info, warn or error
+ */
+string CommandLogLevel::execute()
+{
+    return getLogLevelName(getLogLevel());
+}
+
+/**
+ * Change the level of the log to the level with the given name
+ * @param params The parameters' strings, the first one is the name of the level
+ * @return The string of execution result: OK or ERR
+ */
+string CommandLogLevel::execute(const CommandParams &params) const
+{
+    if(params.num == 0)
+	{
+	    writeToLog("ERROR: execute(): The given parameters are empty\n", TAG);
+	    return ERR;
+	}
+    const int level = getLogLevelByName(params.strs[0]);
+    if(level == -1)
+	{
+	    writeToLog(string("ERROR: execute(): Unknown log level '" + string(params.strs[0]) + "'\n").c_str(), TAG);
+	    return ERR;
+	}
+    setLogLevel(level);
+    writeToLog2("The log level has changed to ", params.strs[0], TAG);
+    return OK;
+}
@@ -34,8 +34,5 @@
  */
 std::string CommandMute::execute()
 {
-    std::string answerStr = "";
-    sndConnector_.doMute();
-    while( (answerStr = sndConnector_.receive()).length() == 0);
-    return answerStr;
+    return sndConnector_.doMute() ? OK: ERR;
 }
@@ -0,0 +1,73 @@
+/**
+ * The command for setting volume of the system sound
+ * @file
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "CommandSetVol.h"
+extern "C" {
+#include "Log.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+}
+
+using namespace std;
+
+const char* CommandSetVol::TAG = "COMMAND_SET_VOL";    /**< The tag for writing to log file */
+
+/**
+ * Execute the command for setting volume with the given parameters
+ * @param params The parameters of the command
+ * @return The string of the commands result: ERR or OK
+ */
+string CommandSetVol::execute(const CommandParams &params) const
+{
+    if(params.num == 0)
+	{
+	    writeToLog(string("ERROR: execute(): The given parameters are empty").c_str(), TAG);
+	    return ERR;
+	}
+    const char *param = params.strs[0];
+    if(param[0] == '\0')
+	{
+	    writeToLog(string("ERROR: execute(): The given parameter is empty").c_str(), TAG);
+	    return ERR;
+	}
+    char *end = NULL;
+    errno = 0;
+    const long value = strtol(param, &end, 10);
+    if(*end != '\0')
+	{
+	    writeToLog2("ERROR: execute(): Can't convert the given parameter string to int: ", param, TAG);
+	    return ERR;
+	}
+    if( (errno == ERANGE) || (value < INT_MIN) || (value > INT_MAX) )
+	{
+	    writeToLog2("ERROR: execute(): The given parameter is out of the range of int: ", param, TAG);
+	    return ERR;
+	}
+    return sndConnector_.doSetVol(value) ? OK: ERR;
+}
@@ -1,7 +1,6 @@
 /**
  * @file
- * The closing client should send the closing message to the server,
- * to stop its running
+ * The command getting the metrics of the commands and of the connectors
  *
  **
  * The MIT License (MIT)
@@ -27,14 +26,37 @@
  * SOFTWARE.
  */
 
-#ifndef CLOSING_CLIENT_H
-#define CLOSING_CLIENT_H
+#include "CommandStats.h"
+#include "Metrics.h"
+extern "C" {
+#include "Log.h"
+}
+
+using namespace std;
+
+const char* CommandStats::TAG = "COMMAND_STATS";    /**< The tag for writing to log file */
 
 /**
- * Run the client for closing
- * @param port The port number string of client
- * @return The status: ERR or NO_ERR
+ * Get the totals of the commands
+ * @return The numbers separated by spaces
  */
-const int runClosingClient(const char *port);
+string CommandStats::execute()
+{
+    return metrics_.getStats("");
+}
 
-#endif
+/**
+ * Get the metrics of the command or of the connector with the given name
+ * @param params The parameters' strings, the first one is the name
+ * @return The numbers separated by spaces or ERR if there is nothing with the given name
+ */
+string CommandStats::execute(const CommandParams &params) const
+{
+    const string stats = metrics_.getStats(params.strs[0]);
+    if(stats.empty())
+	{
+	    writeToLog(string("ERROR: execute(): There are no metrics of '" + string(params.strs[0]) + "'\n").c_str(), TAG);
+	    return ERR;
+	}
+    return stats;
+}
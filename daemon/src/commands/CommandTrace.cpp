@@ -0,0 +1,89 @@
+/**
+ * @file
+ * Command to control the tracing of the requests' hops
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "CommandTrace.h"
+extern "C" {
+#include "Log.h"
+#include "Trace.h"
+}
+
+using namespace std;
+
+#define TRACE_ON    "on"                     /**< The parameter enabling the tracing */
+#define TRACE_OFF   "off"                    /**< The parameter disabling the tracing */
+#define TRACE_DUMP  "dump"                   /**< The parameter dumping the traces to the file */
+#define TRACE_CLEAR "clear"                  /**< The parameter clearing the traces */
+
+const char* CommandTrace::TAG = "COMMAND_TRACE";    /**< The tag for writing to log file */
+
+/**
+ * Get the state of the tracing
+ * @return The string of the state: on or off
+ */
+string CommandTrace::execute()
+{
+    return isTraceEnabled() ? TRACE_ON: TRACE_OFF;
+}
+
+/**
+ * Enable, disable, dump or clear the tracing
+ * @param params The parameters' strings, the first one is on, off, dump or clear
+ * @return The string of execution result: OK or ERR
+ */
+string CommandTrace::execute(const CommandParams &params) const
+{
+    if(params.num == 0)
+	{
+	    writeToLog("ERROR: execute(): The given parameters are empty\n", TAG);
+	    return ERR;
+	}
+    const string param = params.strs[0];
+    if( (param == TRACE_ON) || (param == TRACE_OFF) )
+	{
+	    setTraceEnabled(param == TRACE_ON);
+	    writeToLog2("The tracing has turned ", params.strs[0], TAG);
+	    return OK;
+	}
+    if(param == TRACE_DUMP)
+	{
+	    if(!dumpTrace(TRACE_FILE_NAME))
+		{
+		    writeToLog("ERROR: execute(): Can't dump the traces to the file " TRACE_FILE_NAME "\n", TAG);
+		    return ERR;
+		}
+	    writeToLog("The traces have been dumped to the file " TRACE_FILE_NAME "\n", TAG);
+	    return OK;
+	}
+    if(param == TRACE_CLEAR)
+	{
+	    clearTrace();
+	    return OK;
+	}
+    writeToLog(string("ERROR: execute(): Unknown tracing parameter '" + param + "'\n").c_str(), TAG);
+    return ERR;
+}
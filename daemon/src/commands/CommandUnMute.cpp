@@ -34,10 +34,7 @@
  */
 std::string CommandUnMute::execute()
 {
-    sndConnector_.doUnmute();
-    std::string answerStr = "";
-    while( (answerStr = sndConnector_.receive()).length() == 0);
-    return answerStr;
+    return sndConnector_.doUnmute() ? OK: ERR;
 }
 
 
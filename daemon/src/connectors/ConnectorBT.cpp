@@ -27,6 +27,7 @@
  * SOFTWARE.
  */
 #include "ConnectorBT.h"
+#include "CommandsQueue.h"
 
 extern "C" {
 #include "synchronise.h"
@@ -46,9 +47,19 @@ const char* ConnectorBT::TAG = "BT_CONNECTOR";         /**< The tag for writting
 /**
  * Constructor
  */
-ConnectorBT::ConnectorBT()
+ConnectorBT::ConnectorBT(): btLibHandle_(NULL), btLibFuncs_()
 {
     socketDescr = initBtConnectionBeforeListen();
+    loadBtLib(BT_DYN_LIB);
+}
+
+/**
+ * Destructor. Unloads the bluetooth library
+ */
+ConnectorBT::~ConnectorBT()
+{
+    if( (btLibHandle_ != NULL) && (dlclose(btLibHandle_) != 0) )
+	writeToLog("ERROR: Can't close the handle of the opened dynamic library\n", TAG);
 }
 
 /**
@@ -64,7 +75,7 @@ void ConnectorBT::stop()
  */
 void ConnectorBT::run()
 {
-    setRunStatus(RUN);
+    setDataArrivedCallback(&ConnectorBT::onDataArrived, this);
     runBtConnection(socketDescr);
     setRunStatus(STOP);
 }
@@ -93,56 +104,108 @@ const string ConnectorBT::getLastErrStr() const
  */
 const string ConnectorBT::receive()
 {
-    return getReceivedData();
+    int connId = NO_CONNECTION;
+    int reqId = NO_REQUEST;
+    return getReceivedData(&connId, &reqId);
+}
+
+/**
+ * Push the arrived data into the commands queue.
+ * Called by the connection library when a new data has arrived
+ * @param connId The ID of the connection the data arrived from
+ * @param reqId The ID of the client's request or NO_REQUEST
+ * @param dataStr The string of the arrived data
+ * @param context The pointer to the connector instance
+ */
+void ConnectorBT::onDataArrived(const int connId, const int reqId, const char *dataStr, void *context)
+{
+    ConnectorBT *connector = static_cast<ConnectorBT*>(context);
+    if( (dataStr[0] != '\0') && (connector->commandsQueue_ != NULL) )
+	connector->commandsQueue_->push(connector, connId, dataStr, reqId);
 }
 
 /**
  * Send the given data string to client
  * @param dataStr The data string 
+ * @param clientID The ID of the client the data should be sent to
+ * @param requestID The ID of the client's request the data replies to
  */
-void ConnectorBT::send(const string &dataStr)
+void ConnectorBT::send(const string &dataStr, const int clientID, const int requestID)
 {
 	if(dataStr.empty())
 	{
-		writeToLog("WARNING: send(): can't send the given empty string", TAG);
+		LOG_WARN("WARNING: send(): can't send the given empty string", TAG);
 		return;
 	}
-	setSentData(string(dataStr + "\n").c_str());
+	setSentData(clientID, requestID, string(dataStr + "\n").c_str());
 }
 
 /**
- * Call to the function from a dynamic library
- * @param funcName The name of the function
+ * Send the notification string to all the connected clients
+ * @param dataStr The string of the notification
+ */
+void ConnectorBT::notify(const string &dataStr)
+{
+    setSentData(ALL_CONNECTIONS, NO_REQUEST, string(dataStr + "\n").c_str());
+}
+
+/**
+ * Load the bluetooth library and resolve its functions.
+ * If the library or a function is missing, the function isn't resolved and the address queries return ""
  * @param libName The name of the library
- * @return The string result of the function
  */
-const char* ConnectorBT::callToFuncFromDynLib(const char *funcName, const char *libName) const
+void ConnectorBT::loadBtLib(const char *libName)
 {
-    void *handle = dlopen(libName, RTLD_LAZY);
-    if(!handle)
+    btLibHandle_ = dlopen(libName, RTLD_NOW);
+    if(btLibHandle_ == NULL)
 	{
 	    writeToLog2("ERROR: Can't load ", libName, TAG);
 	    writeToLog2("\t", dlerror(), TAG);
-	    return "";
+	    writeToLog("\tThe bluetooth addresses will be unavailable\n", TAG);
+	    return;
 	}
-    dlerror();
 
-    const char* (*func)() = (const char* (*)())dlsym(handle, funcName);
-    char *err = dlerror();
+    btLibFuncs_.getLocalAddr     = (const char* (*)())getBtLibFunc("getLocalAddr");
+    btLibFuncs_.getConnectedAddr = (const char* (*)())getBtLibFunc("getConnectedAddr");
+}
+
+/**
+ * Resolve the function of the loaded bluetooth library
+ * @param funcName The name of the function
+ * @return The pointer to the function or NULL
+ */
+void* ConnectorBT::getBtLibFunc(const char *funcName) const
+{
+    dlerror();
+    void *func = dlsym(btLibHandle_, funcName);
+    const char *err = dlerror();
     if(err != NULL)
 	{
-	    writeToLog2("ERROR: Can't get function from the ", libName, TAG);
+	    writeToLog2("ERROR: Can't get function from the ", BT_DYN_LIB, TAG);
 	    writeToLog2("\t", err, TAG);
-	    return "";
+	    return NULL;
 	}
+    return func;
+}
+
+/**
+ * Call to the resolved function returning a string
+ * @param func The function or NULL
+ * @param funcName The name of the function for logging
+ * @return The string result of the function or "" if the function isn't resolved
+ */
+const string ConnectorBT::callToBtLibFunc(const char* (*func)(), const char *funcName) const
+{
+    if(func == NULL)
+	return "";
 
-    const char* returnedStr = (*func)();
-    
-    if(dlclose(handle) != 0)
+    const char *str = (*func)();
+    if(str == NULL)
 	{
-	    writeToLog("ERROR: Can't close the handle of the opened dynamic library\n", TAG);
+	    LOG_WARN2("WARNING: The received string is NULL: ", funcName, TAG);
+	    return "";
 	}
-    return returnedStr;
+    return string(str);
 }
 
 /**
@@ -151,28 +214,17 @@ const char* ConnectorBT::callToFuncFromDynLib(const char *funcName, const char *
  */
 const string ConnectorBT::getLocalAddrStr() const
 {
-    const char *addr = callToFuncFromDynLib("getLocalAddr", BT_DYN_LIB);
-    if(addr == NULL)
-    {
-    	writeToLog("WARNING: getLocalAddrStr(): The received local address string is NULL\n", TAG);
-    	addr = "";
-    }
-    return string(addr);
+    return callToBtLibFunc(btLibFuncs_.getLocalAddr, "getLocalAddr");
 }
 
 /**
- * Get the IP string of a connected client
+ * Get the IP string of a connected client, there is one connected client only
+ * @param clientID The ID of the client, it's ignored
  * @return The IP string of the connected client or "" if there is no one connected
  */
-const string ConnectorBT::getConnectedAddrStr() const
+const string ConnectorBT::getConnectedAddrStr(const int clientID) const
 {
-    const char* addr = callToFuncFromDynLib("getConnectedAddr", BT_DYN_LIB);
-    if(addr == NULL)
-    {
-    	writeToLog("WARNING: getConnectedAddrStr(): The received connected address string is NULL\n", TAG);
-    	addr = "";
-    }
-	return string(addr);
+    return callToBtLibFunc(btLibFuncs_.getConnectedAddr, "getConnectedAddr");
 }
 
 
@@ -182,7 +234,7 @@ const string ConnectorBT::getConnectedAddrStr() const
  */
 const string ConnectorBT::getUsedPort() const
 {
-    writeToLog("WARNING: the func getUsedPort() can't be used'", TAG);
+    LOG_WARN("WARNING: the func getUsedPort() can't be used'", TAG);
     return "";
 }
 
@@ -201,6 +253,6 @@ void ConnectorBT::setPortNum(const string &portNum) throw(PortException)
  */
 const bool ConnectorBT::isPortAvailable()
 {
-    writeToLog("WARNING: the func isPortAvailable() can't be used'", TAG);
+    LOG_WARN("WARNING: the func isPortAvailable() can't be used'", TAG);
     return false;
 }
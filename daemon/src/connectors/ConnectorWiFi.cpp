@@ -27,17 +27,20 @@
  * SOFTWARE.
  */
 #include "ConnectorWiFi.h"
+#include "CommandsQueue.h"
 
 extern "C" {
 #include "synchronise.h"
 #include "SocketsLib.h"
-#include "ClosingClient.h"
 #include "Log.h"
 #include "addr.h"
+#include <netinet/in.h>
 }
 
 #include <sstream>
 #include <iostream>
+#include <climits>
+#include <cstring>
 
 const char* ConnectorWiFi::TAG = "NET_CONNECTOR";         /**< The tag for writting to log file */
 
@@ -74,6 +77,55 @@ void ConnectorWiFi::setPortNum(const string &portNum) throw(PortException)
     portNumStr_ = portNum;
 }
 
+/**
+ * Check the given string of the port number of the datagrams
+ * @param portNum The string of the port number or ""
+ */
+void ConnectorWiFi::checkDatagramPortNum(const string &portNum) const throw(PortException)
+{
+    if(portNum.empty())
+	return;
+    try
+	{
+	    if(stoul(portNum) > USHRT_MAX)
+		processPortNumErr(string("The given port number string '" + portNum + "' is out of range\n"));
+	}
+    catch (std::invalid_argument &e)
+	{
+	    processPortNumErr(string("The given port number string '" + portNum + "' can't be converted to number\n"));
+	}
+    catch (std::out_of_range &e)
+	{
+	    processPortNumErr(string("The given port number string '" + portNum + "' is out of range\n"));
+	}
+}
+
+/**
+ * Set the given port number of the volume's datagrams
+ * @param portNum The string with the port number or "" if the datagrams shouldn't be received
+ */
+void ConnectorWiFi::setVolPortNum(const string &portNum) throw(PortException)
+{
+    checkDatagramPortNum(portNum);
+    if (setVolPort(portNum.c_str()) == ERR)
+	{
+	    processPortNumErr(string("Can't set the port of the volume's datagrams with number " + portNum + "\n"));
+	}
+}
+
+/**
+ * Set the given port number of the discovery probes
+ * @param portNum The string with the port number or "" if the probes shouldn't be answered
+ */
+void ConnectorWiFi::setDiscoveryPortNum(const string &portNum) throw(PortException)
+{
+    checkDatagramPortNum(portNum);
+    if (setDiscoveryPort(portNum.c_str()) == ERR)
+	{
+	    processPortNumErr(string("Can't set the port of the discovery probes with number " + portNum + "\n"));
+	}
+}
+
 /**
  * Process the string of the port number error
  * The error will be written to log file and thrown by exception
@@ -87,11 +139,11 @@ void ConnectorWiFi::processPortNumErr(const string &errStr) const throw(PortExce
 
 /**
  * Stop the connector
+ * Setting the STOP status signals the stop event the connection's loop waits on
  */
 void ConnectorWiFi::stop()
 {
 	setRunStatus(STOP);
-	runClosingClient(portNumStr_.c_str());
 }
 
 /**
@@ -109,7 +161,8 @@ const bool ConnectorWiFi::isPortAvailable()
  */
 void ConnectorWiFi::run()
 {
-	setRunStatus(RUN);
+	setDataArrivedCallback(&ConnectorWiFi::onDataArrived, this);
+	setDiscoveryInfoCallback(&ConnectorWiFi::onDiscoveryProbe, this);
 	runConnection(socketDescr);
 	setRunStatus(STOP);
 }
@@ -138,21 +191,68 @@ const string ConnectorWiFi::getLastErrStr() const
  */
 const string ConnectorWiFi::receive()
 {
-    return getReceivedData();
+    int connId = NO_CONNECTION;
+    int reqId = NO_REQUEST;
+    return getReceivedData(&connId, &reqId);
+}
+
+/**
+ * Push the arrived data into the commands queue.
+ * Called by the connection library when a new data has arrived
+ * @param connId The ID of the connection the data arrived from
+ * @param reqId The ID of the client's request or NO_REQUEST
+ * @param dataStr The string of the arrived data
+ * @param context The pointer to the connector instance
+ */
+void ConnectorWiFi::onDataArrived(const int connId, const int reqId, const char *dataStr, void *context)
+{
+    ConnectorWiFi *connector = static_cast<ConnectorWiFi*>(context);
+    if( (dataStr[0] != '\0') && (connector->commandsQueue_ != NULL) )
+	connector->commandsQueue_->push(connector, connId, dataStr, reqId);
+}
+
+/**
+ * Add the daemon's info to the reply to the discovery probe.
+ * Called by the connection library when a discovery probe has arrived
+ * @param info The buffer for the info's text
+ * @param len The length of the buffer
+ * @param context The pointer to the connector instance
+ */
+void ConnectorWiFi::onDiscoveryProbe(char *info, const size_t len, void *context)
+{
+    ConnectorWiFi *connector = static_cast<ConnectorWiFi*>(context);
+    if( (len == 0) || !connector->discoveryInfoProvider_ )
+	return;
+    const string str = connector->discoveryInfoProvider_();
+    strncpy(info, str.c_str(), len - 1);
+    info[len - 1] = '\0';
 }
 
 /**
  * Send the given data string to client
  * @param dataStr The data string 
+ * @param clientID The ID of the client the data should be sent to
+ * @param requestID The ID of the client's request the data replies to
  */
-void ConnectorWiFi::send(const string &dataStr)
+void ConnectorWiFi::send(const string &dataStr, const int clientID, const int requestID)
 {
+	if(clientID == DATAGRAM_CONNECTION)   // the datagrams have no replies
+		return;
 	if(dataStr.empty())
 	{
-		writeToLog("WARNING: send(): can't send the given empty string", TAG);
+		LOG_WARN("WARNING: send(): can't send the given empty string", TAG);
 		return;
 	}
-	setSentData(string(dataStr + "\n").c_str());
+	setSentData(clientID, requestID, string(dataStr + "\n").c_str());
+}
+
+/**
+ * Send the notification string to all the connected clients
+ * @param dataStr The string of the notification
+ */
+void ConnectorWiFi::notify(const string &dataStr)
+{
+    setSentData(ALL_CONNECTIONS, NO_REQUEST, string(dataStr + "\n").c_str());
 }
 
 /**
@@ -164,7 +264,7 @@ const string ConnectorWiFi::getLocalAddrStr() const
     const char* ip = getLocalAddr();
     if(ip == NULL)
     {
-    	writeToLog("WARNING: getLocalIpStr(): The received local IP string is NULL\n", TAG);
+    	LOG_WARN("WARNING: getLocalIpStr(): The received local IP string is NULL\n", TAG);
     	ip = "";
     }
 	return string(ip);
@@ -172,14 +272,19 @@ const string ConnectorWiFi::getLocalAddrStr() const
 
 /**
  * Get the IP string of a connected client
+ * @param clientID The ID of the client or -1 for the last connected client
  * @return The IP string of the connected client or "" if there is no one connected
  */
-const string ConnectorWiFi::getConnectedAddrStr() const
+const string ConnectorWiFi::getConnectedAddrStr(const int clientID) const
 {
+    char clientIP[INET6_ADDRSTRLEN] = {'\0'};
+    if(copyConnectionAddr(clientID, clientIP, sizeof(clientIP)))
+	return string(clientIP);
+
     const char* ip = getConnectedAddr();
     if(ip == NULL)
     {
-    	writeToLog("WARNING: getConnectedIpStr(): The received connected IP string is NULL\n", TAG);
+    	LOG_WARN("WARNING: getConnectedIpStr(): The received connected IP string is NULL\n", TAG);
     	ip = "";
     }
 	return string(ip);
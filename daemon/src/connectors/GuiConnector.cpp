@@ -27,6 +27,7 @@
  * SOFTWARE.
  */
 #include "GuiConnector.h"
+#include "CommandsQueue.h"
 #include "CommandsNames.h"
 
 #include <string>
@@ -35,6 +36,7 @@
 
 extern "C" {
 	#include <Log.h>
+	#include "Trace.h"
 	#include "MsgsQueueServer.h"
 }
 
@@ -58,6 +60,8 @@ GuiConnector::GuiConnector() throw(GuiException)
  */
 void GuiConnector::run()
 {
+    setTraceThreadName("gui");
+    setMsgArrivedCallback(&GuiConnector::onMsgArrived, this);
     runQueue();
 }
 
@@ -89,18 +93,34 @@ void GuiConnector::stop()
 /**
  * Send the given data string to GUI
  * @param newDataStr The data string for sending
+ * @param clientID The ID of the client the data should be sent to
+ * @param requestID The ID of the client's request the data replies to
  */
-void GuiConnector::send(const string &newDataStr)
+void GuiConnector::send(const string &newDataStr, const int clientID, const int requestID)
 {
     const char* msgTxt = (newDataStr.length() == 0) ? "None": newDataStr.c_str();
-    sendMsgServer(msgTxt);
+    sendMsgServer(clientID, msgTxt);
 }
 
 /**
- * Receive a data string from GUI
- * @return The data string from GUI
+ * Send the notification string to GUI
+ * @param dataStr The string of the notification
  */
-const string GuiConnector::receive()
+void GuiConnector::notify(const string &dataStr)
 {
-    return receiveMsgServer();
+    sendNotificationServer(dataStr.c_str());
+}
+
+/**
+ * Push the arrived message into the commands queue.
+ * Called by the messages queue when a new message has arrived
+ * @param clientID The ID of the GUI client the message has arrived from
+ * @param msgTxt The text of the message
+ * @param context The pointer to the connector instance
+ */
+void GuiConnector::onMsgArrived(const int clientID, const char *msgTxt, void *context)
+{
+    GuiConnector *connector = static_cast<GuiConnector*>(context);
+    if( (msgTxt[0] != '\0') && (connector->commandsQueue_ != NULL) )
+	connector->commandsQueue_->push(connector, clientID, msgTxt);
 }
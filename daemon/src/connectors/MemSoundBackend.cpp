@@ -0,0 +1,154 @@
+/**
+ * @file
+ * The sound backend keeping the volume in memory
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "MemSoundBackend.h"
+
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#define MAX_VOLUME 100                      /**< The maximal volume percents */
+#define INITIAL_VOLUME 50                   /**< The volume at the start */
+
+using namespace std;
+
+/**
+ * Constructor
+ * @param latencyUs The delay added to every operation in microseconds
+ */
+MemSoundBackend::MemSoundBackend(const unsigned int latencyUs): volume_(INITIAL_VOLUME), muted_(false), latencyUs_(latencyUs),
+								callback_(NULL), callbackContext_(NULL)
+{
+}
+
+/**
+ * Wait for the latency of the operation
+ */
+void MemSoundBackend::delay() const
+{
+    if(latencyUs_ > 0)
+	this_thread::sleep_for(chrono::microseconds(latencyUs_));
+}
+
+/**
+ * Call the changed callback with the current state
+ */
+void MemSoundBackend::notifyChanged()
+{
+    if(callback_ != NULL)
+	callback_(volume_.load(), muted_.load(), callbackContext_);
+}
+
+/**
+ * Set the function which should be called when the volume or the mute state has changed.
+ * It's called by the thread which has changed the state
+ * @param callback The function or NULL
+ * @param context The context which the function should be called with
+ */
+void MemSoundBackend::setChangedCallback(ChangedCallback callback, void *context)
+{
+    callbackContext_ = context;
+    callback_        = callback;
+}
+
+/**
+ * Make the sound state muted
+ * @return true
+ */
+const bool MemSoundBackend::mute()
+{
+    delay();
+    if(!muted_.exchange(true))
+	notifyChanged();
+    return true;
+}
+
+/**
+ * Unmute the sound state
+ * @return true
+ */
+const bool MemSoundBackend::unmute()
+{
+    delay();
+    if(muted_.exchange(false))
+	notifyChanged();
+    return true;
+}
+
+/**
+ * Change the current volume by the given value, the volume is limited by 0 and 100
+ * @param value The value of the change in percents, negative for decreasing
+ * @return true
+ */
+const bool MemSoundBackend::chgVol(const int value)
+{
+    delay();
+    long current = volume_.load();
+    long changed;
+    do
+	changed = min<long>(max<long>(current + value, 0), MAX_VOLUME);
+    while(!volume_.compare_exchange_weak(current, changed));
+
+    if(changed != current)
+	notifyChanged();
+    return true;
+}
+
+/**
+ * Set the current volume to the given value, it's limited by 0 and 100
+ * @param value The value of the volume in percents
+ * @return true
+ */
+const bool MemSoundBackend::setVol(const int value)
+{
+    delay();
+    const long changed = min<long>(max<long>(value, 0), MAX_VOLUME);
+    if(volume_.exchange(changed) != changed)
+	notifyChanged();
+    return true;
+}
+
+/**
+ * Get the current volume
+ * @return The current volume percents
+ */
+const long MemSoundBackend::getVol()
+{
+    delay();
+    return volume_.load();
+}
+
+/**
+ * Is the sound state muted
+ * @return true The sound state is muted
+ */
+const bool MemSoundBackend::isMuted()
+{
+    delay();
+    return muted_.load();
+}
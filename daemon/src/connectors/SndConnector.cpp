@@ -28,68 +28,175 @@
  */
 
 #include "SndConnector.h"
+#include "SoundBackend.h"
 #include "CommandsNames.h"
+#include "CommandsQueue.h"
 
 extern "C" {
-	#include "SoundLib.h"
 	#include "Log.h"
+	#include "Trace.h"
+	#include <sys/eventfd.h>
+	#include <poll.h>
+	#include <unistd.h>
+	#include <errno.h>
+	#include <string.h>
 }
 
+#define MAX_MIXER_DESCRS_NUM 8              /**< The maximal number of the polled descriptors of the mixer */
+#define REATTACH_TIMEOUT_MS 5000            /**< The timeout of re-attaching the not available mixer in milliseconds */
+
 using namespace std;
 
 const char* SndConnector::TAG = "SND_CONNECTOR";                   /**< The tag for writting to log file */
 
 /**
- * Set the given string as arrived data
- * @param str The string for setting of the arrived data
+ * Constructor
+ * Creates the sound backend selected at the startup, it's used by all the sound commands
+ */
+SndConnector::SndConnector(): backend_(SoundBackend::create()), notifiedVolume_(-1), notifiedMuted_(-1)
+{
+    cachedVolume_ = backend_->getVol();
+    backend_->setChangedCallback(&SndConnector::onSoundChanged, this);
+
+    stopEvent_ = eventfd(0, EFD_CLOEXEC);
+    if(stopEvent_ < 0)
+	writeToLog(string("ERROR: Can't create the stop event: " + string(strerror(errno)) + "\n").c_str(), TAG);
+}
+
+/**
+ * Destructor
+ */
+SndConnector::~SndConnector()
+{
+    delete backend_;
+    if(stopEvent_ >= 0)
+	close(stopEvent_);
+}
+
+/**
+ * Run the connector
+ * It waits for the events of the sound system mixer, e.g. changing the volume by the desktop's keys
+ */
+void SndConnector::run()
+{
+    if(stopEvent_ < 0)
+	return;
+
+    setTraceThreadName("snd");
+    struct pollfd descrs[MAX_MIXER_DESCRS_NUM + 1];
+    while(true)
+	{
+	    descrs[0].fd      = stopEvent_;
+	    descrs[0].events  = POLLIN;
+	    descrs[0].revents = 0;
+
+	    const unsigned int mixerDescrsNum = backend_->getDescrs(descrs + 1, MAX_MIXER_DESCRS_NUM);
+
+	    const int res = poll(descrs, mixerDescrsNum + 1, (mixerDescrsNum == 0) ? REATTACH_TIMEOUT_MS: -1);
+	    if( (res < 0) && (errno != EINTR) )
+		{
+		    writeToLog(string("ERROR: run(): " + string(strerror(errno)) + "\n").c_str(), TAG);
+		    break;
+		}
+	    if(descrs[0].revents & POLLIN)
+		break;
+	    if(res > 0)
+		{
+		    const uint64_t start = TRACE_START();
+		    backend_->handleEvents(descrs + 1, mixerDescrsNum);
+		    traceSpan("snd:events", -1, -1, start);
+		}
+	}
+}
+
+/**
+ * Stop the connector
  */
-void SndConnector::setArrivedDataStr(const string &str)
+void SndConnector::stop()
 {
-    mutex_.lock();
-    dataStr_ = str;
-    mutex_.unlock();
+    const uint64_t one = 1;
+    if( (stopEvent_ >= 0) && (write(stopEvent_, &one, sizeof(one)) < 0) )
+	writeToLog(string("ERROR: Can't signal the stop event: " + string(strerror(errno)) + "\n").c_str(), TAG);
 }
 
 /**
- * Receive data from the connector
- * @return The data string 
+ * Push the notifications of the changed volume or mute state into the commands queue.
+ * Called by the sound backend when the mixer's state has changed
+ * @param volume The current volume percents
+ * @param muted Is the sound state muted
+ * @param context The pointer to the connector instance
  */
-const string SndConnector::receive()
+void SndConnector::onSoundChanged(const long volume, const bool muted, void *context)
 {
-    string str(dataStr_);
-    dataStr_ = "";
-    return str;
+    SndConnector *connector = static_cast<SndConnector*>(context);
+    connector->cachedVolume_ = volume;
+    if(connector->commandsQueue_ == NULL)
+	return;
+
+    if(volume != connector->notifiedVolume_)
+	{
+	    connector->notifiedVolume_ = volume;
+	    connector->commandsQueue_->pushNotification(connector, string(VOL_CHANGED) + " " + to_string(volume));
+	}
+    if(muted != connector->notifiedMuted_)
+	{
+	    connector->notifiedMuted_ = muted;
+	    connector->commandsQueue_->pushNotification(connector, muted ? MUTED: UNMUTED);
+	}
 }
 
 /**
  * Mute the sound system volume
+ * @return true The sound system volume is muted
  */
-void SndConnector::doMute()
+const bool SndConnector::doMute()
 {
-    writeToLog(string("Execute mute\n").c_str(), TAG);
-    mute();
-    setArrivedDataStr(OK);
+    LOG_DEBUG("Execute mute\n", TAG);
+    const uint64_t start = TRACE_START();
+    const bool res = backend_->mute();
+    traceRequestSpan("snd:mute", start);
+    return res;
 }
 
 /**
  * Unmute the sound system volume
+ * @return true The sound system volume is unmuted
  */
-void SndConnector::doUnmute()
+const bool SndConnector::doUnmute()
 {
-    writeToLog(string("Execute unmute\n").c_str(), TAG);
-    unmute();
-    setArrivedDataStr(OK);
+    LOG_DEBUG("Execute unmute\n", TAG);
+    const uint64_t start = TRACE_START();
+    const bool res = backend_->unmute();
+    traceRequestSpan("snd:unmute", start);
+    return res;
 }
 
 /**
  * Change the sound system volume to the given value
  * @param value The value in percent
+ * @return true The volume has been changed
+ */
+const bool SndConnector::doChgVol(const int value)
+{
+    LOG_DEBUG(string("Change volume by value " + to_string(value) + "\n").c_str(), TAG);
+    const uint64_t start = TRACE_START();
+    const bool res = backend_->chgVol(value);
+    traceRequestSpan("snd:chg_vol", start);
+    return res;
+}
+
+/**
+ * Set the sound system volume to the given value
+ * @param value The value in percent
+ * @return true The volume has been set
  */
-void SndConnector::doChgVol(const int value)
+const bool SndConnector::doSetVol(const int value)
 {
-    writeToLog(string("Change volume by value " + to_string(value) + "\n").c_str(), TAG);
-    chgVol(value);
-    setArrivedDataStr(OK);
+    LOG_DEBUG(string("Set volume to value " + to_string(value) + "\n").c_str(), TAG);
+    const uint64_t start = TRACE_START();
+    const bool res = backend_->setVol(value);
+    traceRequestSpan("snd:set_vol", start);
+    return res;
 }
 
 /**
@@ -98,9 +205,21 @@ void SndConnector::doChgVol(const int value)
  */
 const string SndConnector::doGetVol()
 {
-    writeToLog(string("Get current volume\n").c_str(), TAG);
-    const long vol = getVol();
-    return to_string(vol);
+    LOG_DEBUG("Get current volume\n", TAG);
+    const uint64_t start = TRACE_START();
+    const long volume = backend_->getVol();
+    traceRequestSpan("snd:get_vol", start);
+    cachedVolume_ = volume;
+    return to_string(volume);
+}
+
+/**
+ * Get the last known value (in percent) of the sound system volume without calling the mixer
+ * @return The string of the last known volume value
+ */
+const string SndConnector::getCachedVol() const
+{
+    return to_string(cachedVolume_.load());
 }
 
 /**
@@ -109,7 +228,10 @@ const string SndConnector::doGetVol()
  */
 const string SndConnector::doIsMuted()
 {
-    writeToLog(string("Check is muted?\n").c_str(), TAG);
-    return (isMuted()) ? TRUE_: FALSE_;
+    LOG_DEBUG("Check is muted?\n", TAG);
+    const uint64_t start = TRACE_START();
+    const bool muted = backend_->isMuted();
+    traceRequestSpan("snd:is_muted", start);
+    return muted ? TRUE_: FALSE_;
 }
 
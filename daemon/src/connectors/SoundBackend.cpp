@@ -0,0 +1,108 @@
+/**
+ * @file
+ * The selection of the sound system's mixer
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "SoundBackend.h"
+#include "AlsaSoundBackend.h"
+#include "MemSoundBackend.h"
+
+extern "C" {
+	#include <stdlib.h>
+	#include <ctype.h>
+	#include <errno.h>
+}
+
+#define ALSA_BACKEND "alsa"                 /**< The name of the ALSA backend */
+#define MEM_BACKEND  "mem"                  /**< The name of the in-memory backend */
+#define MAX_MEM_LATENCY_US 1000000          /**< The maximal latency of the in-memory backend in microseconds */
+
+using namespace std;
+
+string SoundBackend::selected_ = ALSA_BACKEND;
+
+/**
+ * Parse the description of the backend
+ * @param description The name of the backend: "alsa" or "mem[:LATENCY_US]"
+ * @param isMem Is it the in-memory backend
+ * @param latencyUs The latency of the in-memory backend, the decimal digits of 0..MAX_MEM_LATENCY_US
+ * @return true The description is valid
+ */
+bool parseBackendDescription(const string &description, bool &isMem, unsigned int &latencyUs)
+{
+    isMem     = false;
+    latencyUs = 0;
+    if(description == ALSA_BACKEND)
+	return true;
+
+    const size_t colonPos = description.find(':');
+    if(description.substr(0, colonPos) != MEM_BACKEND)
+	return false;
+    isMem = true;
+    if(colonPos == string::npos)
+	return true;
+
+    const char *latencyStr = description.c_str() + colonPos + 1;
+    if(!isdigit((unsigned char) *latencyStr))   // strtoul() accepts the spaces and the negative numbers
+	return false;
+    char *end = NULL;
+    errno = 0;
+    const unsigned long latency = strtoul(latencyStr, &end, 10);
+    if( (*end != '\0') || (errno != 0) || (latency > MAX_MEM_LATENCY_US) )
+	return false;
+    latencyUs = latency;
+    return true;
+}
+
+/**
+ * Select the backend created by create()
+ * @param description The name of the backend: "alsa" or "mem[:LATENCY_US]",
+ *        where LATENCY_US is the delay of 0..1000000 microseconds added to every operation of the in-memory mixer
+ * @return true The description is valid
+ */
+bool SoundBackend::select(const string &description)
+{
+    bool isMem;
+    unsigned int latencyUs;
+    if(!parseBackendDescription(description, isMem, latencyUs))
+	return false;
+    selected_ = description;
+    return true;
+}
+
+/**
+ * Create the selected backend, the ALSA one if nothing has been selected
+ * @return The backend, it should be deleted by the caller
+ */
+SoundBackend* SoundBackend::create()
+{
+    bool isMem;
+    unsigned int latencyUs;
+    parseBackendDescription(selected_, isMem, latencyUs);
+    if(isMem)
+	return new MemSoundBackend(latencyUs);
+    return new AlsaSoundBackend();
+}
@@ -40,38 +40,58 @@
 #include "CommandGetConnectedIP.h"
 #include "CommandGetLocalIP.h"
 #include "CommandChgVol.h"
+#include "CommandSetVol.h"
 #include "CommandHello.h"
 #include "CommandGetCurVol.h"
+#include "CommandLogLevel.h"
+#include "CommandStats.h"
+#include "CommandTrace.h"
 
 
 #include <algorithm>
+#include <chrono>
 #include <thread>
 #include <list>
 #include <sstream>
 
 extern "C" {
 	#include "Log.h"
+	#include "Trace.h"
 	#include <sys/msg.h>
+	#include <string.h>
+	#include <stdlib.h>
 }
 
+#define COMMAND_STR_BUFF_LEN 256       /**< The length of the buffer the command's string is parsed in */
+#define MAX_COALESCED_VOL_CHANGE 100   /**< The maximal absolute value of the coalesced volume change, so the sum of a batch's changes fits int */
+
+/**
+ * The case of the command's name in the switch by the names' hash
+ */
+#define COMMAND_NAME_CASE(NAME) case hashCommandName(NAME, sizeof(NAME) - 1): opcode = NAME##_OPCODE; break
+
 const char* CommandsDispatcher::TAG = "COMMANDS_DISPATCHER";   /**< The for writing to log file */
 
+const char* CommandsDispatcher::commandsNames_[] = COMMANDS_NAMES_BY_OPCODES;   /**< The names of the commands indexed by their opcodes */
+
 /**
  * Initialize commands instances
  */
 void CommandsDispatcher::initCommands()
 {
-	commands_ = map<string, Command*>();
-
-	commands_[HELLO]        = new CommandHello(*netConnector_);
-	commands_[LOCAL_IP]     = new CommandGetLocalIP(*netConnector_);
-	commands_[CONNECTED_IP] = new CommandGetConnectedIP(*netConnector_);
-	commands_[IS_MUTED]     = new CommandIsMuted(*sndConnector_);
-	commands_[MUTE]         = new CommandMute(*sndConnector_);
-	commands_[UNMUTE]       = new CommandUnMute(*sndConnector_);
-	commands_[CHG_VOL]      = new CommandChgVol(*sndConnector_);
-	commands_[GET_VOL]      = new CommandGetCurVol(*sndConnector_);
-	commands_[QUIT]         = new CommandQuit(*this);
+	commands_[HELLO_OPCODE]        = new CommandHello(*netConnector_);
+	commands_[LOCAL_IP_OPCODE]     = new CommandGetLocalIP(*netConnector_);
+	commands_[CONNECTED_IP_OPCODE] = new CommandGetConnectedIP(*netConnector_, netClientID_);
+	commands_[IS_MUTED_OPCODE]     = new CommandIsMuted(*sndConnector_);
+	commands_[MUTE_OPCODE]         = new CommandMute(*sndConnector_);
+	commands_[UNMUTE_OPCODE]       = new CommandUnMute(*sndConnector_);
+	commands_[CHG_VOL_OPCODE]      = new CommandChgVol(*sndConnector_);
+	commands_[SET_VOL_OPCODE]      = new CommandSetVol(*sndConnector_);
+	commands_[GET_VOL_OPCODE]      = new CommandGetCurVol(*sndConnector_);
+	commands_[QUIT_OPCODE]         = new CommandQuit(*this);
+	commands_[LOG_LEVEL_OPCODE]    = new CommandLogLevel();
+	commands_[STATS_OPCODE]        = new CommandStats(metrics_);
+	commands_[TRACE_OPCODE]        = new CommandTrace();
 }
 
 /**
@@ -79,19 +99,22 @@ void CommandsDispatcher::initCommands()
  */
 void CommandsDispatcher::delCommands()
 {
-    for( auto it=commands_.begin(); it!=commands_.end(); ++it)
+    for(int opcode = 0; opcode < COMMANDS_OPCODES_NUM; ++opcode)
 	{
-	    delete it->second;
+	    delete commands_[opcode];
+	    commands_[opcode] = NULL;
 	}
 }
 
 /**
  * Destructor
+ * The connectors are stopped before joining their threads, as the dispatcher may be deleted without having been started
  */
 CommandsDispatcher::~CommandsDispatcher()
 {
     delCommands();
     delete mutex_;    
+    stopConnectors();
     delThreads();
     delConnectors();
     
@@ -114,6 +137,12 @@ void CommandsDispatcher::delThreads()
 	    thNetConnector_->join();
 	    delete thNetConnector_;
 	}
+
+    if(thSndConnector_ != NULL)
+	{
+	    thSndConnector_->join();
+	    delete thSndConnector_;
+	}
 }
 
 /**
@@ -136,55 +165,252 @@ void CommandsDispatcher::stopConnectors() const
 }
 
 /**
- * Parse the given command string into command name and parameters if there are ones
- * @param str The string of the command
- * @return The list of the name of the command and its parameters
+ * Make the connectors push the arrived commands into the commands queue.
+ * The metrics of the connectors are recorded from here on
+ */
+void CommandsDispatcher::subscribeConnectors()
+{
+    for(auto it = connectors_.begin(); it != connectors_.end(); ++it)
+	{
+	    if(*it == netConnector_)
+		metrics_.addConnector("net", *it);
+	    else if(*it == guiConnector_)
+		metrics_.addConnector("gui", *it);
+	    else if(*it == sndConnector_)
+		metrics_.addConnector("snd", *it);
+	    (*it)->setCommandsQueue(&commandsQueue_);
+	}
+    commandsQueue_.setMetrics(&metrics_);
+}
+
+/**
+ * Send the given notification to the clients of all the connectors
+ * @param notification The string of the notification
  */
-const list<string> CommandsDispatcher::parseCommandStr(const string &str) const
+void CommandsDispatcher::notifyConnectors(const string &notification) const
 {
-	istringstream iss(str, istringstream::in);
-	list<string> words;
-	string word;
-	while(iss >> word)
-		words.push_back(word);
-	return words;
+    for(auto it = connectors_.begin(); it != connectors_.end(); ++it)
+	{
+	    (*it)->notify(notification);
+	    metrics_.recordSent(*it, notification.size());
+	}
 }
 
 /**
- * Execute the command by given string of the command
+ * Parse the given command string into command name and parameters if there are ones.
+ * The words of the string are terminated in place, nothing is copied
+ * @param str The buffer of the command's string
+ * @param name The name of the command
+ * @param params The parameters of the command
+ * @return false The string is empty or has too many parameters
+ */
+bool CommandsDispatcher::parseCommandStr(char *str, const char* &name, CommandParams &params) const
+{
+	static const char *SPACES = " \t\r\n";
+
+	name = NULL;
+	params.num = 0;
+	for(char *word = str + strspn(str, SPACES); *word != '\0'; word += strspn(word, SPACES))
+	{
+		if(name == NULL)
+			name = word;
+		else if(params.num < COMMAND_PARAMS_MAX_NUM)
+			params.strs[params.num++] = word;
+		else
+			return false;
+
+		word += strcspn(word, SPACES);
+		if(*word != '\0')
+			*word++ = '\0';
+	}
+	return name != NULL;
+}
+
+/**
+ * Get the opcode of the command with the given name by one probe of the names' hash.
+ * The names' hashes are the labels of the switch, so the compiler rejects the names having the same hash
+ * @param name The name of the command
+ * @param len The length of the name
+ * @return The opcode or NO_OPCODE if there is no command with the given name
+ */
+int CommandsDispatcher::getCommandOpcode(const char *name, const size_t len)
+{
+	int opcode = NO_OPCODE;
+	switch(hashCommandName(name, len))
+	{
+		COMMAND_NAME_CASE(HELLO);
+		COMMAND_NAME_CASE(GET_PORT);
+		COMMAND_NAME_CASE(CHG_PORT);
+		COMMAND_NAME_CASE(MUTE);
+		COMMAND_NAME_CASE(IS_MUTED);
+		COMMAND_NAME_CASE(UNMUTE);
+		COMMAND_NAME_CASE(LOCAL_IP);
+		COMMAND_NAME_CASE(CONNECTED_IP);
+		COMMAND_NAME_CASE(QUIT);
+		COMMAND_NAME_CASE(CHG_VOL);
+		COMMAND_NAME_CASE(GET_VOL);
+		COMMAND_NAME_CASE(LOG_LEVEL);
+		COMMAND_NAME_CASE(SET_VOL);
+		COMMAND_NAME_CASE(STATS);
+		COMMAND_NAME_CASE(TRACE);
+		default:
+			return NO_OPCODE;
+	}
+	const char *opcodeName = commandsNames_[opcode];
+	return ( (strncmp(opcodeName, name, len) == 0) && (opcodeName[len] == '\0') ) ? opcode: NO_OPCODE;
+}
+
+/**
+ * Execute the command by given string of the command.
+ * The spans of the command and of its sound operations are traced with the IDs of the client's request
  * @param command The command's string containing the command's name and parameters
+ * @param clientID The ID of the client the command has arrived from
+ * @param requestID The ID of the client's request
  * @return The execution result string, "ERR" or "OK"
  */
-const string CommandsDispatcher::execCommand(const string& command) const
+const string CommandsDispatcher::execCommand(const string& command, const int clientID, const int requestID) const
 {
 	if(command.empty())
 	{
 		writeToLog(string("ERROR: execCommand(): The given command is empty\n").c_str(), TAG);
 		return ERR;
 	}
+	if(command.length() >= COMMAND_STR_BUFF_LEN)
+	{
+		writeToLog(string("ERROR: execCommand(): The given command '" + command + "' is too long\n").c_str(), TAG);
+		return ERR;
+	}
 
-	list<string> commandList = parseCommandStr(command);  // list: {command_name, parameter, parameter, ...}
-	if(commandList.empty())
+	char str[COMMAND_STR_BUFF_LEN];
+	memcpy(str, command.c_str(), command.length() + 1);
+
+	const char *name = NULL;
+	CommandParams params;
+	if(!parseCommandStr(str, name, params))
 	{
 		writeToLog(string("ERROR: execCommand(): Can't parse the given command '" + command + "'\n").c_str(), TAG);
 		return ERR;
 	}
 
-	auto commandIt = commandList.begin();
-	string name = *commandIt;
+	const int opcode = getCommandOpcode(name, strlen(name));
+	if( (opcode == NO_OPCODE) || (commands_[opcode] == NULL) )
+	{
+		writeToLog(string("ERROR: execCommand(): The command '" + command + "' doesn't exist\n").c_str(), TAG);
+		return ERR;
+	}
+
+	setTraceRequest(clientID, requestID);
+	const uint64_t traceStart = TRACE_START();
+	const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	const string res = (params.num == 0) ? commands_[opcode]->execute():   // command without params
+		                               commands_[opcode]->execute(params);
+	const chrono::microseconds latency = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+	traceSpan(commandsNames_[opcode], clientID, requestID, traceStart);
+	clearTraceRequest();
+	metrics_.recordCommand(opcode, latency.count(), res == ERR);
+	return res;
+}
+
+/**
+ * Split the given batch string into the strings of its commands
+ * @param batch The string of the batch
+ * @return The list of the non empty commands' strings
+ */
+const list<string> CommandsDispatcher::splitBatchStr(const string &batch) const
+{
+	list<string> commands;
+	istringstream iss(batch, istringstream::in);
+	string command;
+	while(getline(iss, command, BATCH_SEPARATOR))
+	{
+		if(command.find_first_not_of(" \t\r\n") != string::npos)
+			commands.push_back(command);
+	}
+	return commands;
+}
+
+/**
+ * Get the volume change of the given command if it's the command changing the volume
+ * by a value not exceeding MAX_COALESCED_VOL_CHANGE
+ * @param command The command's string
+ * @param value The value of the volume change
+ * @return true The command changes the volume by a valid value
+ */
+bool CommandsDispatcher::getVolChange(const string &command, int &value) const
+{
+	if(command.length() >= COMMAND_STR_BUFF_LEN)
+		return false;
 
-	map<string, Command*>::const_iterator it = commands_.find(name);
-    if(it == commands_.end())
-    {
-	writeToLog(string("ERROR: execCommand(): The command '" + command + "' doesn't exist\n").c_str(), TAG);
-        return ERR;
-    }
+	char str[COMMAND_STR_BUFF_LEN];
+	memcpy(str, command.c_str(), command.length() + 1);
 
-    if(commandList.size() == 1)   // command without params
-    	return (*it).second->execute();
+	const char *name = NULL;
+	CommandParams params;
+	if( !parseCommandStr(str, name, params) || (params.num != 1) ||
+	    (getCommandOpcode(name, strlen(name)) != CHG_VOL_OPCODE) )
+		return false;
 
-    commandList.pop_front();      // drop the command's name
-    return (*it).second->execute(commandList);
+	char *end = NULL;
+	const long change = strtol(params.strs[0], &end, 10);
+	if( (end == params.strs[0]) || (*end != '\0') ||
+	    (change < -MAX_COALESCED_VOL_CHANGE) || (change > MAX_COALESCED_VOL_CHANGE) )
+		return false;
+	value = change;
+	return true;
+}
+
+/**
+ * Execute the batch of commands separated by BATCH_SEPARATOR one after another.
+ * The consecutive commands changing the volume are coalesced into one change,
+ * so the mixer is written once and the change has one result.
+ * The batch longer than MAX_BATCH_LEN isn't executed and the results longer than it aren't sent,
+ * both are answered by "ERR" instead of a truncated string
+ * @param batch The string of the batch
+ * @param clientID The ID of the client the batch has arrived from
+ * @param requestID The ID of the client's request
+ * @return The results of the executed commands separated by BATCH_SEPARATOR
+ */
+const string CommandsDispatcher::execBatch(const string& batch, const int clientID, const int requestID) const
+{
+	if(batch.find(BATCH_SEPARATOR) == string::npos)
+		return execCommand(batch, clientID, requestID);
+
+	if(batch.size() > MAX_BATCH_LEN)
+	{
+		writeToLog(string("ERROR: execBatch(): The given batch '" + batch + "' is too long\n").c_str(), TAG);
+		return ERR;
+	}
+
+	list<string> commands = splitBatchStr(batch);
+	if(commands.empty())
+	{
+		writeToLog(string("ERROR: execBatch(): There are no commands in the given batch '" + batch + "'\n").c_str(), TAG);
+		return ERR;
+	}
+
+	string results;
+	for(auto it = commands.begin(); it != commands.end(); )
+	{
+		int volChange = 0;
+		string command = *it++;
+		if(getVolChange(command, volChange))
+		{
+			int value = 0;
+			for( ; (it != commands.end()) && getVolChange(*it, value); ++it)
+				volChange += value;
+			command = string(CHG_VOL) + " " + to_string(volChange);
+		}
+		if(!results.empty())
+			results += BATCH_SEPARATOR;
+		results += execCommand(command, clientID, requestID);
+	}
+	if(results.size() > MAX_BATCH_LEN)
+	{
+		writeToLog(string("ERROR: execBatch(): The results of the batch '" + batch + "' are too long: " + results + "\n").c_str(), TAG);
+		return ERR;
+	}
+	LOG_DEBUG(string("The batch '" + batch + "' has been executed: " + results + "\n").c_str(), TAG);
+	return results;
 }
 
 /**
@@ -195,6 +421,8 @@ void CommandsDispatcher::stop()
 	mutex_->lock();
 	shouldStop_ = true;
 	mutex_->unlock();
+
+	commandsQueue_.stop();
 }
 
 /**
@@ -213,22 +441,30 @@ bool CommandsDispatcher::isStopped()
 
 /**
  * Start the dispatcher
+ * It waits for the commands pushed by connectors, executes them and sends
+ * the results back to the clients the commands arrived from.
+ * The notifications are sent to the clients of all the connectors
  */
 void CommandsDispatcher::start()
 {
-    while(!isStopped())
+    setTraceThreadName("dispatcher");
+    QueuedCommand newCommand;
+    while(!isStopped() && commandsQueue_.pop(newCommand))
 	{
-	    string newCommand;
-	    for(Connector* connector: connectors_)
+	    traceSpan("queue_wait", newCommand.clientID, newCommand.requestID, newCommand.queuedTime);
+	    const uint64_t start = TRACE_START();
+	    if(newCommand.isNotification)
 		{
-		    newCommand = connector->receive();
-		    if(!newCommand.empty())
-			{
-			    const string res = execCommand(newCommand);
-			    connector->send(res);
-			}			
-		    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		    notifyConnectors(newCommand.command);
+		    traceSpan("notify", newCommand.clientID, newCommand.requestID, start);
+		    continue;
 		}
+	    netClientID_ = (newCommand.connector == netConnector_) ? newCommand.clientID: -1;
+	    const string res = execBatch(newCommand.command, newCommand.clientID, newCommand.requestID);
+	    netClientID_ = -1;
+	    newCommand.connector->send(res, newCommand.clientID, newCommand.requestID);
+	    metrics_.recordSent(newCommand.connector, res.size());
+	    traceSpan("dispatch", newCommand.clientID, newCommand.requestID, start);
 	}
 
 	stopConnectors();
@@ -74,6 +74,7 @@ void CommandsDispatcherBT::initThreads()
 {
     thNetConnector_  = new thread(&NetConnector::run, netConnector_);
     thGuiConnector_  = new thread(&GuiConnector::run, guiConnector_);
+    thSndConnector_  = new thread(&SndConnector::run, sndConnector_);
 }
 
 /**
@@ -90,6 +91,8 @@ void CommandsDispatcherBT::initConnectors(const string &portNum) throw(GuiExcept
 
 	sndConnector_ = new SndConnector();
 	connectors_.push_back(sndConnector_);
+
+	subscribeConnectors();
 }
 
 /**
@@ -42,8 +42,11 @@ const char* CommandsDispatcherWiFi::TAG = "WIFI_COMMANDS_DISPATCHER";         /*
 /**
  * Constructor
  * @param portNum The number of port string
+ * @param volPortNum The number of port string of the volume's datagrams or "" if they aren't received
+ * @param discoveryPortNum The number of port string of the discovery probes or "" if they aren't answered
  */
-CommandsDispatcherWiFi::CommandsDispatcherWiFi(string &portNum) throw(PortException, GuiException)
+CommandsDispatcherWiFi::CommandsDispatcherWiFi(string &portNum, const string &volPortNum, const string &discoveryPortNum) throw(PortException, GuiException):
+    volPortNum_(volPortNum), discoveryPortNum_(discoveryPortNum)
 {
     openLogFile(LOG_FILE_NAME);
     shouldStop_ = false;
@@ -99,12 +102,12 @@ const bool CommandsDispatcherWiFi::restartNetConnector(const string &portNum)
 {
 	if(thNetConnector_ == NULL)
 	{
-		writeToLog("WARNING: restartNetConnector(): the net connector instance is NULL", TAG);
+		LOG_WARN("WARNING: restartNetConnector(): the net connector instance is NULL", TAG);
 		return false;
 	}
 	if(portNum.empty())
 	{
-		writeToLog("WARNING: restartNetConnector(): the given port number string is empty", TAG);
+		LOG_WARN("WARNING: restartNetConnector(): the given port number string is empty", TAG);
 		return false;
 	}
 
@@ -132,6 +135,7 @@ void CommandsDispatcherWiFi::initThreads() throw(PortException)
 	}
 	thNetConnector_  = new thread(&NetConnector::run, netConnector_);
 	thGuiConnector_  = new thread(&GuiConnector::run, guiConnector_);
+	thSndConnector_  = new thread(&SndConnector::run, sndConnector_);
 }
 
 /**
@@ -140,7 +144,8 @@ void CommandsDispatcherWiFi::initThreads() throw(PortException)
  */
 void CommandsDispatcherWiFi::initConnectors(const string &portNum) throw(PortException, GuiException)
 {
-	netConnector_ = new ConnectorWiFi(portNum);
+	ConnectorWiFi *connectorWiFi = new ConnectorWiFi(portNum, volPortNum_, discoveryPortNum_);
+	netConnector_ = connectorWiFi;
 	connectors_.push_back(netConnector_);
 	
 	guiConnector_ = new GuiConnector();
@@ -148,6 +153,12 @@ void CommandsDispatcherWiFi::initConnectors(const string &portNum) throw(PortExc
 
 	sndConnector_ = new SndConnector();
 	connectors_.push_back(sndConnector_);
+
+	SndConnector *sndConnector = sndConnector_;
+	// the discovery is answered by the net thread, so it mustn't wait for the mixer
+	connectorWiFi->setDiscoveryInfoProvider([sndConnector]() { return string("vol=") + sndConnector->getCachedVol(); });
+
+	subscribeConnectors();
 }
 
 /**
@@ -156,6 +167,6 @@ void CommandsDispatcherWiFi::initConnectors(const string &portNum) throw(PortExc
 void CommandsDispatcherWiFi::initCommands()
 {
     CommandsDispatcher::initCommands();
-    commands_[GET_PORT]     = new CommandGetPort(*netConnector_);
-    commands_[CHG_PORT]     = new CommandChangePort(*this);
+    commands_[GET_PORT_OPCODE] = new CommandGetPort(*netConnector_);
+    commands_[CHG_PORT_OPCODE] = new CommandChangePort(*this);
 }
@@ -0,0 +1,108 @@
+/**
+ * @file
+ * The queue of commands arrived from connectors.
+ * Connectors push the arrived commands into the queue, the dispatcher
+ * blocks on the queue until there is a command for execution
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "CommandsQueue.h"
+#include "Metrics.h"
+
+extern "C" {
+#include "Trace.h"
+}
+
+using namespace std;
+
+/**
+ * Push the given command into the queue and wake up the waiting consumer
+ * @param connector The connector the command arrived from
+ * @param clientID The ID of the connector's client the command arrived from
+ * @param command The string of the command
+ * @param requestID The ID of the client's request, -1 if the request has no ID
+ */
+void CommandsQueue::push(Connector *connector, const int clientID, const string &command, const int requestID)
+{
+    {
+	lock_guard<mutex> lock(mutex_);
+	if(stopped_)
+	    return;
+	commands_.push_back(QueuedCommand{connector, clientID, requestID, command, false, TRACE_START()});
+	if(metrics_ != NULL)
+	    metrics_->recordQueued(connector, command.size());
+    }
+    hasCommands_.notify_one();
+}
+
+/**
+ * Push the given notification into the queue and wake up the waiting consumer
+ * @param connector The connector the notification arrived from
+ * @param notification The string of the notification
+ */
+void CommandsQueue::pushNotification(Connector *connector, const string &notification)
+{
+    {
+	lock_guard<mutex> lock(mutex_);
+	if(stopped_)
+	    return;
+	commands_.push_back(QueuedCommand{connector, 0, -1, notification, true, TRACE_START()});
+	if(metrics_ != NULL)
+	    metrics_->recordQueued(connector, 0);
+    }
+    hasCommands_.notify_one();
+}
+
+/**
+ * Wait until there is a command in the queue and pop it
+ * @param item The popped command
+ * @return false The queue has been stopped, there is no command for execution
+ */
+bool CommandsQueue::pop(QueuedCommand &item)
+{
+    unique_lock<mutex> lock(mutex_);
+    hasCommands_.wait(lock, [this] { return stopped_ || !commands_.empty(); });
+    if(stopped_)
+	return false;
+
+    item = commands_.front();
+    commands_.pop_front();
+    if(metrics_ != NULL)
+	metrics_->recordDequeued(item.connector);
+    return true;
+}
+
+/**
+ * Stop the queue and wake up the waiting consumer
+ */
+void CommandsQueue::stop()
+{
+    {
+	lock_guard<mutex> lock(mutex_);
+	stopped_ = true;
+	commands_.clear();
+    }
+    hasCommands_.notify_all();
+}
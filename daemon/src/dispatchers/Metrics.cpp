@@ -0,0 +1,269 @@
+/**
+ * @file
+ * The metrics of the executed commands and of the connectors
+ *
+ **
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Daniel Haimov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+#define MAX_HISTOGRAM_VALUE 0xFFFFFFFFull        /**< The bigger values are counted by the last bucket */
+
+/**
+ * Increase the given maximum up to the given value
+ * @param maximum The maximum
+ * @param value The value
+ */
+template <typename T> void updateMax(atomic<T> &maximum, const T value)
+{
+    T current = maximum.load(memory_order_relaxed);
+    while( (value > current) && !maximum.compare_exchange_weak(current, value, memory_order_relaxed) )
+	;
+}
+
+/**
+ * Constructor
+ */
+LatencyHistogram::LatencyHistogram(): count_(0), max_(0)
+{
+    for(size_t i = 0; i < HISTOGRAM_BUCKETS_NUM; i++)
+	buckets_[i].store(0, memory_order_relaxed);
+}
+
+/**
+ * Get the index of the bucket of the given value
+ * @param value The value
+ * @return The index of the bucket
+ */
+size_t LatencyHistogram::getBucketIndex(const uint64_t value)
+{
+    const uint64_t limited = min<uint64_t>(value, MAX_HISTOGRAM_VALUE);
+    if(limited < 2 * HISTOGRAM_SUB_BUCKETS_NUM)
+	return limited;
+
+    const size_t highestBit = 63 - __builtin_clzll(limited);
+    const size_t shift = highestBit - 4;
+    return 2 * HISTOGRAM_SUB_BUCKETS_NUM + (highestBit - 5) * HISTOGRAM_SUB_BUCKETS_NUM + ((limited >> shift) - HISTOGRAM_SUB_BUCKETS_NUM);
+}
+
+/**
+ * Get the highest value counted by the bucket with the given index
+ * @param index The index of the bucket
+ * @return The highest value of the bucket
+ */
+uint64_t LatencyHistogram::getBucketValue(const size_t index)
+{
+    if(index < 2 * HISTOGRAM_SUB_BUCKETS_NUM)
+	return index;
+
+    const size_t octave = (index - 2 * HISTOGRAM_SUB_BUCKETS_NUM) / HISTOGRAM_SUB_BUCKETS_NUM;
+    const size_t subBucket = (index - 2 * HISTOGRAM_SUB_BUCKETS_NUM) % HISTOGRAM_SUB_BUCKETS_NUM;
+    return (static_cast<uint64_t>(HISTOGRAM_SUB_BUCKETS_NUM + subBucket + 1) << (octave + 1)) - 1;
+}
+
+/**
+ * Record the given value
+ * @param value The latency in microseconds
+ */
+void LatencyHistogram::record(const uint64_t value)
+{
+    buckets_[getBucketIndex(value)].fetch_add(1, memory_order_relaxed);
+    count_.fetch_add(1, memory_order_relaxed);
+    updateMax(max_, value);
+}
+
+/**
+ * Get the given percentile of the recorded values.
+ * The buckets are read while the values may be recorded, so the percentile is approximate
+ * @param percent The percent of the percentile
+ * @return The highest value of the bucket having the percentile or 0 if nothing has been recorded
+ */
+uint64_t LatencyHistogram::getPercentile(const double percent) const
+{
+    const uint64_t count = getCount();
+    if(count == 0)
+	return 0;
+
+    const uint64_t rank = max<uint64_t>(static_cast<uint64_t>(ceil(percent / 100 * count)), 1);
+    uint64_t counted = 0;
+    for(size_t i = 0; i < HISTOGRAM_BUCKETS_NUM; i++)
+	{
+	    counted += buckets_[i].load(memory_order_relaxed);
+	    if(counted >= rank)
+		return min(getBucketValue(i), getMax());
+	}
+    return getMax();
+}
+
+/**
+ * Constructor
+ */
+Metrics::Metrics(): connectorsNum_(0), queued_(0), maxQueued_(0)
+{
+    for(size_t i = 0; i < COMMANDS_OPCODES_NUM; i++)
+	errors_[i].store(0, memory_order_relaxed);
+}
+
+/**
+ * Find the metrics of the given connector
+ * @param connector The connector
+ * @return The metrics or NULL if the connector hasn't been added
+ */
+ConnectorMetrics* Metrics::findConnector(const Connector *connector)
+{
+    for(size_t i = 0; i < connectorsNum_; i++)
+	{
+	    if(connectors_[i].connector == connector)
+		return &connectors_[i];
+	}
+    return NULL;
+}
+
+/**
+ * Add the connector whose metrics should be recorded. Should be called before running the connectors
+ * @param name The name of the connector in the statistics
+ * @param connector The connector
+ */
+void Metrics::addConnector(const char *name, Connector *connector)
+{
+    if( (connectorsNum_ == MAX_METRICS_CONNECTORS_NUM) || (findConnector(connector) != NULL) )
+	return;
+
+    ConnectorMetrics &metrics = connectors_[connectorsNum_++];
+    metrics.name      = name;
+    metrics.connector = connector;
+    metrics.receivedBytes.store(0, memory_order_relaxed);
+    metrics.sentBytes.store(0, memory_order_relaxed);
+    metrics.queued.store(0, memory_order_relaxed);
+    metrics.maxQueued.store(0, memory_order_relaxed);
+}
+
+/**
+ * Record the execution of the command
+ * @param opcode The opcode of the command
+ * @param latency The time of the execution in microseconds
+ * @param isError Has the command returned ERR
+ */
+void Metrics::recordCommand(const int opcode, const uint64_t latency, const bool isError)
+{
+    if( (opcode < 0) || (opcode >= COMMANDS_OPCODES_NUM) )
+	return;
+
+    latencies_[opcode].record(latency);
+    if(isError)
+	errors_[opcode].fetch_add(1, memory_order_relaxed);
+}
+
+/**
+ * Record the command arrived from the connector and waiting for execution.
+ * It's called while the commands queue is locked, as recordDequeued(), so the numbers of the queued commands aren't negative
+ * @param connector The connector
+ * @param bytes The length of the command
+ */
+void Metrics::recordQueued(const Connector *connector, const size_t bytes)
+{
+    updateMax(maxQueued_, queued_.fetch_add(1, memory_order_relaxed) + 1);
+
+    ConnectorMetrics *metrics = findConnector(connector);
+    if(metrics == NULL)
+	return;
+    metrics->receivedBytes.fetch_add(bytes, memory_order_relaxed);
+    updateMax(metrics->maxQueued, metrics->queued.fetch_add(1, memory_order_relaxed) + 1);
+}
+
+/**
+ * Record the command of the connector taken for execution
+ * @param connector The connector
+ */
+void Metrics::recordDequeued(const Connector *connector)
+{
+    queued_.fetch_sub(1, memory_order_relaxed);
+
+    ConnectorMetrics *metrics = findConnector(connector);
+    if(metrics != NULL)
+	metrics->queued.fetch_sub(1, memory_order_relaxed);
+}
+
+/**
+ * Record the reply or the notification sent to the connector
+ * @param connector The connector
+ * @param bytes The length of the reply
+ */
+void Metrics::recordSent(const Connector *connector, const size_t bytes)
+{
+    ConnectorMetrics *metrics = findConnector(connector);
+    if(metrics != NULL)
+	metrics->sentBytes.fetch_add(bytes, memory_order_relaxed);
+}
+
+/**
+ * Get the statistics of the command or of the connector with the given name.
+ * The statistics of a command: the number of the executions, the number of ERR results, p50, p99, p999 and max latency in microseconds.
+ * The statistics of a connector: the received bytes, the sent bytes, the number of the queued commands and its maximum.
+ * The numbers are separated by spaces, so the statistics fit the length of a reply
+ * @param name The name of the command or of the connector, the totals of all the commands if it's empty:
+ *        the number of the executions, the number of ERR results, the number of the queued commands and its maximum
+ * @return The statistics or the empty string if there is nothing with the given name
+ */
+string Metrics::getStats(const string &name) const
+{
+    static const char* commandsNames[] = COMMANDS_NAMES_BY_OPCODES;
+
+    if(name.empty())
+	{
+	    uint64_t count = 0, errors = 0;
+	    for(size_t i = 0; i < COMMANDS_OPCODES_NUM; i++)
+		{
+		    count  += latencies_[i].getCount();
+		    errors += errors_[i].load(memory_order_relaxed);
+		}
+	    return to_string(count) + " " + to_string(errors) + " " + to_string(queued_.load(memory_order_relaxed)) +
+		" " + to_string(maxQueued_.load(memory_order_relaxed));
+	}
+
+    for(size_t i = 0; i < COMMANDS_OPCODES_NUM; i++)
+	{
+	    if( (commandsNames[i] == NULL) || (name != commandsNames[i]) )
+		continue;
+	    const LatencyHistogram &latencies = latencies_[i];
+	    return to_string(latencies.getCount()) + " " + to_string(errors_[i].load(memory_order_relaxed)) + " " +
+		to_string(latencies.getPercentile(50)) + " " + to_string(latencies.getPercentile(99)) + " " +
+		to_string(latencies.getPercentile(99.9)) + " " + to_string(latencies.getMax());
+	}
+
+    for(size_t i = 0; i < connectorsNum_; i++)
+	{
+	    const ConnectorMetrics &metrics = connectors_[i];
+	    if(name != metrics.name)
+		continue;
+	    return to_string(metrics.receivedBytes.load(memory_order_relaxed)) + " " + to_string(metrics.sentBytes.load(memory_order_relaxed)) +
+		" " + to_string(metrics.queued.load(memory_order_relaxed)) + " " + to_string(metrics.maxQueued.load(memory_order_relaxed));
+	}
+    return "";
+}
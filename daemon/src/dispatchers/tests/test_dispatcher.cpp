@@ -0,0 +1,222 @@
+#include "CUnit/Basic.h"
+#include "CommandsDispatcher.h"
+#include "CommandsNames.h"
+#include "CommandChgVol.h"
+#include "CommandGetCurVol.h"
+#include "SoundBackend.h"
+
+#include <string>
+#include <list>
+
+extern "C" {
+	#include "Trace.h"
+	#include <string.h>
+	#include <stdio.h>
+}
+
+using namespace std;
+
+#define QUEUE_END "end"                 /**< The command pushed after the tested ones, marks the end of the queue */
+#define CLIENT_ID 3                     /**< The ID of the client of the traced request */
+#define REQUEST_ID 4                    /**< The ID of the traced request */
+#define TRACE_BUFF_LEN 4096             /**< The length of the buffer of the dumped traces */
+
+/**
+ * The dispatcher with the sound connector only, its commands are executed by the test
+ */
+class TestDispatcher: public CommandsDispatcher
+{
+    void initConnectors(const string &portNum) {}
+    void initThreads() {}
+
+ public:
+    TestDispatcher()
+    {
+	netConnector_ = NULL;
+	guiConnector_ = NULL;
+	sndConnector_ = new SndConnector();
+	thNetConnector_ = thGuiConnector_ = thSndConnector_ = NULL;
+	shouldStop_ = false;
+	mutex_ = new mutex();
+
+	connectors_.push_back(sndConnector_);
+	commands_[CHG_VOL_OPCODE] = new CommandChgVol(*sndConnector_);
+	commands_[GET_VOL_OPCODE] = new CommandGetCurVol(*sndConnector_);
+	subscribeConnectors();
+    }
+
+    const bool restartNetConnector(const string &portNum) { return false; }
+
+    const string exec(const string &batch) { return execBatch(batch, CLIENT_ID, REQUEST_ID); }
+
+    const string cachedVol() const { return sndConnector_->getCachedVol(); }
+
+    /**
+     * Get the notifications of the changed volume pushed into the commands queue
+     * @return The list of the notifications' strings
+     */
+    list<string> popVolNotifications()
+    {
+	list<string> notifications;
+	commandsQueue_.push(sndConnector_, 0, QUEUE_END);
+
+	QueuedCommand item;
+	while(commandsQueue_.pop(item) && (item.command != QUEUE_END))
+	    {
+		if(item.isNotification && (item.command.compare(0, strlen(VOL_CHANGED), VOL_CHANGED) == 0))
+		    notifications.push_back(item.command);
+	    }
+	return notifications;
+    }
+};
+
+TestDispatcher *dispatcher = NULL;
+
+int initSuite(void)
+{
+    if(!SoundBackend::select("mem"))
+	return -1;
+    dispatcher = new TestDispatcher();
+    return 0;
+}
+
+int cleanSuite(void)
+{
+    delete dispatcher;
+    return 0;
+}
+
+void testCoalescedVolChanges()
+{
+    dispatcher->popVolNotifications();
+    const long volume = stol(dispatcher->exec(GET_VOL));
+
+    CU_ASSERT_EQUAL(dispatcher->exec("chg_vol 1;chg_vol 2;get_vol"), string(OK) + ";" + to_string(volume + 3));
+
+    list<string> notifications = dispatcher->popVolNotifications();
+    CU_ASSERT_EQUAL(notifications.size(), 1);
+    if(!notifications.empty())
+	CU_ASSERT_EQUAL(notifications.front(), string(VOL_CHANGED) + " " + to_string(volume + 3));
+}
+
+void testSeparatedVolChanges()
+{
+    dispatcher->popVolNotifications();
+    const long volume = stol(dispatcher->exec(GET_VOL));
+
+    CU_ASSERT_EQUAL(dispatcher->exec("chg_vol 1;get_vol;chg_vol -2"), string(OK) + ";" + to_string(volume + 1) + ";" + OK);
+    CU_ASSERT_EQUAL(dispatcher->popVolNotifications().size(), 2);
+}
+
+void testOutOfRangeVolChange()
+{
+    dispatcher->popVolNotifications();
+    const string volume = dispatcher->exec(GET_VOL);
+
+    CU_ASSERT_EQUAL(dispatcher->exec("chg_vol 4294967297"), ERR);
+    CU_ASSERT_EQUAL(dispatcher->exec("chg_vol 99999999999999999999;get_vol"), string(ERR) + ";" + volume);
+    CU_ASSERT_EQUAL(dispatcher->popVolNotifications().size(), 0);
+}
+
+void testCachedVolume()
+{
+    const long volume = stol(dispatcher->exec(GET_VOL));
+    const int change = (volume < 50) ? 3: -3;
+
+    dispatcher->exec(string(CHG_VOL) + " " + to_string(change));
+    const string cachedVolume = dispatcher->cachedVol();
+    CU_ASSERT_EQUAL(cachedVolume, to_string(volume + change));
+    CU_ASSERT_EQUAL(cachedVolume, dispatcher->exec(GET_VOL));
+    dispatcher->popVolNotifications();
+}
+
+void testInvalidBatch()
+{
+    CU_ASSERT_EQUAL(dispatcher->exec(";;"), ERR);
+    CU_ASSERT_EQUAL(dispatcher->exec("chg_vol x;get_vol;;"), string(ERR) + ";" + dispatcher->exec(GET_VOL));
+}
+
+void testLongBatch()
+{
+    const string volume = dispatcher->exec(GET_VOL);
+    string batch = GET_VOL;
+    string results = volume;
+    while(batch.size() + 1 + strlen(GET_VOL) <= MAX_BATCH_LEN)
+    {
+	batch += string(";") + GET_VOL;
+	results += ";" + volume;
+    }
+    CU_ASSERT_EQUAL(dispatcher->exec(batch), results);
+    CU_ASSERT_EQUAL(dispatcher->exec(batch + ";" + GET_VOL), ERR);
+}
+
+/**
+ * Check the dumped span has the IDs of the traced request
+ * @param traceBuff The dumped traces
+ * @param name The name of the span
+ */
+void checkTracedRequest(const char *traceBuff, const string &name)
+{
+    const char *span = strstr(traceBuff, string("\"name\":\"" + name + "\"").c_str());
+    CU_ASSERT_PTR_NOT_NULL(span);
+    if(span == NULL)
+	return;
+    const char *ids = strstr(span, "\"args\":");
+    const string expected = "\"args\":{\"conn\":" + to_string(CLIENT_ID) + ",\"req\":" + to_string(REQUEST_ID) + "}";
+    CU_ASSERT( (ids != NULL) && (strncmp(ids, expected.c_str(), expected.size()) == 0) );
+}
+
+void testTracedRequest()
+{
+    clearTrace();
+    setTraceEnabled(true);
+    dispatcher->exec("chg_vol 1");
+    setTraceEnabled(false);
+
+    CU_ASSERT(dumpTrace(TRACE_FILE_NAME));
+    FILE *traceFile = fopen(TRACE_FILE_NAME, "r");
+    if(traceFile != NULL)
+	{
+	    char traceBuff[TRACE_BUFF_LEN] = {'\0'};
+	    CU_ASSERT(0 != fread(traceBuff, sizeof(char), TRACE_BUFF_LEN - 1, traceFile));
+	    checkTracedRequest(traceBuff, CHG_VOL);
+	    checkTracedRequest(traceBuff, "snd:chg_vol");
+	    fclose(traceFile);
+	}
+    else
+	{
+	    CU_FAIL("Can't open trace file");
+	}
+    remove(TRACE_FILE_NAME);
+}
+
+int main()
+{
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   CU_pSuite pSuite = CU_add_suite("Dispatcher", initSuite, cleanSuite);
+   if (NULL == pSuite)
+       {
+	   CU_cleanup_registry();
+	   return CU_get_error();
+       }
+
+   if (NULL == CU_add_test(pSuite, "coalesced volume changes ", testCoalescedVolChanges) ||
+       NULL == CU_add_test(pSuite, "separated volume changes ", testSeparatedVolChanges) ||
+       NULL == CU_add_test(pSuite, "out of range vol change  ", testOutOfRangeVolChange)  ||
+       NULL == CU_add_test(pSuite, "cached volume            ", testCachedVolume)         ||
+       NULL == CU_add_test(pSuite, "invalid batch            ", testInvalidBatch)         ||
+       NULL == CU_add_test(pSuite, "long batch               ", testLongBatch)            ||
+       NULL == CU_add_test(pSuite, "traced request's IDs     ", testTracedRequest))
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   CU_basic_set_mode(CU_BRM_VERBOSE);
+   CU_basic_run_tests();
+
+   CU_cleanup_registry();
+   return CU_get_error();
+}